@@ -40,9 +40,14 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 
 	case net::MessageWrapper::kS2CSyncStat:
 	{
-		// FIXME - not supported for now
-		// auto stats = GetStaticSymbols().GetStats();
-		// stats->SyncObjectFromServer(msg.s2c_sync_stat());
+		auto stats = GetStaticSymbols().GetStats();
+		stats->SyncObjectFromServer(msg.s2c_sync_stat());
+		break;
+	}
+
+	case net::MessageWrapper::kS2CSyncStats:
+	{
+		SyncStats(msg.s2c_sync_stats());
 		break;
 	}
 
@@ -54,7 +59,31 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 
 	case net::MessageWrapper::kUserVars:
 	{
-		SyncUserVars(msg.user_vars());
+		SyncUserVars(msg.user_vars(), context.UserID.GetPeerId());
+		break;
+	}
+
+	case net::MessageWrapper::kLuaBatch:
+	{
+		ecl::LuaClientPin pin(ecl::ExtensionState::Get());
+		if (pin) {
+			for (auto const& postMsg : msg.lua_batch().messages()) {
+				pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), ReservedUserId);
+			}
+		}
+		break;
+	}
+
+	case net::MessageWrapper::kLuaFragment:
+	{
+		STDString channel, payload;
+		auto& networkMgr = gExtender->GetClient().GetNetworkManager();
+		if (networkMgr.GetFragmentReader().OnFragment(context.UserID.GetPeerId(), msg.lua_fragment(), channel, payload)) {
+			ecl::LuaClientPin pin(ecl::ExtensionState::Get());
+			if (pin) {
+				pin->OnNetMessageReceived(channel, payload, ReservedUserId);
+			}
+		}
 		break;
 	}
 
@@ -63,9 +92,34 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 	}
 }
 
+void ExtenderProtocol::SyncStats(net::MsgS2CSyncStats const& msg)
+{
+	if (!msg.compressed_stats().empty()) {
+		std::string buf;
+		net::MsgS2CSyncStats decompressed;
+		if (!net::DecompressPayload(msg.compressed_stats(), msg.uncompressed_size(), buf)
+			|| !decompressed.ParseFromString(buf)) {
+			ERR("Failed to decompress stats sync message");
+			return;
+		}
+
+		SyncStats(decompressed);
+		return;
+	}
+
+	auto stats = GetStaticSymbols().GetStats();
+	for (auto const& stat : msg.stats()) {
+		stats->SyncObjectFromServer(stat);
+	}
+}
+
 void NetworkManager::Reset()
 {
 	extenderSupport_ = false;
+	hostVersion_ = 0;
+	fragmentWriter_.Clear();
+	fragmentReader_.Clear();
+	batcher_.Clear();
 }
 
 bool NetworkManager::CanSendExtenderMessages() const
@@ -118,6 +172,7 @@ void NetworkManager::OnExtenderHello(net::MsgC2SExtenderHello const& hello)
 {
 	DEBUG("Got extender support notification from host (version %d)", hello.version());
 	AllowExtenderMessages();
+	hostVersion_ = hello.version();
 
 	auto helloMsg = GetFreeMessage();
 	if (helloMsg != nullptr) {
@@ -155,4 +210,76 @@ void NetworkManager::Send(net::ExtenderMessage* msg)
 	}
 }
 
+void NetworkManager::PostLuaMessage(char const* channel, char const* payload, std::size_t size)
+{
+	if (size > net::LuaFragmentWriter::MaxUnfragmentedPayload) {
+		if (hostVersion_ < net::ExtenderMessage::VerLuaFragments) {
+			OsiError("Cannot send message on channel '" << channel << "': payload is " << size
+				<< " bytes and the server doesn't support fragmented messages");
+			return;
+		}
+
+		fragmentWriter_.Queue(net::LuaMessageTarget{}, channel, payload, size);
+		return;
+	}
+
+	// Fragmented messages are delivered when their last fragment arrives,
+	// so later messages are queued behind them to keep the posting order
+	if (fragmentWriter_.HasPendingMessagesFor(net::LuaMessageTarget{})) {
+		fragmentWriter_.Queue(net::LuaMessageTarget{}, channel, payload, size);
+		return;
+	}
+
+	bool canBatch = hostVersion_ >= net::ExtenderMessage::VerLuaBatches;
+	if (canBatch && batcher_.IsChannelBatched(FixedString(channel))) {
+		batcher_.Add(net::LuaMessageTarget{}, channel, payload, size);
+		return;
+	}
+
+	// Send batches posted earlier first to keep the message order;
+	// if some of them couldn't be sent, the message is queued behind them
+	FlushBatches();
+	if (canBatch && batcher_.HasPendingBatches()) {
+		batcher_.Add(net::LuaMessageTarget{}, channel, payload, size);
+		return;
+	}
+
+	auto msg = GetFreeMessage();
+	if (msg != nullptr) {
+		auto postMsg = msg->GetMessage().mutable_post_lua();
+		postMsg->set_channel_name(channel);
+		postMsg->set_payload(payload, size);
+		Send(msg);
+	} else {
+		OsiErrorS("Could not get free message!");
+	}
+}
+
+void NetworkManager::FlushBatches()
+{
+	while (batcher_.HasPendingBatches()) {
+		auto msg = GetFreeMessage();
+		if (msg == nullptr) break;
+
+		batcher_.PopBatch(*msg->GetMessage().mutable_lua_batch());
+		Send(msg);
+	}
+}
+
+void NetworkManager::Update()
+{
+	FlushBatches();
+	fragmentWriter_.BeginTick();
+
+	net::LuaMessageTarget target;
+	// Fragments queued after the remaining batches must not overtake them
+	while (!batcher_.HasPendingBatches() && fragmentWriter_.CanSendFragment()) {
+		auto msg = GetFreeMessage();
+		if (msg == nullptr) break;
+
+		fragmentWriter_.NextFragment(target, *msg->GetMessage().mutable_lua_fragment());
+		Send(msg);
+	}
+}
+
 END_NS()
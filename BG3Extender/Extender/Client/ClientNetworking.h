@@ -11,6 +11,9 @@ public:
 
 protected:
 	void ProcessExtenderMessage(net::MessageContext& context, net::MessageWrapper& msg) override;
+
+private:
+	void SyncStats(net::MsgS2CSyncStats const& msg);
 };
 
 class NetworkManager
@@ -20,20 +23,48 @@ public:
 
 	bool CanSendExtenderMessages() const;
 	void AllowExtenderMessages();
+
+	inline uint32_t GetHostVersion() const
+	{
+		return hostVersion_;
+	}
+
 	void ExtendNetworking();
 	net::ExtenderMessage* GetFreeMessage();
 	void Send(net::ExtenderMessage* msg);
 	void OnClientConnectMessage(net::ClientConnectMessage* msg);
 	void OnExtenderHello(net::MsgC2SExtenderHello const& hello);
 
+	// Sends a Lua message to the server.
+	// Messages on batched channels are sent at the end of the tick; messages that don't fit into
+	// a single network message are sent in fragments over the next ticks.
+	void PostLuaMessage(char const* channel, char const* payload, std::size_t size);
+	void Update();
+
+	inline net::LuaFragmentReader& GetFragmentReader()
+	{
+		return fragmentReader_;
+	}
+
+	inline net::LuaMessageBatcher& GetBatcher()
+	{
+		return batcher_;
+	}
+
 private:
 	ExtenderProtocol* protocol_{ nullptr };
+	net::LuaFragmentWriter fragmentWriter_;
+	net::LuaFragmentReader fragmentReader_;
+	net::LuaMessageBatcher batcher_;
 
 	// Indicates that the client can support extender messages to the server
 	// (i.e. the server supports the message ID and won't crash)
 	bool extenderSupport_{ false };
+	// Protocol version reported by the host
+	uint32_t hostVersion_{ 0 };
 
 	net::Client* GetClient() const;
+	void FlushBatches();
 };
 
 END_NS()
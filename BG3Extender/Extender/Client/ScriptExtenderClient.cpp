@@ -266,6 +266,8 @@ void ScriptExtender::OnUpdate(void* self, GameTime* time)
 			gExtender->GetLuaDebugger()->ClientTick();
 		}
 	}
+
+	network_.Update();
 }
 
 void ScriptExtender::OnIncLocalProgress(void* self, int progress, char const* state)
@@ -4,8 +4,11 @@
 #include "Version.h"
 #include "resource.h"
 #include <iomanip>
+#include <ShlObj.h>
 
 #include <Extender/Shared/StatLoadOrderHelper.inl>
+#include <Extender/Shared/StatSyncWriter.inl>
+#include <Extender/Shared/StatsIndex.inl>
 #include <Extender/Shared/UserVariables.inl>
 #include <Extender/Shared/VirtualTextures.inl>
 
@@ -195,6 +198,21 @@ std::wstring ScriptExtender::MakeLogFilePath(std::wstring const & Type, std::wst
 	return ss.str();
 }
 
+std::wstring ScriptExtender::GetLuaBytecodeCachePath()
+{
+	wchar_t appDataPath[MAX_PATH];
+	if (!SUCCEEDED(SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
+		return L"";
+	}
+
+	std::wstring cacheDir = std::wstring(appDataPath) + L"\\BG3ScriptExtender";
+	if (!TryCreateDirectory(cacheDir) || !TryCreateDirectory(cacheDir + L"\\LuaCache")) {
+		return L"";
+	}
+
+	return cacheDir + L"\\LuaCache";
+}
+
 void ScriptExtender::OnStatsLoad(stats::RPGStats::LoadProc* wrapped, stats::RPGStats* mgr, Array<STDString>* paths)
 {
 	// Stats load is scheduled from the client on the shared worker pool
@@ -207,12 +225,14 @@ void ScriptExtender::OnStatsLoad(stats::RPGStats::LoadProc* wrapped, stats::RPGS
 	}
 
 	statLoadOrderHelper_.OnLoadStarted();
+	statsIndex_.Invalidate();
 	client_.LoadExtensionState(ExtensionStateContext::Load);
 	virtualTextures_.Load();
 
 	wrapped(mgr, paths);
 
 	statLoadOrderHelper_.OnLoadFinished();
+	statsIndex_.Invalidate();
 	client_.LoadExtensionState(ExtensionStateContext::Game);
 
 	if (client_.HasExtensionState()) {
@@ -441,6 +461,10 @@ void ScriptExtender::PostStartup()
 			ERR("Failed to load Lua builtin resource bundle!");
 		}
 
+		if (config_.EnableLuaBytecodeCache) {
+			luaBytecodeCache_.SetCacheDirectory(GetLuaBytecodeCachePath());
+		}
+
 		engineHooks_.FileReader__ctor.SetWrapper(&ScriptExtender::OnFileReaderCreate, this);
 		engineHooks_.ls__VirtualTextureResource__Load.SetWrapper(&VirtualTextureHelpers::OnTextureLoad, &virtualTextures_);
 		engineHooks_.ls__VirtualTextureResource__Unload.SetWrapper(&VirtualTextureHelpers::OnTextureUnload, &virtualTextures_);
@@ -6,6 +6,7 @@
 #include <Extender/Client/ScriptExtenderClient.h>
 #include <Extender/Server/ScriptExtenderServer.h>
 #include <Extender/Shared/StatLoadOrderHelper.h>
+#include <Extender/Shared/StatsIndex.h>
 #include <Extender/Shared/VirtualTextures.h>
 #include <Extender/Shared/Hooks.h>
 #if !defined(OSI_NO_DEBUGGER)
@@ -13,6 +14,7 @@
 #include <Lua/Debugger/LuaDebugMessages.h>
 #endif
 #include <Lua/Shared/LuaBundle.h>
+#include <Lua/Shared/LuaBytecodeCache.h>
 #include <Lua/Shared/Proxies/LuaCppClass.h>
 #include <GameHooks/OsirisWrappers.h>
 #include <GameHooks/DataLibraries.h>
@@ -91,6 +93,11 @@ public:
 		return statLoadOrderHelper_;
 	}
 
+	inline stats::StatsIndex& GetStatsIndex()
+	{
+		return statsIndex_;
+	}
+
 	inline EngineHooks& GetEngineHooks()
 	{
 		return engineHooks_;
@@ -106,6 +113,11 @@ public:
 		return luaBuiltinBundle_;
 	}
 
+	inline lua::LuaBytecodeCache& GetLuaBytecodeCache()
+	{
+		return luaBytecodeCache_;
+	}
+
 	inline lua::CppPropertyMapManager& GetPropertyMapManager()
 	{
 		return propertyMapManager_;
@@ -136,7 +148,9 @@ private:
 	std::shared_mutex pathOverrideMutex_;
 	std::unordered_map<STDString, STDString> pathOverrides_;
 	stats::StatLoadOrderHelper statLoadOrderHelper_;
+	stats::StatsIndex statsIndex_;
 	lua::LuaBundle luaBuiltinBundle_;
+	lua::LuaBytecodeCache luaBytecodeCache_;
 	lua::CppPropertyMapManager propertyMapManager_;
 	VirtualTextureHelpers virtualTextures_;
 
@@ -151,6 +165,7 @@ private:
 	std::unique_ptr<lua::dbg::Debugger> luaDebugger_;
 #endif
 
+	std::wstring GetLuaBytecodeCachePath();
 	void OnCoreLibInit(void * self);
 	void OnAppUpdatePaths(void * self);
 	void OnAppLoadGraphicSettings(App* self);
@@ -137,6 +137,8 @@ void ScriptExtender::OnGameStateChanged(GameState fromState, GameState toState)
 
 	case GameState::LoadModule:
 		network_.ExtendNetworking();
+		// Stats are reloaded with the module, so previously synced entries are gone
+		statSyncWriter_.Clear();
 		break;
 
 	case GameState::LoadSession:
@@ -153,6 +155,11 @@ void ScriptExtender::OnGameStateChanged(GameState fromState, GameState toState)
 			extensionState_->GetLua()->OnLevelLoading();
 		}
 		break;
+
+	case GameState::Sync:
+		// Peers that are (re)loading the level have no baseline for delta syncs
+		statSyncWriter_.SyncAll();
+		break;
 	}
 
 	if (gExtender->WasInitialized() && !gExtender->GetLibraryManager().CriticalInitializationFailed()) {
@@ -188,6 +195,9 @@ void ScriptExtender::OnUpdate(void* self, GameTime* time)
 			gExtender->GetLuaDebugger()->ServerTick();
 		}
 	}
+
+	statSyncWriter_.Flush();
+	network_.Update();
 }
 
 bool ScriptExtender::IsInServerThread() const
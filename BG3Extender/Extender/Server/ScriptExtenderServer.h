@@ -12,6 +12,7 @@
 #include <CoreLib/Wrappers.h>
 #include <Extender/Shared/SavegameSerializer.h>
 #include <Extender/Server/ServerNetworking.h>
+#include <Extender/Shared/StatSyncWriter.h>
 
 #include <thread>
 #include <mutex>
@@ -55,6 +56,11 @@ public:
 		return network_;
 	}
 
+	inline stats::StatSyncWriter& GetStatSyncWriter()
+	{
+		return statSyncWriter_;
+	}
+
 	bool IsInServerThread() const;
 	void ResetLuaState();
 	bool RequestResetClientLuaState();
@@ -76,6 +82,8 @@ private:
 	ecs::ServerEntitySystemHelpers entityHelpers_;
 	SavegameSerializer savegameSerializer_;
 	NetworkManager network_;
+	// Survives extension state resets, as modified stats entries are kept until the stats are reloaded
+	stats::StatSyncWriter statSyncWriter_;
 
 	void OnBaseModuleLoaded(void * self);
 	void GameStateWorkerWrapper(void (* wrapped)(void*), void * self);
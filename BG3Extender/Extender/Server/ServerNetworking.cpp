@@ -37,7 +37,31 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 
 	case net::MessageWrapper::kUserVars:
 	{
-		SyncUserVars(msg.user_vars());
+		SyncUserVars(msg.user_vars(), context.UserID.GetPeerId());
+		break;
+	}
+
+	case net::MessageWrapper::kLuaBatch:
+	{
+		esv::LuaServerPin pin(esv::ExtensionState::Get());
+		if (pin) {
+			for (auto const& postMsg : msg.lua_batch().messages()) {
+				pin->OnNetMessageReceived(STDString(postMsg.channel_name()), STDString(postMsg.payload()), context.UserID);
+			}
+		}
+		break;
+	}
+
+	case net::MessageWrapper::kLuaFragment:
+	{
+		STDString channel, payload;
+		auto& networkMgr = gExtender->GetServer().GetNetworkManager();
+		if (networkMgr.GetFragmentReader().OnFragment(context.UserID.GetPeerId(), msg.lua_fragment(), channel, payload)) {
+			esv::LuaServerPin pin(esv::ExtensionState::Get());
+			if (pin) {
+				pin->OnNetMessageReceived(channel, payload, context.UserID);
+			}
+		}
 		break;
 	}
 
@@ -49,6 +73,9 @@ void ExtenderProtocol::ProcessExtenderMessage(net::MessageContext& context, net:
 void NetworkManager::Reset()
 {
 	peerVersions_.clear();
+	fragmentWriter_.Clear();
+	fragmentReader_.Clear();
+	batcher_.Clear();
 }
 
 bool NetworkManager::CanSendExtenderMessages(PeerId peerId) const
@@ -66,9 +93,44 @@ std::optional<uint32_t> NetworkManager::GetPeerVersion(PeerId peerId) const
 	}
 }
 
+bool NetworkManager::AllPeersSupport(uint32_t version) const
+{
+	auto server = GetServer();
+	if (server == nullptr) return false;
+
+	for (auto peerId : server->ConnectedPeerIds) {
+		auto it = peerVersions_.find(peerId);
+		if (it != peerVersions_.end() && it->second < version) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void NetworkManager::GetConnectedPeers(uint32_t version, Array<PeerId>& supported, Array<PeerId>& unsupported, bool excludeLocalPeer) const
+{
+	auto server = GetServer();
+	if (server == nullptr) return;
+
+	for (auto peerId : server->ConnectedPeerIds) {
+		auto it = peerVersions_.find(peerId);
+		if (it == peerVersions_.end() || (peerId == 1 && excludeLocalPeer)) continue;
+
+		if (it->second >= version) {
+			supported.push_back(peerId);
+		} else {
+			unsupported.push_back(peerId);
+		}
+	}
+}
+
 void NetworkManager::AllowExtenderMessages(PeerId peerId, uint32_t version)
 {
 	peerVersions_.insert_or_assign(peerId, version);
+	fragmentReader_.ClearPeer(peerId);
+	// The peer may have reconnected with the same ID, so it has no baseline for stat deltas
+	gExtender->GetServer().GetStatSyncWriter().ResyncPeer(peerId);
 }
 
 
@@ -187,4 +249,105 @@ void NetworkManager::BroadcastToConnectedPeers(net::ExtenderMessage* msg, UserId
 	server->SendMessageMultiPeerMoveIds(peerIds, msg, excludeUserId.Id);
 }
 
+void NetworkManager::SendToPeers(net::ExtenderMessage* msg, Array<PeerId> peerIds)
+{
+	auto server = GetServer();
+	if (server == nullptr) return;
+
+	server->SendMessageMultiPeerMoveIds(peerIds, msg, ReservedUserId.Id);
+}
+
+bool NetworkManager::TargetSupports(net::LuaMessageTarget const& target, uint32_t version) const
+{
+	if (target.Broadcast) {
+		return AllPeersSupport(version);
+	} else {
+		return GetPeerVersion(target.User.GetPeerId()).value_or(0) >= version;
+	}
+}
+
+void NetworkManager::SendToTarget(net::ExtenderMessage* msg, net::LuaMessageTarget const& target)
+{
+	if (target.Broadcast) {
+		Broadcast(msg, target.ExcludeUser);
+	} else {
+		Send(msg, target.User);
+	}
+}
+
+void NetworkManager::PostLuaMessage(net::LuaMessageTarget const& target, char const* channel, char const* payload, std::size_t size)
+{
+	if (size > net::LuaFragmentWriter::MaxUnfragmentedPayload) {
+		if (!TargetSupports(target, net::ExtenderMessage::VerLuaFragments)) {
+			OsiError("Cannot send message on channel '" << channel << "': payload is " << size
+				<< " bytes and the client doesn't support fragmented messages");
+			return;
+		}
+
+		fragmentWriter_.Queue(target, channel, payload, size);
+		return;
+	}
+
+	// Fragmented messages are delivered when their last fragment arrives,
+	// so later messages to the same recipients are queued behind them to keep the posting order
+	if (fragmentWriter_.HasPendingMessagesFor(target) && TargetSupports(target, net::ExtenderMessage::VerLuaFragments)) {
+		fragmentWriter_.Queue(target, channel, payload, size);
+		return;
+	}
+
+	bool canBatch = TargetSupports(target, net::ExtenderMessage::VerLuaBatches);
+	if (canBatch && batcher_.IsChannelBatched(FixedString(channel))) {
+		batcher_.Add(target, channel, payload, size);
+		return;
+	}
+
+	// Send batches posted earlier first to keep the message order;
+	// if some of them couldn't be sent, the message is queued behind them
+	FlushBatches();
+	if (canBatch && batcher_.HasPendingBatches()) {
+		batcher_.Add(target, channel, payload, size);
+		return;
+	}
+
+	auto msg = target.Broadcast ? GetFreeMessage(ReservedUserId) : GetFreeMessage(target.User);
+	if (msg != nullptr) {
+		auto postMsg = msg->GetMessage().mutable_post_lua();
+		postMsg->set_channel_name(channel);
+		postMsg->set_payload(payload, size);
+		SendToTarget(msg, target);
+	}
+}
+
+void NetworkManager::FlushBatches()
+{
+	while (batcher_.HasPendingBatches()) {
+		auto msg = GetFreeMessage();
+		if (msg == nullptr) break;
+
+		auto target = batcher_.PopBatch(*msg->GetMessage().mutable_lua_batch());
+		SendToTarget(msg, target);
+	}
+}
+
+void NetworkManager::Update()
+{
+	auto server = GetServer();
+	if (server != nullptr) {
+		fragmentReader_.DropDisconnectedPeers(server->ActivePeerIds);
+	}
+
+	FlushBatches();
+	fragmentWriter_.BeginTick();
+
+	net::LuaMessageTarget target;
+	// Fragments queued after the remaining batches must not overtake them
+	while (!batcher_.HasPendingBatches() && fragmentWriter_.CanSendFragment()) {
+		auto msg = GetFreeMessage();
+		if (msg == nullptr) break;
+
+		fragmentWriter_.NextFragment(target, *msg->GetMessage().mutable_lua_fragment());
+		SendToTarget(msg, target);
+	}
+}
+
 END_NS()
@@ -22,6 +22,10 @@ public:
 
 	bool CanSendExtenderMessages(PeerId peerId) const;
 	std::optional<uint32_t> GetPeerVersion(PeerId peerId) const;
+	// Checks whether all connected extender peers support the specified protocol version
+	bool AllPeersSupport(uint32_t version) const;
+	// Collects the connected extender peers, split by whether they support the specified protocol version
+	void GetConnectedPeers(uint32_t version, Array<PeerId>& supported, Array<PeerId>& unsupported, bool excludeLocalPeer = false) const;
 	void AllowExtenderMessages(PeerId peerId, uint32_t version);
 	void OnClientConnectMessage(net::MessageContext* context, net::ClientConnectMessage* msg);
 
@@ -34,11 +38,35 @@ public:
 	void Send(net::ExtenderMessage * msg, UserId userId);
 	void Broadcast(net::ExtenderMessage * msg, UserId excludeUserId, bool excludeLocalPeer = false);
 	void BroadcastToConnectedPeers(net::ExtenderMessage* msg, UserId excludeUserId, bool excludeLocalPeer = false);
+	void SendToPeers(net::ExtenderMessage* msg, Array<PeerId> peerIds);
+
+	// Sends a Lua message to the target peer(s).
+	// Messages on batched channels are sent at the end of the tick; messages that don't fit into
+	// a single network message are sent in fragments over the next ticks.
+	void PostLuaMessage(net::LuaMessageTarget const& target, char const* channel, char const* payload, std::size_t size);
+	void Update();
+
+	inline net::LuaFragmentReader& GetFragmentReader()
+	{
+		return fragmentReader_;
+	}
+
+	inline net::LuaMessageBatcher& GetBatcher()
+	{
+		return batcher_;
+	}
 
 private:
 	ExtenderProtocol * protocol_{ nullptr };
 	// List of clients that support the extender protocol
 	std::unordered_map<PeerId, uint32_t> peerVersions_;
+	net::LuaFragmentWriter fragmentWriter_;
+	net::LuaFragmentReader fragmentReader_;
+	net::LuaMessageBatcher batcher_;
+
+	bool TargetSupports(net::LuaMessageTarget const& target, uint32_t version) const;
+	void SendToTarget(net::ExtenderMessage* msg, net::LuaMessageTarget const& target);
+	void FlushBatches();
 };
 
 END_NS()
\ No newline at end of file
@@ -31,6 +31,8 @@ struct ExtenderConfig
 	bool DisableStoryMerge{ true };
 	bool DisableStoryPatching{ false };
 	bool DisableStoryCompilation{ true };
+	bool EnableSymbolCache{ true };
+	bool EnableLuaBytecodeCache{ true };
 
 #if defined(OSI_EXTENSION_BUILD)
 	bool DisableModValidation{ true };
@@ -1,5 +1,6 @@
 #include <stdafx.h>
 #include <Extender/Shared/ExtenderNet.h>
+#include <compressapi.h>
 
 BEGIN_NS(net)
 
@@ -58,6 +59,319 @@ Message* MessagePool::GetFreeMessage()
 }
 
 
+bool CompressPayload(void const* buf, std::size_t size, std::string& compressed)
+{
+	COMPRESSOR_HANDLE compressor;
+	if (!CreateCompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &compressor)) {
+		ERR("CreateCompressor() failed: %d", GetLastError());
+		return false;
+	}
+
+	SIZE_T compressedSize{ 0 };
+	compressed.resize(size);
+	auto ok = Compress(compressor, buf, size, compressed.data(), compressed.size(), &compressedSize);
+	CloseCompressor(compressor);
+
+	// Compress() fails with ERROR_INSUFFICIENT_BUFFER if the output wouldn't be smaller than the input
+	if (!ok || compressedSize >= size) {
+		return false;
+	}
+
+	compressed.resize(compressedSize);
+	return true;
+}
+
+bool DecompressPayload(std::string const& compressed, std::size_t uncompressedSize, std::string& buf)
+{
+	if (uncompressedSize > ExtenderMessage::MaxDecompressedPayloadLength) {
+		ERR("Compressed payload too large (%zu bytes)", uncompressedSize);
+		return false;
+	}
+
+	DECOMPRESSOR_HANDLE decompressor;
+	if (!CreateDecompressor(COMPRESS_ALGORITHM_XPRESS_HUFF, nullptr, &decompressor)) {
+		ERR("CreateDecompressor() failed: %d", GetLastError());
+		return false;
+	}
+
+	SIZE_T decompressedSize{ 0 };
+	buf.resize(uncompressedSize);
+	auto ok = Decompress(decompressor, compressed.data(), compressed.size(), buf.data(), buf.size(), &decompressedSize);
+	CloseDecompressor(decompressor);
+
+	if (!ok || decompressedSize != uncompressedSize) {
+		ERR("Failed to decompress payload: %d", GetLastError());
+		return false;
+	}
+
+	return true;
+}
+
+
+void LuaMessageBatcher::SetChannelBatched(FixedString const& channel, bool batched)
+{
+	if (batched) {
+		batchedChannels_.insert(channel);
+	} else {
+		batchedChannels_.erase(channel);
+	}
+}
+
+bool LuaMessageBatcher::IsChannelBatched(FixedString const& channel) const
+{
+	return batchedChannels_.find(channel) != batchedChannels_.end();
+}
+
+void LuaMessageBatcher::Add(LuaMessageTarget const& target, char const* channel, char const* payload, std::size_t size)
+{
+	stats_.BatchedMessages++;
+	auto channelSize = strlen(channel);
+	auto messageSize = channelSize + size + 16;
+
+	for (auto it = batches_.rbegin(); it != batches_.rend(); ++it) {
+		auto const& batchTarget = it->Target;
+		bool sameTarget = batchTarget.Broadcast
+			? (target.Broadcast && batchTarget.ExcludeUser == target.ExcludeUser)
+			: (!target.Broadcast && batchTarget.User == target.User);
+
+		if (sameTarget) {
+			if (it->Size + messageSize <= MaxBatchSize) {
+				it->Messages.push_back(PendingMessage{ STDString(channel, channelSize), STDString(payload, size) });
+				it->Size += messageSize;
+				return;
+			}
+			break;
+		}
+
+		// Broadcasts may reach the same peer, so we can't move the message before them
+		if (batchTarget.Broadcast || target.Broadcast) {
+			break;
+		}
+	}
+
+	PendingBatch batch{ .Target = target, .Size = messageSize };
+	batch.Messages.push_back(PendingMessage{ STDString(channel, channelSize), STDString(payload, size) });
+	batches_.push_back(std::move(batch));
+}
+
+LuaMessageTarget LuaMessageBatcher::PopBatch(MsgLuaBatch& batch)
+{
+	auto& pending = batches_.front();
+	for (auto const& msg : pending.Messages) {
+		auto postMsg = batch.add_messages();
+		postMsg->set_channel_name(msg.Channel.data(), msg.Channel.size());
+		postMsg->set_payload(msg.Payload.data(), msg.Payload.size());
+	}
+
+	stats_.SentBatches++;
+	stats_.MessagesSaved += pending.Messages.size() - 1;
+
+	auto target = pending.Target;
+	batches_.pop_front();
+	return target;
+}
+
+void LuaMessageBatcher::Clear()
+{
+	batches_.clear();
+	batchedChannels_.clear();
+}
+
+
+bool LuaFragmentWriter::Queue(LuaMessageTarget const& target, char const* channel, char const* payload, std::size_t size)
+{
+	if (size > ExtenderMessage::MaxDecompressedPayloadLength) {
+		ERR("Lua message payload too large (%zu bytes), max size is %zu", size, (std::size_t)ExtenderMessage::MaxDecompressedPayloadLength);
+		return false;
+	}
+
+	PendingMessage msg{
+		.Target = target,
+		.MessageId = nextMessageId_++,
+		.Channel = channel
+	};
+
+	if (CompressPayload(payload, size, msg.Data)) {
+		msg.UncompressedSize = (uint32_t)size;
+	} else {
+		msg.Data.assign(payload, size);
+		msg.UncompressedSize = 0;
+	}
+
+	if (queuedBytes_ + msg.Data.size() > MaxQueuedBytes) {
+		ERR("Lua message send queue is full; message on channel '%s' dropped", channel);
+		return false;
+	}
+
+	msg.NumFragments = (uint32_t)((msg.Data.size() + FragmentSize - 1) / FragmentSize);
+	queuedBytes_ += msg.Data.size();
+	queue_.push_back(std::move(msg));
+	return true;
+}
+
+bool LuaFragmentWriter::HasPendingMessagesFor(LuaMessageTarget const& target) const
+{
+	for (auto const& msg : queue_) {
+		auto const& queued = msg.Target;
+		if (queued.Broadcast && target.Broadcast) return true;
+		if (!queued.Broadcast && !target.Broadcast && queued.User == target.User) return true;
+
+		// Broadcasts reach every peer except the excluded one
+		if (queued.Broadcast && !target.Broadcast && queued.ExcludeUser != target.User) return true;
+		if (!queued.Broadcast && target.Broadcast && target.ExcludeUser != queued.User) return true;
+	}
+
+	return false;
+}
+
+bool LuaFragmentWriter::NextFragment(LuaMessageTarget& target, MsgLuaFragment& fragment)
+{
+	if (queue_.empty() || tickBudget_ == 0) {
+		return false;
+	}
+
+	auto& msg = queue_.front();
+	auto offset = msg.NextFragment * FragmentSize;
+	auto size = std::min(FragmentSize, msg.Data.size() - offset);
+
+	target = msg.Target;
+	fragment.set_message_id(msg.MessageId);
+	fragment.set_fragment_index(msg.NextFragment);
+	fragment.set_num_fragments(msg.NumFragments);
+	if (msg.NextFragment == 0) {
+		fragment.set_channel_name(msg.Channel.data(), msg.Channel.size());
+		fragment.set_payload_size((uint32_t)msg.Data.size());
+		fragment.set_uncompressed_size(msg.UncompressedSize);
+	}
+	fragment.set_data(msg.Data.data() + offset, size);
+
+	tickBudget_ -= std::min(size, tickBudget_);
+	if (++msg.NextFragment == msg.NumFragments) {
+		queuedBytes_ -= msg.Data.size();
+		queue_.pop_front();
+	}
+
+	return true;
+}
+
+void LuaFragmentWriter::BeginTick()
+{
+	tickBudget_ = TickBudget;
+}
+
+void LuaFragmentWriter::Clear()
+{
+	queue_.clear();
+	queuedBytes_ = 0;
+}
+
+
+bool LuaFragmentReader::OnFragment(PeerId peer, MsgLuaFragment const& fragment, STDString& channel, STDString& payload)
+{
+	auto& peerMsgs = peers_[peer];
+	if (fragment.fragment_index() == 0) {
+		Drop(peerMsgs, fragment.message_id());
+
+		auto reservedBytes = (std::size_t)fragment.payload_size() + fragment.channel_name().size() + MessageOverhead;
+		if (fragment.num_fragments() == 0
+			|| peerMsgs.Messages.size() >= MaxPendingMessagesPerPeer
+			|| reservedBytes > MaxPendingBytesPerPeer - peerMsgs.PendingBytes
+			|| fragment.uncompressed_size() > ExtenderMessage::MaxDecompressedPayloadLength) {
+			ERR("Dropping fragmented Lua message on channel '%s' (%u bytes): reassembly buffer limit exceeded",
+				fragment.channel_name().c_str(), fragment.payload_size());
+			return false;
+		}
+
+		auto& msg = peerMsgs.Messages[fragment.message_id()];
+		msg.Channel = STDString(fragment.channel_name());
+		msg.PayloadSize = fragment.payload_size();
+		msg.UncompressedSize = fragment.uncompressed_size();
+		msg.NumFragments = fragment.num_fragments();
+		msg.ReservedBytes = reservedBytes;
+		msg.Data.reserve(msg.PayloadSize);
+		peerMsgs.PendingBytes += reservedBytes;
+	}
+
+	auto it = peerMsgs.Messages.find(fragment.message_id());
+	if (it == peerMsgs.Messages.end()) {
+		// Message was dropped when its first fragment was received
+		return false;
+	}
+
+	auto& msg = it->second;
+	if (fragment.fragment_index() != msg.NextFragment
+		|| msg.Data.size() + fragment.data().size() > msg.PayloadSize) {
+		ERR("Dropping fragmented Lua message on channel '%s': got unexpected fragment %u",
+			msg.Channel.c_str(), fragment.fragment_index());
+		Drop(peerMsgs, fragment.message_id());
+		return false;
+	}
+
+	msg.Data.append(fragment.data());
+	if (++msg.NextFragment < msg.NumFragments) {
+		return false;
+	}
+
+	bool ok = (msg.Data.size() == msg.PayloadSize);
+	if (ok) {
+		if (msg.UncompressedSize > 0) {
+			std::string buf;
+			ok = DecompressPayload(msg.Data, msg.UncompressedSize, buf);
+			payload = STDString(buf);
+		} else {
+			payload = STDString(msg.Data);
+		}
+	}
+
+	if (ok) {
+		channel = msg.Channel;
+	} else {
+		ERR("Failed to reassemble fragmented Lua message on channel '%s'", msg.Channel.c_str());
+	}
+
+	Drop(peerMsgs, fragment.message_id());
+	return ok;
+}
+
+void LuaFragmentReader::Drop(PeerMessages& messages, uint32_t messageId)
+{
+	auto it = messages.Messages.find(messageId);
+	if (it != messages.Messages.end()) {
+		messages.PendingBytes -= it->second.ReservedBytes;
+		messages.Messages.erase(it);
+	}
+}
+
+void LuaFragmentReader::ClearPeer(PeerId peer)
+{
+	peers_.erase(peer);
+}
+
+void LuaFragmentReader::DropDisconnectedPeers(Array<PeerId> const& activePeers)
+{
+	for (auto it = peers_.begin(); it != peers_.end(); ) {
+		bool active = false;
+		for (auto peerId : activePeers) {
+			if (peerId == it->first) {
+				active = true;
+				break;
+			}
+		}
+
+		if (active) {
+			++it;
+		} else {
+			it = peers_.erase(it);
+		}
+	}
+}
+
+void LuaFragmentReader::Clear()
+{
+	peers_.clear();
+}
+
+
 ExtenderProtocolBase::~ExtenderProtocolBase() {}
 
 ProtocolResult ExtenderProtocolBase::ProcessMsg(void * Unused, net::MessageContext * Context, net::Message * Msg)
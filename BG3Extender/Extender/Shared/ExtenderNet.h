@@ -2,6 +2,7 @@
 
 #include <GameDefinitions/Net.h>
 #include <Extender/Shared/ExtenderProtocol.pb.h>
+#include <deque>
 
 BEGIN_NS(net)
 
@@ -10,10 +11,22 @@ class ExtenderMessage : public Message
 public:
 	static constexpr NetMessage MessageId = NetMessage::NETMSG_SCRIPT_EXTENDER;
 	static constexpr uint32_t MaxPayloadLength = 0xfffff;
+	// Max size of compressed payloads after decompression
+	static constexpr uint32_t MaxDecompressedPayloadLength = 0x4000000;
 
 	static constexpr uint32_t VerInitial = 1;
+	// Added delta encoding and compression of user variable syncs
+	static constexpr uint32_t VerUserVarDelta = 2;
+	// Composite user variables are sent in binary format instead of JSON
+	static constexpr uint32_t VerBinaryUserVars = 3;
+	// Stats entries are synced using batched delta messages
+	static constexpr uint32_t VerStatSync = 4;
+	// Lua messages larger than the max payload length are sent in fragments
+	static constexpr uint32_t VerLuaFragments = 5;
+	// Lua messages on batched channels are packed into one message per tick
+	static constexpr uint32_t VerLuaBatches = 6;
 	// Version of protocol, increment each time the protobuf changes
-	static constexpr uint32_t ProtoVersion = VerInitial;
+	static constexpr uint32_t ProtoVersion = VerLuaBatches;
 
 	ExtenderMessage();
 	~ExtenderMessage() override;
@@ -47,6 +60,165 @@ private:
 };
 
 
+// Compresses a network payload using the Windows compression API (XPRESS Huffman).
+// Returns false if the payload couldn't be compressed or the compressed payload isn't smaller.
+bool CompressPayload(void const* buf, std::size_t size, std::string& compressed);
+bool DecompressPayload(std::string const& compressed, std::size_t uncompressedSize, std::string& buf);
+
+// Recipient of a Lua message sent from the server; ignored on the client
+struct LuaMessageTarget
+{
+	UserId User;
+	UserId ExcludeUser;
+	bool Broadcast{ false };
+};
+
+struct LuaMessageBatchStats
+{
+	// Number of messages that were posted on batched channels
+	uint64_t BatchedMessages{ 0 };
+	uint64_t SentBatches{ 0 };
+	// Number of network messages that weren't sent due to batching
+	uint64_t MessagesSaved{ 0 };
+};
+
+// Packs Lua messages posted on batched channels during a tick into one network message per recipient.
+// Posting order is kept for each peer: a message is only added to an earlier batch
+// if no batch that was started since then is sent to the same peer.
+class LuaMessageBatcher
+{
+public:
+	// Max (approximate) size of a single batch
+	static constexpr std::size_t MaxBatchSize = 0xF0000;
+
+	void SetChannelBatched(FixedString const& channel, bool batched);
+	bool IsChannelBatched(FixedString const& channel) const;
+	void Add(LuaMessageTarget const& target, char const* channel, char const* payload, std::size_t size);
+
+	inline bool HasPendingBatches() const
+	{
+		return !batches_.empty();
+	}
+
+	// Moves the oldest batch to the message and returns its recipient
+	LuaMessageTarget PopBatch(MsgLuaBatch& batch);
+	// Drops pending batches and the list of batched channels
+	void Clear();
+
+	inline LuaMessageBatchStats const& GetStats() const
+	{
+		return stats_;
+	}
+
+private:
+	struct PendingMessage
+	{
+		STDString Channel;
+		STDString Payload;
+	};
+
+	struct PendingBatch
+	{
+		LuaMessageTarget Target;
+		std::vector<PendingMessage> Messages;
+		std::size_t Size{ 0 };
+	};
+
+	std::unordered_set<FixedString> batchedChannels_;
+	std::deque<PendingBatch> batches_;
+	LuaMessageBatchStats stats_;
+};
+
+// Splits Lua messages that are too large for a single network message into fragments.
+// Fragments are sent over multiple ticks with a per-tick byte budget,
+// so bulk transfers don't delay other network messages.
+// Fragmented messages are delivered when the last fragment arrives; to keep the posting order,
+// smaller messages to a recipient that has queued fragments must be queued here as well.
+class LuaFragmentWriter
+{
+public:
+	// Payloads larger than this are sent in fragments
+	static constexpr std::size_t MaxUnfragmentedPayload = 0xF0000;
+	static constexpr std::size_t FragmentSize = 0x40000;
+	// Max number of fragment bytes sent per tick
+	static constexpr std::size_t TickBudget = 0x100000;
+	// Max total size of payloads waiting to be sent
+	static constexpr std::size_t MaxQueuedBytes = 0x10000000;
+
+	bool Queue(LuaMessageTarget const& target, char const* channel, char const* payload, std::size_t size);
+	// Checks whether a queued message may be delivered to any recipient of the target
+	bool HasPendingMessagesFor(LuaMessageTarget const& target) const;
+
+	inline bool CanSendFragment() const
+	{
+		return !queue_.empty() && tickBudget_ > 0;
+	}
+
+	// Fetches the next fragment to send; returns false if no fragments are queued or the tick budget was used up
+	bool NextFragment(LuaMessageTarget& target, MsgLuaFragment& fragment);
+	void BeginTick();
+	void Clear();
+
+private:
+	struct PendingMessage
+	{
+		LuaMessageTarget Target;
+		uint32_t MessageId;
+		STDString Channel;
+		std::string Data;
+		uint32_t UncompressedSize;
+		uint32_t NumFragments;
+		uint32_t NextFragment{ 0 };
+	};
+
+	std::deque<PendingMessage> queue_;
+	std::size_t queuedBytes_{ 0 };
+	std::size_t tickBudget_{ TickBudget };
+	uint32_t nextMessageId_{ 1 };
+};
+
+// Reassembles fragmented Lua messages received from peers
+class LuaFragmentReader
+{
+public:
+	// Max total size of partially received messages per peer
+	static constexpr std::size_t MaxPendingBytesPerPeer = 0x4000000;
+	// Max number of partially received messages per peer
+	static constexpr std::size_t MaxPendingMessagesPerPeer = 16;
+	// Bookkeeping cost of a partially received message, counted towards the per-peer size limit
+	static constexpr std::size_t MessageOverhead = 0x100;
+
+	// Appends a received fragment; returns true if the message is complete and the channel and payload were filled
+	bool OnFragment(PeerId peer, MsgLuaFragment const& fragment, STDString& channel, STDString& payload);
+	void ClearPeer(PeerId peer);
+	// Drops the partially received messages of peers that aren't in the list
+	void DropDisconnectedPeers(Array<PeerId> const& activePeers);
+	void Clear();
+
+private:
+	struct PendingMessage
+	{
+		STDString Channel;
+		std::string Data;
+		uint32_t PayloadSize;
+		uint32_t UncompressedSize;
+		uint32_t NumFragments;
+		uint32_t NextFragment{ 0 };
+		// Size counted towards the per-peer limit
+		std::size_t ReservedBytes{ 0 };
+	};
+
+	struct PeerMessages
+	{
+		std::unordered_map<uint32_t, PendingMessage> Messages;
+		std::size_t PendingBytes{ 0 };
+	};
+
+	std::unordered_map<PeerId, PeerMessages> peers_;
+
+	void Drop(PeerMessages& messages, uint32_t messageId);
+};
+
 class ExtenderProtocolBase : public Protocol
 {
 public:
@@ -59,7 +231,7 @@ public:
 	void OnRemovedFromHost() override;
 	void Reset() override;
 
-	void SyncUserVars(MsgUserVars const& msg);
+	void SyncUserVars(MsgUserVars const& msg, PeerId peer);
 
 protected:
 	virtual void ProcessExtenderMessage(net::MessageContext& context, MessageWrapper & msg) = 0;
@@ -156,21 +156,21 @@ void SavegameSerializer::RestoreStatObject(FixedString const& statId, FixedStrin
 		}
 		object = *newObject;
 	}
-	/*
+
 #if defined(NDEBUG)
-	MsgS2CSyncStat msg;
+	net::MsgS2CSyncStat msg;
 #else
 	// Workaround for different debug/release CRT runtimes between protobuf and the extender in debug mode
-	MsgS2CSyncStat& msg = *GameAlloc<MsgS2CSyncStat>();
+	net::MsgS2CSyncStat& msg = *GameAlloc<net::MsgS2CSyncStat>();
 #endif
-	if (!msg.ParseFromArray(blob.Buffer, blob.Size)) {
+	if (!msg.ParseFromArray(blob.Buffer, (int)blob.Size)) {
 		OsiError("Unable to parse protobuf payload for stat '" << statId << "'! It will not be loaded from the savegame!");
 		return;
 	}
 
 	object->FromProtobuf(msg);
-	stats->SyncWithPrototypeManager(object);*/
-	object->BroadcastSyncMessage(true);
+	stats->SyncWithPrototypeManager(object);
+	gExtender->GetServer().GetStatSyncWriter().Sync(statId);
 	gExtender->GetServer().GetExtensionState().MarkDynamicStat(statId);
 	gExtender->GetServer().GetExtensionState().MarkPersistentStat(statId);
 }
@@ -188,12 +188,12 @@ bool SavegameSerializer::SerializeStatObject(FixedString const& statId, FixedStr
 	auto modifier = stats->ModifierLists.Find(object->ModifierListIndex);
 	statType = modifier->Name;
 
-	/*MsgS2CSyncStat msg;
+	net::MsgS2CSyncStat msg;
 	object->ToProtobuf(&msg);
 	uint32_t size = (uint32_t)msg.ByteSizeLong();
 	blob.Size = size;
 	blob.Buffer = GameAllocRaw(size);
-	msg.SerializeToArray(blob.Buffer, size);*/
+	msg.SerializeToArray(blob.Buffer, size);
 	return true;
 }
 
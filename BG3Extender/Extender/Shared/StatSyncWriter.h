@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <GameDefinitions/Stats/Stats.h>
+#include <Extender/Shared/ExtenderNet.h>
+
+BEGIN_NS(stats)
+
+// Sends server-side changes of stats entries to clients.
+// Syncs requested during a tick are sent in a single batched message when the tick ends;
+// the last synced state of each entry is kept so only properties that changed since the previous sync are sent.
+// Peers that don't support batched syncs (pre-VerStatSync) get the full entry in a MsgS2CSyncStat instead.
+class StatSyncWriter
+{
+public:
+	// Queues a sync of the stats entry; the entry is sent on the next flush
+	void Sync(FixedString const& statId);
+	// Sends the full state of every entry that was synced before on the next flush
+	void SyncAll();
+	// Forgets that the peer has a sync baseline; it'll receive every synced entry on the next flush
+	void ResyncPeer(PeerId peerId);
+	void Flush();
+	void Clear();
+
+private:
+	// Max (approximate) size of sync message we're allowed to send
+	static constexpr size_t SyncMessageBudget = 300000;
+	// Sync messages larger than this are compressed
+	static constexpr size_t CompressionThreshold = 0x1000;
+
+	struct Snapshot
+	{
+		// Serialized value of each indexed property at the time of the last sync
+		std::vector<std::string> Properties;
+		FixedString AIFlags;
+		Array<Requirement> Requirements;
+		Array<FixedString> ComboCategories;
+	};
+
+	// Entries pending sync; the value indicates whether a full sync was requested
+	FlatHashMap<FixedString, bool> pending_;
+	std::unordered_map<FixedString, Snapshot> snapshots_;
+	// Peers that received the state of every entry in snapshots_, by sync path
+	Array<PeerId> deltaPeers_;
+	Array<PeerId> legacyPeers_;
+	net::ExtenderMessage* syncMsg_{ nullptr };
+	size_t syncMsgBudget_{ 0 };
+
+	void UpdatePeers();
+	bool SendLegacySync(Object* object);
+	void AppendToSyncMessage(Object* object, bool full);
+	bool ObjectFieldsChanged(Snapshot const& snapshot, Object* object) const;
+	bool MakeSyncMessage();
+	void CompressSyncMessage();
+	void SendSyncs();
+};
+
+END_NS()
@@ -0,0 +1,247 @@
+#include <Extender/Shared/StatSyncWriter.h>
+
+BEGIN_NS(stats)
+
+void StatSyncWriter::Sync(FixedString const& statId)
+{
+	if (!pending_.try_get(statId)) {
+		pending_.set(statId, false);
+	}
+}
+
+void StatSyncWriter::SyncAll()
+{
+	for (auto const& snapshot : snapshots_) {
+		pending_.set(snapshot.first, true);
+	}
+}
+
+void StatSyncWriter::ResyncPeer(PeerId peerId)
+{
+	for (uint32_t i = 0; i < deltaPeers_.size(); i++) {
+		if (deltaPeers_[i] == peerId) {
+			deltaPeers_.remove_at(i);
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < legacyPeers_.size(); i++) {
+		if (legacyPeers_[i] == peerId) {
+			legacyPeers_.remove_at(i);
+			break;
+		}
+	}
+}
+
+void StatSyncWriter::UpdatePeers()
+{
+	Array<PeerId> deltaPeers, legacyPeers;
+	// The local client shares the stats of the server, so it doesn't need to be synced
+	gExtender->GetServer().GetNetworkManager().GetConnectedPeers(net::ExtenderMessage::VerStatSync, deltaPeers, legacyPeers, true);
+
+	auto isKnown = [](Array<PeerId> const& known, PeerId peerId) {
+		for (auto knownPeerId : known) {
+			if (knownPeerId == peerId) return true;
+		}
+
+		return false;
+	};
+
+	// Deltas are relative to the last state sent to the peers, so peers that just joined need every entry in full
+	bool hasNewPeers = false;
+	for (auto peerId : deltaPeers) {
+		hasNewPeers = hasNewPeers || !isKnown(deltaPeers_, peerId);
+	}
+
+	for (auto peerId : legacyPeers) {
+		hasNewPeers = hasNewPeers || !isKnown(legacyPeers_, peerId);
+	}
+
+	if (hasNewPeers) {
+		SyncAll();
+	}
+
+	deltaPeers_ = std::move(deltaPeers);
+	legacyPeers_ = std::move(legacyPeers);
+}
+
+void StatSyncWriter::Flush()
+{
+	UpdatePeers();
+	if (pending_.size() == 0) return;
+
+	auto stats = GetStaticSymbols().GetStats();
+	auto const& statIds = pending_.keys();
+	auto const& fullSyncs = pending_.values();
+	uint32_t processed = 0;
+	for (; processed < statIds.size(); processed++) {
+		auto object = stats->Objects.Find(statIds[processed]);
+		if (!object) {
+			OsiError("Stat entry '" << statIds[processed] << "' was queued for sync but cannot be found! It will not be synced to the client!");
+			continue;
+		}
+
+		// Make sure the entry can be sent before its snapshot is updated
+		if (!deltaPeers_.empty() && !MakeSyncMessage()) break;
+		if (!SendLegacySync(object)) break;
+
+		if (deltaPeers_.empty()) {
+			// No baseline was sent; keep the entry so peers that connect later receive it in full
+			snapshots_[object->Name].Properties.clear();
+			continue;
+		}
+
+		AppendToSyncMessage(object, fullSyncs[processed]);
+		if (syncMsgBudget_ >= SyncMessageBudget) {
+			SendSyncs();
+		}
+	}
+
+	SendSyncs();
+
+	if (processed == statIds.size()) {
+		pending_.clear();
+	} else {
+		// Entries that couldn't be sent stay pending until the next flush
+		Array<FixedString> sent;
+		for (uint32_t i = 0; i < processed; i++) {
+			sent.push_back(statIds[i]);
+		}
+
+		for (auto const& statId : sent) {
+			pending_.remove(statId);
+		}
+	}
+}
+
+void StatSyncWriter::Clear()
+{
+	pending_.clear();
+	snapshots_.clear();
+	deltaPeers_.clear();
+	legacyPeers_.clear();
+}
+
+bool StatSyncWriter::SendLegacySync(Object* object)
+{
+	if (legacyPeers_.empty()) return true;
+
+	auto& networkMgr = gExtender->GetServer().GetNetworkManager();
+	auto msg = networkMgr.GetFreeMessage();
+	if (msg == nullptr) return false;
+
+	object->ToProtobuf(msg->GetMessage().mutable_s2c_sync_stat());
+	networkMgr.SendToPeers(msg, legacyPeers_);
+	return true;
+}
+
+void StatSyncWriter::AppendToSyncMessage(Object* object, bool full)
+{
+	auto& snapshot = snapshots_[object->Name];
+	// The client has no baseline for entries that weren't synced before
+	if (snapshot.Properties.size() != object->IndexedProperties.size()) {
+		full = true;
+		snapshot.Properties.clear();
+		snapshot.Properties.resize(object->IndexedProperties.size());
+	}
+
+	auto& batch = *syncMsg_->GetMessage().mutable_s2c_sync_stats();
+	auto msg = batch.add_stats();
+	msg->set_name(object->Name.GetString());
+	msg->set_modifier_list(object->ModifierListIndex);
+	msg->set_full(full);
+
+	std::string value;
+	for (uint32_t i = 0; i < object->IndexedProperties.size(); i++) {
+		auto prop = msg->add_indexed_properties();
+		object->IndexedPropertyToProtobuf(i, prop);
+		prop->SerializeToString(&value);
+		if (!full && value == snapshot.Properties[i]) {
+			msg->mutable_indexed_properties()->RemoveLast();
+		} else {
+			snapshot.Properties[i] = std::move(value);
+		}
+	}
+
+	if (full || ObjectFieldsChanged(snapshot, object)) {
+		object->ObjectFieldsToProtobuf(msg);
+		snapshot.AIFlags = object->AIFlags;
+		snapshot.Requirements = object->Requirements;
+		snapshot.ComboCategories = object->ComboCategories;
+	}
+
+	if (!full && msg->indexed_properties_size() == 0 && !msg->has_object_fields()) {
+		batch.mutable_stats()->RemoveLast();
+	} else {
+		syncMsgBudget_ += msg->ByteSizeLong();
+	}
+}
+
+bool StatSyncWriter::ObjectFieldsChanged(Snapshot const& snapshot, Object* object) const
+{
+	if (snapshot.AIFlags != object->AIFlags
+		|| snapshot.Requirements.size() != object->Requirements.size()
+		|| snapshot.ComboCategories.size() != object->ComboCategories.size()) {
+		return true;
+	}
+
+	for (uint32_t i = 0; i < object->Requirements.size(); i++) {
+		auto const& cur = object->Requirements[i];
+		auto const& prev = snapshot.Requirements[i];
+		if (cur.RequirementId != prev.RequirementId
+			|| cur.IntParam != prev.IntParam
+			|| cur.TagParam != prev.TagParam
+			|| cur.Not != prev.Not) {
+			return true;
+		}
+	}
+
+	for (uint32_t i = 0; i < object->ComboCategories.size(); i++) {
+		if (object->ComboCategories[i] != snapshot.ComboCategories[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool StatSyncWriter::MakeSyncMessage()
+{
+	if (syncMsg_ == nullptr) {
+		syncMsg_ = gExtender->GetServer().GetNetworkManager().GetFreeMessage();
+		if (syncMsg_) {
+			syncMsg_->GetMessage().mutable_s2c_sync_stats();
+		}
+	}
+
+	return syncMsg_ != nullptr;
+}
+
+void StatSyncWriter::CompressSyncMessage()
+{
+	auto& batch = *syncMsg_->GetMessage().mutable_s2c_sync_stats();
+	std::string buf;
+	batch.SerializeToString(&buf);
+
+	std::string compressed;
+	if (net::CompressPayload(buf.data(), buf.size(), compressed)) {
+		batch.clear_stats();
+		batch.set_compressed_stats(std::move(compressed));
+		batch.set_uncompressed_size((uint32_t)buf.size());
+	}
+}
+
+void StatSyncWriter::SendSyncs()
+{
+	if (syncMsg_ && syncMsg_->GetMessage().s2c_sync_stats().stats_size() > 0) {
+		if (syncMsgBudget_ > CompressionThreshold) {
+			CompressSyncMessage();
+		}
+
+		gExtender->GetServer().GetNetworkManager().SendToPeers(syncMsg_, deltaPeers_);
+		syncMsg_ = nullptr;
+		syncMsgBudget_ = 0;
+	}
+}
+
+END_NS()
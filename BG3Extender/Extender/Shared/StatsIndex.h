@@ -0,0 +1,44 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <GameDefinitions/Stats/Stats.h>
+#include <shared_mutex>
+
+BEGIN_NS(stats)
+
+// Lookup tables for stats data that the engine only indexes in one direction
+// (enumeration label -> value) or not at all (stats objects by modifier list).
+// Tables are built on first use and rebuilt when the stats were reloaded or modified through the extender;
+// changes made by the engine are detected by comparing element counts.
+class StatsIndex
+{
+public:
+	void Invalidate();
+	void OnObjectCreated(Object* object);
+	void OnEnumerationValueAdded(RPGEnumeration* enumeration);
+
+	// Returns the first label with the specified value, in the same order as Map::find_by_value()
+	FixedString EnumIndexToLabel(RPGEnumeration* enumeration, int32_t value);
+	// Returns the names of all objects of the specified modifier list, in creation order
+	Array<FixedString> GetObjectNames(RPGStats* stats, int32_t modifierListIndex);
+
+private:
+	struct EnumerationLabels
+	{
+		FlatHashMap<int32_t, FixedString> Labels;
+		uint32_t NumValues{ 0 };
+	};
+
+	std::shared_mutex mutex_;
+	std::unordered_map<RPGEnumeration const*, EnumerationLabels> enumLabels_;
+	// Objects indexed by modifier list index
+	Array<Array<Object*>> objectsByType_;
+	RPGStats* objectsStats_{ nullptr };
+	uint32_t numIndexedObjects_{ 0 };
+
+	void BuildEnumeration(RPGEnumeration* enumeration, EnumerationLabels& labels);
+	void BuildObjectIndex(RPGStats* stats);
+	bool IsObjectIndexValid(RPGStats* stats) const;
+};
+
+END_NS()
@@ -0,0 +1,119 @@
+#include <Extender/Shared/StatsIndex.h>
+
+BEGIN_NS(stats)
+
+void StatsIndex::Invalidate()
+{
+	std::unique_lock _(mutex_);
+	enumLabels_.clear();
+	objectsByType_.clear();
+	objectsStats_ = nullptr;
+	numIndexedObjects_ = 0;
+}
+
+void StatsIndex::OnObjectCreated(Object* object)
+{
+	std::unique_lock _(mutex_);
+	auto stats = GetStaticSymbols().GetStats();
+	// Only update incrementally if the index was up to date before the object was added
+	if (objectsStats_ == stats && numIndexedObjects_ + 1 == stats->Objects.Primitives.Size()
+		&& object->ModifierListIndex >= 0 && (uint32_t)object->ModifierListIndex < objectsByType_.Size()) {
+		objectsByType_[object->ModifierListIndex].push_back(object);
+		numIndexedObjects_++;
+	} else {
+		objectsStats_ = nullptr;
+	}
+}
+
+void StatsIndex::OnEnumerationValueAdded(RPGEnumeration* enumeration)
+{
+	std::unique_lock _(mutex_);
+	enumLabels_.erase(enumeration);
+}
+
+void StatsIndex::BuildEnumeration(RPGEnumeration* enumeration, EnumerationLabels& labels)
+{
+	labels.Labels.clear();
+	for (auto const& value : enumeration->Values) {
+		// Keep the first label if multiple labels have the same value
+		if (labels.Labels.try_get(value.Value) == nullptr) {
+			labels.Labels.set(value.Value, value.Key);
+		}
+	}
+
+	labels.NumValues = enumeration->Values.size();
+}
+
+FixedString StatsIndex::EnumIndexToLabel(RPGEnumeration* enumeration, int32_t value)
+{
+	{
+		std::shared_lock _(mutex_);
+		auto labels = enumLabels_.find(enumeration);
+		if (labels != enumLabels_.end() && labels->second.NumValues == enumeration->Values.size()) {
+			auto label = labels->second.Labels.try_get(value);
+			return label ? *label : FixedString{};
+		}
+	}
+
+	std::unique_lock _(mutex_);
+	auto& labels = enumLabels_[enumeration];
+	if (labels.NumValues != enumeration->Values.size()) {
+		BuildEnumeration(enumeration, labels);
+	}
+
+	auto label = labels.Labels.try_get(value);
+	return label ? *label : FixedString{};
+}
+
+bool StatsIndex::IsObjectIndexValid(RPGStats* stats) const
+{
+	return objectsStats_ == stats 
+		&& numIndexedObjects_ == stats->Objects.Primitives.Size()
+		&& objectsByType_.Size() == stats->ModifierLists.Primitives.Size();
+}
+
+void StatsIndex::BuildObjectIndex(RPGStats* stats)
+{
+	objectsByType_.clear();
+	objectsByType_.resize(stats->ModifierLists.Primitives.Size());
+
+	for (auto object : stats->Objects.Primitives) {
+		if (object->ModifierListIndex >= 0 && (uint32_t)object->ModifierListIndex < objectsByType_.Size()) {
+			objectsByType_[object->ModifierListIndex].push_back(object);
+		}
+	}
+
+	objectsStats_ = stats;
+	numIndexedObjects_ = stats->Objects.Primitives.Size();
+}
+
+Array<FixedString> StatsIndex::GetObjectNames(RPGStats* stats, int32_t modifierListIndex)
+{
+	Array<FixedString> names;
+	auto collect = [this, &names, modifierListIndex]() {
+		if (modifierListIndex >= 0 && (uint32_t)modifierListIndex < objectsByType_.Size()) {
+			auto const& objects = objectsByType_[modifierListIndex];
+			for (auto object : objects) {
+				names.push_back(object->Name);
+			}
+		}
+	};
+
+	{
+		std::shared_lock _(mutex_);
+		if (IsObjectIndexValid(stats)) {
+			collect();
+			return names;
+		}
+	}
+
+	std::unique_lock _(mutex_);
+	if (!IsObjectIndexValid(stats)) {
+		BuildObjectIndex(stats);
+	}
+
+	collect();
+	return names;
+}
+
+END_NS()
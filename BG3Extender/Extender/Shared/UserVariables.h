@@ -24,7 +24,8 @@ struct UserVariable
 
 	void SavegameVisit(ObjectVisitor* visitor);
 	void ToNetMessage(net::UserVar& var) const;
-	void FromNetMessage(net::UserVar const& var);
+	// Returns false if the message contains a delta that can't be applied to the current value
+	bool FromNetMessage(net::UserVar const& var, UserVariable const* current);
 	size_t Budget() const;
 
 	UserVariableType Type{ UserVariableType::Null };
@@ -32,6 +33,7 @@ struct UserVariable
 	int64_t Int{ 0ll };
 	double Dbl{ 0.0 };
 	FixedString Str;
+	// Lua value in binary format (see lua::binary); may also be JSON for values restored from older savegames
 	STDString CompositeStr;
 };
 
@@ -46,7 +48,8 @@ enum class UserVariableFlags
 	WriteableOnServer = 1 << 6,
 	WriteableOnClient = 1 << 7,
 	SyncOnTick = 1 << 8,
-	Persistent = 1 << 9
+	Persistent = 1 << 9,
+	DeltaSync = 1 << 10
 };
 
 template<> struct IsBitmask<UserVariableFlags>
@@ -93,6 +96,41 @@ enum class UserVarClass
 	ModuleVar
 };
 
+struct UserVariableSyncKey
+{
+	Guid Entity;
+	FixedString Variable;
+
+	inline bool operator == (UserVariableSyncKey const& o) const
+	{
+		return Entity == o.Entity && Variable == o.Variable;
+	}
+};
+
+inline uint64_t Hash(UserVariableSyncKey const& k)
+{
+	return Hash(k.Entity) ^ (Hash(k.Variable) * 0x9e3779b97f4a7c15ull);
+}
+
+struct UserVariableSyncStats
+{
+	// Number of distinct variables that were queued for sync
+	uint64_t QueuedSyncs{ 0 };
+	// Number of writes that were merged into an already queued sync of the same variable
+	uint64_t CoalescedWrites{ 0 };
+	// Estimated size of values that didn't need to be serialized due to coalescing
+	uint64_t BytesSaved{ 0 };
+	uint64_t SentVariables{ 0 };
+	uint64_t SentBytes{ 0 };
+	// Number of composite values that were sent as a delta of the previously sent value
+	uint64_t DeltaSyncs{ 0 };
+	uint64_t DeltaBytesSaved{ 0 };
+	uint64_t CompressedMessages{ 0 };
+	uint64_t CompressionBytesSaved{ 0 };
+	// Number of deltas that couldn't be applied and required a full resync
+	uint64_t FullSyncRequests{ 0 };
+};
+
 class UserVariableSyncWriter
 {
 public:
@@ -104,28 +142,71 @@ public:
 	void Clear();
 	void Sync(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable const* value);
 	void DeferredSync(Guid const& entity, FixedString const& key);
+	// Sends the full value of the variable on the next flush, without delta encoding
+	void FullSync(Guid const& entity, FixedString const& key);
+	// Asks the peer to resend the full value of the variable
+	void RequestFullSync(Guid const& entity, FixedString const& key);
+	// Resends the value of the variable to a single peer that couldn't apply a delta (server only).
+	// The peer gets the delta baseline, so it can apply the same deltas as the other peers afterwards.
+	void ResyncPeer(Guid const& entity, FixedString const& key, PeerId peer);
+
+	inline UserVariableSyncStats const& GetStats() const
+	{
+		return stats_;
+	}
 
 private:
 	// Max (approximate) size of sync message we're allowed to send
 	static constexpr size_t SyncMessageBudget = 300000;
+	// Sync messages larger than this are compressed
+	static constexpr size_t CompressionThreshold = 0x1000;
 
-	struct SyncRequest
+	struct PendingSync
 	{
-		Guid Entity;
-		FixedString Variable;
+		// Number of writes since the variable was queued
+		uint32_t Writes{ 0 };
+		bool AllowDelta{ false };
+		bool ForceFull{ false };
+	};
+
+	// Set of variables pending sync
+	using SyncQueue = FlatHashMap<UserVariableSyncKey, PendingSync>;
+
+	struct PeerResync
+	{
+		PeerId Peer;
+		UserVariableSyncKey Key;
 	};
 
 	UserVariableInterface* vars_;
-	Array<SyncRequest> deferredSyncs_;
-	Array<SyncRequest> nextTickSyncs_;
+	SyncQueue deferredSyncs_;
+	SyncQueue nextTickSyncs_;
+	// Last composite value broadcast for variables that use delta sync
+	FlatHashMap<UserVariableSyncKey, STDString> deltaBaselines_;
+	// Variables to resend to peers that are missing the delta baseline
+	Array<PeerResync> peerResyncs_;
+	UserVariableSyncStats stats_;
+	// Whether the peer(s) support delta encoding and compression of sync messages
+	bool peerSupportsDelta_{ false };
+	// Whether the peer(s) can read binary composite values; older peers are sent JSON instead
+	bool peerSupportsBinary_{ false };
 	net::ExtenderMessage* syncMsg_{ nullptr };
 	size_t syncMsgBudget_{ 0 };
+	// Peer the current sync message is sent to; the message is broadcast if not set
+	std::optional<PeerId> targetPeer_;
 	bool isServer_;
 	UserVarClass varClass_;
 
-	void AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value);
-	void FlushSyncQueue(Array<SyncRequest>& queue);
+	void QueueSync(SyncQueue& queue, Guid const& entity, FixedString const& key, UserVariable const* value, bool allowDelta, bool forceFull);
+	net::UserVar* AddSyncMessageVar(Guid const& entity, FixedString const& key);
+	UserVariable const* GetPeerValue(FixedString const& key, UserVariable const& variable, UserVariable& legacyValue);
+	bool AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& variable, bool allowDelta, bool forceFull);
+	bool AppendDelta(net::UserVar& var, STDString const& baseline, STDString const& value);
+	void CompressSyncMessage();
+	void FlushSyncQueue(SyncQueue& queue);
+	void SendPeerResyncs();
 	bool MakeSyncMessage();
+	void UpdatePeerSupport();
 	void SendSyncs();
 };
 
@@ -163,7 +244,12 @@ public:
 	void Update();
 	void Flush(bool force);
 	void SavegameVisit(ObjectVisitor* visitor);
-	void NetworkSync(net::UserVar const& var);
+	void NetworkSync(net::UserVar const& var, PeerId peer);
+
+	inline UserVariableSyncStats const& GetSyncStats() const
+	{
+		return sync_.GetStats();
+	}
 
 private:
 	MultiHashMap<Guid, EntityVariables> vars_;
@@ -233,7 +319,12 @@ public:
 	void Update();
 	void Flush(bool force);
 	void SavegameVisit(ObjectVisitor* visitor);
-	void NetworkSync(net::UserVar const& var);
+	void NetworkSync(net::UserVar const& var, PeerId peer);
+
+	inline UserVariableSyncStats const& GetSyncStats() const
+	{
+		return sync_.GetStats();
+	}
 
 private:
 	MultiHashMap<Guid, uint32_t> modIndices_;
@@ -278,8 +369,9 @@ struct CachedUserVariable
 	void Push(lua_State* L) const;
 	bool LikelyChanged(CachedUserVariable const& o) const;
 	UserVariable ToUserVariable(lua_State* L) const;
-	STDString StringifyReference(lua_State* L) const;
-	void ParseReference(lua_State* L, StringView json);
+	STDString SerializeReference(lua_State* L) const;
+	// Accepts both binary blobs and JSON (variables stored by older versions)
+	void DeserializeReference(lua_State* L, StringView blob);
 };
 
 class CachedUserVariableManager
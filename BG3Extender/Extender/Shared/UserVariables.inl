@@ -1,21 +1,35 @@
 #include <Extender/Shared/UserVariables.h>
 #include <GameDefinitions/Components/Components.h>
 #include <Lua/Libs/Json.h>
+#include <Lua/Libs/BinaryValue.h>
 
 #define USER_VAR_DBG(msg, ...)
 //#define USER_VAR_DBG(msg, ...) DEBUG(msg, __VA_ARGS__)
 
 BEGIN_NS(net)
 
-void ExtenderProtocolBase::SyncUserVars(MsgUserVars const& msg)
+void ExtenderProtocolBase::SyncUserVars(MsgUserVars const& msg, PeerId peer)
 {
+	if (!msg.compressed_vars().empty()) {
+		std::string buf;
+		MsgUserVars decompressed;
+		if (!DecompressPayload(msg.compressed_vars(), msg.uncompressed_size(), buf)
+			|| !decompressed.ParseFromString(buf)) {
+			ERR("Failed to decompress user variable sync message");
+			return;
+		}
+
+		SyncUserVars(decompressed, peer);
+		return;
+	}
+
 	USER_VAR_DBG("Received sync message from peer");
 	auto state = gExtender->GetCurrentExtensionState();
 	for (auto const& var : msg.vars()) {
 		if (var.type() == UserVarType::MODULE_VAR) {
-			state->GetModVariables().NetworkSync(var);
+			state->GetModVariables().NetworkSync(var, peer);
 		} else {
-			state->GetUserVariables().NetworkSync(var);
+			state->GetUserVariables().NetworkSync(var, peer);
 		}
 	}
 }
@@ -24,6 +38,9 @@ END_NS()
 
 BEGIN_SE()
 
+// Prefix of base64 encoded binary values in savegames; JSON documents can't start with this character
+static constexpr char SavegameBinaryPrefix = '#';
+
 void UserVariable::SavegameVisit(ObjectVisitor* visitor)
 {
 	if (visitor->IsReading()) {
@@ -42,9 +59,21 @@ void UserVariable::SavegameVisit(ObjectVisitor* visitor)
 			visitor->VisitFixedString(GFS.strValue, Str, GFS.strEmpty);
 			break;
 		case UserVariableType::Composite:
-			visitor->VisitSTDString(GFS.strValue, CompositeStr, STDString{});
+		{
+			STDString value;
+			visitor->VisitSTDString(GFS.strValue, value, STDString{});
+			if (!value.empty() && value[0] == SavegameBinaryPrefix) {
+				CompositeStr.clear();
+				if (!lua::binary::Base64Decode(StringView(value).substr(1), CompositeStr)) {
+					ERR("Failed to decode user variable blob from savegame");
+					Type = UserVariableType::Null;
+				}
+			} else {
+				CompositeStr = std::move(value);
+			}
 			break;
 		}
+		}
 	} else {
 		auto type = (uint8_t)Type;
 		visitor->VisitUInt8(GFS.strType, type, (uint8_t)UserVariableType::Null);
@@ -59,7 +88,15 @@ void UserVariable::SavegameVisit(ObjectVisitor* visitor)
 			visitor->VisitFixedString(GFS.strValue, Str, GFS.strEmpty);
 			break;
 		case UserVariableType::Composite:
-			visitor->VisitSTDString(GFS.strValue, CompositeStr, STDString{});
+			if (lua::binary::IsBinaryValue(CompositeStr)) {
+				// Savegame strings can't contain arbitrary bytes
+				STDString value;
+				value.push_back(SavegameBinaryPrefix);
+				lua::binary::Base64Encode(CompositeStr, value);
+				visitor->VisitSTDString(GFS.strValue, value, STDString{});
+			} else {
+				visitor->VisitSTDString(GFS.strValue, CompositeStr, STDString{});
+			}
 			break;
 		}
 	}
@@ -89,7 +126,19 @@ void UserVariable::ToNetMessage(net::UserVar& var) const
 	}
 }
 
-void UserVariable::FromNetMessage(net::UserVar const& var)
+// FNV-1a hash of composite values; used for checking delta baselines, so it must be stable across peers
+uint64_t UserVariableDeltaHash(StringView value)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (auto ch : value) {
+		hash ^= (uint8_t)ch;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+bool UserVariable::FromNetMessage(net::UserVar const& var, UserVariable const* current)
 {
 	switch (var.val_case()) {
 	case net::UserVar::kIntval:
@@ -112,11 +161,32 @@ void UserVariable::FromNetMessage(net::UserVar const& var)
 		CompositeStr = var.luaval();
 		break;
 
+	case net::UserVar::kLuadelta:
+	{
+		auto const& delta = var.luadelta();
+		if (current == nullptr
+			|| current->Type != UserVariableType::Composite
+			|| (std::size_t)delta.prefix_length() + delta.suffix_length() > current->CompositeStr.size()
+			|| UserVariableDeltaHash(current->CompositeStr) != delta.base_hash()) {
+			return false;
+		}
+
+		auto const& base = current->CompositeStr;
+		Type = UserVariableType::Composite;
+		CompositeStr.reserve(delta.prefix_length() + delta.replacement().size() + delta.suffix_length());
+		CompositeStr.assign(base.data(), delta.prefix_length());
+		CompositeStr.append(delta.replacement().data(), delta.replacement().size());
+		CompositeStr.append(base.data() + base.size() - delta.suffix_length(), delta.suffix_length());
+		break;
+	}
+
 	case net::UserVar::VAL_NOT_SET:
 	default:
 		Type = UserVariableType::Null;
 		break;
 	}
+
+	return true;
 }
 
 
@@ -189,6 +259,10 @@ void UserVariableSyncWriter::Flush(bool force)
 	}
 
 	SendSyncs();
+
+	if (!peerResyncs_.empty()) {
+		SendPeerResyncs();
+	}
 }
 
 
@@ -196,8 +270,11 @@ void UserVariableSyncWriter::Clear()
 {
 	deferredSyncs_.clear();
 	nextTickSyncs_.clear();
+	deltaBaselines_.clear();
+	peerResyncs_.clear();
 	syncMsg_ = nullptr;
 	syncMsgBudget_ = 0;
+	targetPeer_.reset();
 }
 
 void UserVariableSyncWriter::Sync(Guid const& entity, FixedString const& key, UserVariablePrototype const& proto, UserVariable const* value)
@@ -205,39 +282,81 @@ void UserVariableSyncWriter::Sync(Guid const& entity, FixedString const& key, Us
 	if (proto.NeedsSyncFor(isServer_)) {
 		if (value && proto.Has(UserVariableFlags::SyncOnWrite)) {
 			USER_VAR_DBG("Immediate sync var %s/%s", entity.ToString().c_str(), key.GetString());
-			if (MakeSyncMessage()) {
-				AppendToSyncMessage(entity, key, *value);
+			if (MakeSyncMessage() && AppendToSyncMessage(entity, key, *value, proto.Has(UserVariableFlags::DeltaSync), false)) {
 				SendSyncs();
+			} else {
+				// Out of free messages; retry on the next flush
+				QueueSync(deferredSyncs_, entity, key, value, proto.Has(UserVariableFlags::DeltaSync), false);
 			}
 		} else if (proto.Has(UserVariableFlags::SyncOnTick)) {
 			USER_VAR_DBG("Request next tick sync for var %s/%s", entity.ToString().c_str(), key.GetString());
-			nextTickSyncs_.push_back(SyncRequest{
-				.Entity = entity,
-				.Variable = key
-			});
+			QueueSync(nextTickSyncs_, entity, key, value, proto.Has(UserVariableFlags::DeltaSync), false);
 		} else {
 			USER_VAR_DBG("Request deferred sync for var %s/%s", entity.ToString().c_str(), key.GetString());
-			deferredSyncs_.push_back(SyncRequest{
-				.Entity = entity,
-				.Variable = key
-			});
+			QueueSync(deferredSyncs_, entity, key, value, proto.Has(UserVariableFlags::DeltaSync), false);
 		}
 	}
 }
 
 void UserVariableSyncWriter::DeferredSync(Guid const& entity, FixedString const& key)
 {
-	deferredSyncs_.push_back(SyncRequest{
-		.Entity = entity,
-		.Variable = key
-	});
+	QueueSync(deferredSyncs_, entity, key, nullptr, false, false);
+}
+
+void UserVariableSyncWriter::FullSync(Guid const& entity, FixedString const& key)
+{
+	QueueSync(deferredSyncs_, entity, key, nullptr, true, true);
+}
+
+void UserVariableSyncWriter::RequestFullSync(Guid const& entity, FixedString const& key)
+{
+	USER_VAR_DBG("Request full sync of var %s/%s from peer", entity.ToString().c_str(), key.GetString());
+	stats_.FullSyncRequests++;
+	if (MakeSyncMessage()) {
+		auto var = AddSyncMessageVar(entity, key);
+		if (var) {
+			var->set_request_full_sync(true);
+			syncMsgBudget_ += key.GetLength() + 12;
+		}
+	}
+}
+
+void UserVariableSyncWriter::ResyncPeer(Guid const& entity, FixedString const& key, PeerId peer)
+{
+	USER_VAR_DBG("Resync var %s/%s to peer %d", entity.ToString().c_str(), key.GetString(), (int32_t)peer);
+	UserVariableSyncKey syncKey{ entity, key };
+	for (auto const& resync : peerResyncs_) {
+		if (resync.Peer == peer && resync.Key == syncKey) return;
+	}
+
+	peerResyncs_.push_back(PeerResync{ peer, syncKey });
 }
 
-void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& value)
+void UserVariableSyncWriter::QueueSync(SyncQueue& queue, Guid const& entity, FixedString const& key, UserVariable const* value, bool allowDelta, bool forceFull)
+{
+	auto req = queue.get_or_add(UserVariableSyncKey{ entity, key });
+	if (req->Writes == 0) {
+		stats_.QueuedSyncs++;
+	} else {
+		stats_.CoalescedWrites++;
+		if (value) {
+			stats_.BytesSaved += value->Budget() + key.GetLength();
+		}
+	}
+
+	req->Writes++;
+	req->AllowDelta = req->AllowDelta || allowDelta;
+	req->ForceFull = req->ForceFull || forceFull;
+}
+
+net::UserVar* UserVariableSyncWriter::AddSyncMessageVar(Guid const& entity, FixedString const& key)
 {
 	if (syncMsgBudget_ > SyncMessageBudget) {
 		SendSyncs();
-		MakeSyncMessage();
+	}
+
+	if (!MakeSyncMessage()) {
+		return nullptr;
 	}
 
 	auto var = syncMsg_->GetMessage().mutable_user_vars()->add_vars();
@@ -249,24 +368,177 @@ void UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString
 	var->set_uuid1(entity.Val[0]);
 	var->set_uuid2(entity.Val[1]);
 	var->set_key(key.GetString());
-	value.ToNetMessage(*var);
-	syncMsgBudget_ += value.Budget() + key.GetLength();
+	return var;
 }
 
-void UserVariableSyncWriter::FlushSyncQueue(Array<SyncRequest>& queue)
+UserVariable const* UserVariableSyncWriter::GetPeerValue(FixedString const& key, UserVariable const& variable, UserVariable& legacyValue)
+{
+	// Peers that predate the binary format can only read JSON values
+	if (!peerSupportsBinary_ && variable.Type == UserVariableType::Composite && lua::binary::IsBinaryValue(variable.CompositeStr)) {
+		legacyValue.Type = UserVariableType::Composite;
+		if (!lua::binary::ToJson(variable.CompositeStr, legacyValue.CompositeStr)) {
+			ERR("Failed to convert user variable %s to JSON", key.GetString());
+			return nullptr;
+		}
+
+		return &legacyValue;
+	}
+
+	return &variable;
+}
+
+bool UserVariableSyncWriter::AppendToSyncMessage(Guid const& entity, FixedString const& key, UserVariable const& variable, bool allowDelta, bool forceFull)
+{
+	UserVariable legacyValue;
+	auto peerValue = GetPeerValue(key, variable, legacyValue);
+	// Conversion failures are logged and dropped, there's no point in retrying them
+	if (!peerValue) return true;
+
+	auto const& value = *peerValue;
+	auto var = AddSyncMessageVar(entity, key);
+	if (!var) return false;
+
+	auto size = value.Budget() + key.GetLength();
+
+	// Deltas are only sent server->client and are based on the last value broadcast to all clients.
+	// Clients that don't have the baseline value (checked using its hash) request a resync,
+	// and receive the baseline separately (see SendPeerResyncs())
+	UserVariableSyncKey syncKey{ entity, key };
+	if (allowDelta && isServer_ && peerSupportsDelta_ && value.Type == UserVariableType::Composite) {
+		auto baseline = deltaBaselines_.get_or_add(syncKey);
+		if (!forceFull && !baseline->empty() && AppendDelta(*var, *baseline, value.CompositeStr)) {
+			auto deltaSize = var->luadelta().replacement().size() + 20 + key.GetLength();
+			stats_.DeltaSyncs++;
+			stats_.DeltaBytesSaved += size - deltaSize;
+			size = deltaSize;
+		} else {
+			value.ToNetMessage(*var);
+		}
+
+		*baseline = value.CompositeStr;
+	} else {
+		deltaBaselines_.remove(syncKey);
+		value.ToNetMessage(*var);
+	}
+
+	syncMsgBudget_ += size;
+	stats_.SentVariables++;
+	stats_.SentBytes += size;
+	return true;
+}
+
+bool UserVariableSyncWriter::AppendDelta(net::UserVar& var, STDString const& baseline, STDString const& value)
+{
+	std::size_t prefix = 0;
+	auto maxPrefix = std::min(baseline.size(), value.size());
+	while (prefix < maxPrefix && baseline[prefix] == value[prefix]) {
+		prefix++;
+	}
+
+	std::size_t suffix = 0;
+	auto maxSuffix = maxPrefix - prefix;
+	while (suffix < maxSuffix && baseline[baseline.size() - suffix - 1] == value[value.size() - suffix - 1]) {
+		suffix++;
+	}
+
+	// Not worth sending a delta if most of the value changed
+	auto replacementSize = value.size() - prefix - suffix;
+	if (replacementSize + 20 > value.size() / 2) {
+		return false;
+	}
+
+	auto delta = var.mutable_luadelta();
+	delta->set_base_hash(UserVariableDeltaHash(baseline));
+	delta->set_prefix_length((uint32_t)prefix);
+	delta->set_suffix_length((uint32_t)suffix);
+	delta->set_replacement(value.data() + prefix, replacementSize);
+	return true;
+}
+
+void UserVariableSyncWriter::FlushSyncQueue(SyncQueue& queue)
 {
 	if (!MakeSyncMessage()) return;
 
-	for (auto const& req : queue) {
+	auto const& keys = queue.keys();
+	auto const& requests = queue.values();
+	uint32_t flushed = 0;
+	for (; flushed < keys.size(); flushed++) {
+		auto const& req = keys[flushed];
 		auto value = vars_->Get(req.Entity, req.Variable);
 		if (value && value->Dirty) {
 			USER_VAR_DBG("Flush sync var %s/%s", req.Entity.ToString().c_str(), req.Variable.GetString());
-			AppendToSyncMessage(req.Entity, req.Variable, *value);
+			if (!AppendToSyncMessage(req.Entity, req.Variable, *value, requests[flushed].AllowDelta, requests[flushed].ForceFull)) {
+				break;
+			}
+
 			value->Dirty = false;
 		}
 	}
 
-	queue.clear();
+	if (flushed == keys.size()) {
+		queue.clear();
+	} else {
+		// Out of free messages; keep the remaining variables queued for the next flush
+		Array<UserVariableSyncKey> sent;
+		for (uint32_t i = 0; i < flushed; i++) {
+			sent.push_back(keys[i]);
+		}
+
+		for (auto const& key : sent) {
+			queue.remove(key);
+		}
+	}
+}
+
+void UserVariableSyncWriter::SendPeerResyncs()
+{
+	uint32_t i = 0;
+	for (; i < peerResyncs_.size(); i++) {
+		auto const& resync = peerResyncs_[i];
+		if (!targetPeer_ || *targetPeer_ != resync.Peer) {
+			SendSyncs();
+			targetPeer_ = resync.Peer;
+			UpdatePeerSupport();
+		}
+
+		auto current = vars_->Get(resync.Key.Entity, resync.Key.Variable);
+		if (!current) continue;
+
+		// Send the value the other peers have, so the peer can apply the next delta broadcast
+		UserVariable baselineValue;
+		auto baseline = deltaBaselines_.try_get(resync.Key);
+		if (baseline && baseline->empty()) {
+			baseline = nullptr;
+		}
+
+		if (baseline) {
+			baselineValue.Type = UserVariableType::Composite;
+			baselineValue.CompositeStr = *baseline;
+		}
+
+		UserVariable legacyValue;
+		auto value = GetPeerValue(resync.Key.Variable, baseline ? baselineValue : *current, legacyValue);
+		if (!value) continue;
+
+		auto var = AddSyncMessageVar(resync.Key.Entity, resync.Key.Variable);
+		if (!var) break;
+
+		USER_VAR_DBG("Resync var %s/%s to peer %d", resync.Key.Entity.ToString().c_str(), resync.Key.Variable.GetString(), (int32_t)resync.Peer);
+		value->ToNetMessage(*var);
+		auto size = value->Budget() + resync.Key.Variable.GetLength();
+		syncMsgBudget_ += size;
+		stats_.SentVariables++;
+		stats_.SentBytes += size;
+	}
+
+	SendSyncs();
+	targetPeer_.reset();
+	UpdatePeerSupport();
+
+	// Keep the rest queued if we ran out of free messages
+	for (uint32_t j = 0; j < i; j++) {
+		peerResyncs_.remove_at(0);
+	}
 }
 
 bool UserVariableSyncWriter::MakeSyncMessage()
@@ -280,16 +552,57 @@ bool UserVariableSyncWriter::MakeSyncMessage()
 
 		if (syncMsg_) {
 			syncMsg_->GetMessage().mutable_user_vars();
+			UpdatePeerSupport();
 		}
 	}
 
 	return syncMsg_ != nullptr;
 }
 
+void UserVariableSyncWriter::UpdatePeerSupport()
+{
+	if (isServer_ && targetPeer_) {
+		auto peerVersion = gExtender->GetServer().GetNetworkManager().GetPeerVersion(*targetPeer_).value_or(0);
+		peerSupportsDelta_ = peerVersion >= net::ExtenderMessage::VerUserVarDelta;
+		peerSupportsBinary_ = peerVersion >= net::ExtenderMessage::VerBinaryUserVars;
+	} else if (isServer_) {
+		auto& networkMgr = gExtender->GetServer().GetNetworkManager();
+		peerSupportsDelta_ = networkMgr.AllPeersSupport(net::ExtenderMessage::VerUserVarDelta);
+		peerSupportsBinary_ = networkMgr.AllPeersSupport(net::ExtenderMessage::VerBinaryUserVars);
+	} else {
+		auto hostVersion = gExtender->GetClient().GetNetworkManager().GetHostVersion();
+		peerSupportsDelta_ = hostVersion >= net::ExtenderMessage::VerUserVarDelta;
+		peerSupportsBinary_ = hostVersion >= net::ExtenderMessage::VerBinaryUserVars;
+	}
+}
+
+void UserVariableSyncWriter::CompressSyncMessage()
+{
+	auto& userVars = *syncMsg_->GetMessage().mutable_user_vars();
+	std::string buf;
+	userVars.SerializeToString(&buf);
+
+	std::string compressed;
+	if (net::CompressPayload(buf.data(), buf.size(), compressed)) {
+		stats_.CompressedMessages++;
+		stats_.CompressionBytesSaved += buf.size() - compressed.size();
+		userVars.clear_vars();
+		userVars.set_compressed_vars(std::move(compressed));
+		userVars.set_uncompressed_size((uint32_t)buf.size());
+	}
+}
+
 void UserVariableSyncWriter::SendSyncs()
 {
 	if (syncMsg_ && syncMsg_->GetMessage().user_vars().vars_size() > 0) {
-		if (isServer_) {
+		if (peerSupportsDelta_ && syncMsgBudget_ > CompressionThreshold) {
+			CompressSyncMessage();
+		}
+
+		if (isServer_ && targetPeer_) {
+			USER_VAR_DBG("Syncing user vars to peer %d", (int32_t)*targetPeer_);
+			gExtender->GetServer().GetNetworkManager().SendToPeers(syncMsg_, { *targetPeer_ });
+		} else if (isServer_) {
 			USER_VAR_DBG("Syncing user vars to client(s)");
 			gExtender->GetServer().GetNetworkManager().BroadcastToConnectedPeers(syncMsg_, ReservedUserId, false);
 		} else {
@@ -457,7 +770,7 @@ void UserVariableManager::SavegameVisit(ObjectVisitor* visitor)
 	}
 }
 
-void UserVariableManager::NetworkSync(net::UserVar const& var)
+void UserVariableManager::NetworkSync(net::UserVar const& var, PeerId peer)
 {
 	Guid entityGuid;
 	entityGuid.Val[0] = var.uuid1();
@@ -474,13 +787,25 @@ void UserVariableManager::NetworkSync(net::UserVar const& var)
 		return;
 	}
 	
+	if (var.request_full_sync()) {
+		auto current = Get(entityGuid, key);
+		if (isServer_ && current && proto->NeedsSyncFor(isServer_)) {
+			sync_.ResyncPeer(entityGuid, key, peer);
+		}
+		return;
+	}
+
 	if (!proto->NeedsSyncFor(!isServer_)) {
 		ERR("Tried to sync variable '%s' in illegal direction!", var.key().c_str());
 		return;
 	}
 
 	UserVariable value;
-	value.FromNetMessage(var);
+	if (!value.FromNetMessage(var, Get(entityGuid, key))) {
+		sync_.RequestFullSync(entityGuid, key);
+		return;
+	}
+
 	value.Dirty = proto->NeedsRebroadcast(isServer_);
 
 	Set(entityGuid, key, *proto, std::move(value));
@@ -758,7 +1083,7 @@ void ModVariableManager::SavegameVisit(ObjectVisitor* visitor)
 	}
 }
 
-void ModVariableManager::NetworkSync(net::UserVar const& var)
+void ModVariableManager::NetworkSync(net::UserVar const& var, PeerId peer)
 {
 	Guid modUuid;
 	modUuid.Val[0] = var.uuid1();
@@ -779,13 +1104,25 @@ void ModVariableManager::NetworkSync(net::UserVar const& var)
 		return;
 	}
 
+	if (var.request_full_sync()) {
+		auto current = map->Get(key);
+		if (isServer_ && current && proto->NeedsSyncFor(isServer_)) {
+			sync_.ResyncPeer(modUuid, key, peer);
+		}
+		return;
+	}
+
 	if (!proto->NeedsSyncFor(!isServer_)) {
 		ERR("Tried to sync variable %s/%s in illegal direction!", modUuid.ToString().c_str(), var.key().c_str());
 		return;
 	}
 
 	UserVariable value;
-	value.FromNetMessage(var);
+	if (!value.FromNetMessage(var, map->Get(key))) {
+		sync_.RequestFullSync(modUuid, key);
+		return;
+	}
+
 	value.Dirty = proto->NeedsRebroadcast(isServer_);
 
 	Set(*map, key, *proto, std::move(value));
@@ -821,7 +1158,7 @@ CachedUserVariable::CachedUserVariable(lua_State* L, UserVariable const& v)
 		break;
 
 	case UserVariableType::Composite:
-		ParseReference(L, v.CompositeStr);
+		DeserializeReference(L, v.CompositeStr);
 		break;
 
 	case UserVariableType::Null:
@@ -917,9 +1254,13 @@ CachedUserVariable& CachedUserVariable::operator = (CachedUserVariable&& o)
 	return *this;
 }
 
-void CachedUserVariable::ParseReference(lua_State* L, StringView json)
+void CachedUserVariable::DeserializeReference(lua_State* L, StringView blob)
 {
-	if (json::Parse(L, json)) {
+	auto ok = lua::binary::IsBinaryValue(blob)
+		? lua::binary::Deserialize(L, blob)
+		: lua::json::Parse(L, blob);
+
+	if (ok) {
 		Reference = RegistryEntry(L, -1);
 		lua_pop(L, 1);
 		Type = CachedUserVariableType::Reference;
@@ -989,7 +1330,7 @@ UserVariable CachedUserVariable::ToUserVariable(lua_State* L) const
 		break;
 		
 	case CachedUserVariableType::Reference:
-		var.CompositeStr = StringifyReference(L);
+		var.CompositeStr = SerializeReference(L);
 		if (!var.CompositeStr.empty()) {
 			var.Type = UserVariableType::Composite;
 		} else {
@@ -1002,22 +1343,21 @@ UserVariable CachedUserVariable::ToUserVariable(lua_State* L) const
 	return var;
 }
 
-STDString CachedUserVariable::StringifyReference(lua_State* L) const
+STDString CachedUserVariable::SerializeReference(lua_State* L) const
 {
+	auto top = lua_gettop(L);
 	Reference.Push();
-	json::StringifyContext ctx;
-	ctx.Beautify = false;
 
-	STDString str;
+	STDString blob;
 	try {
-		str = json::Stringify(L, ctx, lua_absindex(L, -1));
+		lua::binary::Serialize(L, -1, blob);
 	} catch (std::runtime_error& e) {
-		ERR("Error stringifying user variable: %s", e.what());
-		str.clear();
+		ERR("Error serializing user variable: %s", e.what());
+		blob.clear();
 	}
 
-	lua_pop(L, 1);
-	return str;
+	lua_settop(L, top);
+	return blob;
 }
 
 
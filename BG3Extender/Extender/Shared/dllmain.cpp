@@ -79,6 +79,8 @@ void LoadConfig(std::wstring const & configPath, ExtenderConfig & config)
 	ConfigGetBool(root, "DisableStoryMerge", config.DisableStoryMerge);
 	ConfigGetBool(root, "DisableStoryPatching", config.DisableStoryPatching);
 	ConfigGetBool(root, "DisableStoryCompilation", config.DisableStoryCompilation);
+	ConfigGetBool(root, "EnableSymbolCache", config.EnableSymbolCache);
+	ConfigGetBool(root, "EnableLuaBytecodeCache", config.EnableLuaBytecodeCache);
 
 	ConfigGetInt(root, "DebuggerPort", config.DebuggerPort);
 	ConfigGetInt(root, "LuaDebuggerPort", config.LuaDebuggerPort);
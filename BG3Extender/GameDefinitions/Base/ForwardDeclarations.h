@@ -68,6 +68,10 @@ namespace net
 	struct Host;
 	struct Client;
 	struct GameServer;
+
+	class MsgS2CSyncStat;
+	class StatIndexedProperty;
+	class StatRequirement;
 }
 
 namespace ecs
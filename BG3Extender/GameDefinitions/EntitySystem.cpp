@@ -622,6 +622,53 @@ void* EntitySystemHelpersBase::GetRawComponent(EntityHandle entityHandle, ExtCom
 	}
 }
 
+void IndexEntityClass(EntityClass* cls, ComponentTypeIndex type, Array<EntitySystemHelpersBase::ComponentClassEntry>& entries)
+{
+	auto slot = cls->ComponentTypeToIndex.try_get(type);
+	if (slot) {
+		entries.push_back(EntitySystemHelpersBase::ComponentClassEntry{ cls, *slot });
+	}
+}
+
+Array<EntitySystemHelpersBase::ComponentClassEntry> EntitySystemHelpersBase::GetEntityClassesWithComponent(ComponentTypeIndex type)
+{
+	auto world = GetEntityWorld();
+	if (!world) {
+		return {};
+	}
+
+	auto const& classes = world->EntityTypes->EntityClasses;
+	if (world != classIndexWorld_ || classes.size() < numIndexedClasses_) {
+		classesByComponent_.clear();
+		classIndexWorld_ = world;
+		numIndexedClasses_ = classes.size();
+	}
+
+	if (classes.size() > numIndexedClasses_) {
+		auto const& indexedTypes = classesByComponent_.keys();
+		auto& indexedClasses = classesByComponent_.values();
+		for (uint32_t i = 0; i < indexedTypes.size(); i++) {
+			for (uint32_t clsIndex = numIndexedClasses_; clsIndex < classes.size(); clsIndex++) {
+				IndexEntityClass(classes[clsIndex], ComponentTypeIndex(indexedTypes[i]), indexedClasses[i]);
+			}
+		}
+
+		numIndexedClasses_ = classes.size();
+	}
+
+	auto entries = classesByComponent_.try_get(type.Value());
+	if (entries) {
+		return *entries;
+	}
+
+	auto newEntries = classesByComponent_.get_or_add(type.Value());
+	for (auto cls : classes) {
+		IndexEntityClass(cls, type, *newEntries);
+	}
+
+	return *newEntries;
+}
+
 void* EntitySystemHelpersBase::GetRawSystem(ExtSystemType type)
 {
 	auto world = GetEntityWorld();
@@ -46,6 +46,13 @@ public:
 		bool IsProxy{ false };
 	};
 
+	// Entity class that contains a specific component type, and the slot of that component in the class pools
+	struct ComponentClassEntry
+	{
+		EntityClass* Class;
+		uint8_t ComponentSlot;
+	};
+
 	EntitySystemHelpersBase();
 
 	inline std::optional<ComponentTypeIndex> GetComponentIndex(STDString const& type) const
@@ -185,6 +192,8 @@ public:
 	void NotifyReplicationFlagsDirtied();
 
 	void* GetRawComponent(EntityHandle entityHandle, ExtComponentType type);
+	// Returns a copy, as indexing another component type may rehash the class cache
+	Array<ComponentClassEntry> GetEntityClassesWithComponent(ComponentTypeIndex type);
 	void* GetRawSystem(ExtSystemType type);
 	EntityHandle GetEntityHandle(FixedString const& guidString);
 	EntityHandle GetEntityHandle(Guid const& uuid);
@@ -225,6 +234,13 @@ private:
 	std::unordered_map<STDString, int32_t> staticDataMappings_;
 	std::vector<STDString const*> staticDataIdToName_;
 
+	// Reverse index of component type -> entity classes containing the component.
+	// Entity classes are never removed from the world, so the index is extended when new classes
+	// are appended and only rebuilt when the entity world itself changes.
+	EntityWorld* classIndexWorld_{ nullptr };
+	uint32_t numIndexedClasses_{ 0 };
+	FlatHashMap<uint16_t, Array<ComponentClassEntry>> classesByComponent_;
+
 	bool initialized_{ false };
 
 	void BindSystem(std::string_view name, int32_t id);
@@ -76,6 +76,9 @@ struct Requirement
 	int IntParam;
 	Guid TagParam;
 	bool Not;
+
+	void ToProtobuf(net::StatRequirement* msg) const;
+	void FromProtobuf(net::StatRequirement const& msg);
 };
 
 struct Object : public Noncopyable<Object>
@@ -128,9 +131,14 @@ struct Object : public Noncopyable<Object>
 	bool SetRollConditions(FixedString const& attributeName, std::optional<Array<RollCondition>> const& value);
 
 	bool CopyFrom(Object* source);
-	void ToProtobuf(class MsgS2CSyncStat* msg) const;
-	void FromProtobuf(MsgS2CSyncStat const& msg);
-	void BroadcastSyncMessage(bool syncDuringLoading) const;
+	// Writes every indexed property and object field of the stats entry
+	void ToProtobuf(net::MsgS2CSyncStat* msg) const;
+	// Writes the value of a single indexed property; properties that aren't synced are left empty
+	bool IndexedPropertyToProtobuf(uint32_t index, net::StatIndexedProperty* msg) const;
+	void ObjectFieldsToProtobuf(net::MsgS2CSyncStat* msg) const;
+	// Applies a full or delta sync message to the stats entry
+	void FromProtobuf(net::MsgS2CSyncStat const& msg);
+	void IndexedPropertyFromProtobuf(net::StatIndexedProperty const& msg);
 };
 
 struct ObjectInstance : public Object
@@ -218,143 +218,289 @@ Functors& Functors::operator = (Functors&& o) noexcept
 }
 
 
-/*
-void Requirement::ToProtobuf(StatRequirement* msg) const
+void Requirement::ToProtobuf(net::StatRequirement* msg) const
 {
 	msg->set_requirement((int32_t)RequirementId);
 	msg->set_int_param(IntParam);
-	if (StringParam) {
-		msg->set_string_param(StringParam.Str);
-	}
-	msg->set_negate(Negate);
+	msg->set_tag_param1(TagParam.Val[0]);
+	msg->set_tag_param2(TagParam.Val[1]);
+	msg->set_negate(Not);
 }
 
-void Requirement::FromProtobuf(StatRequirement const& msg)
+void Requirement::FromProtobuf(net::StatRequirement const& msg)
 {
 	RequirementId = (RequirementType)msg.requirement();
 	IntParam = msg.int_param();
-	if (!msg.string_param().empty()) {
-		StringParam = MakeFixedString(msg.string_param().c_str());
-	}
-
-	Negate = msg.negate();
-}*/
+	TagParam.Val[0] = msg.tag_param1();
+	TagParam.Val[1] = msg.tag_param2();
+	Not = msg.negate();
+}
 
 
-void Object::ToProtobuf(MsgS2CSyncStat* msg) const
+void Object::ToProtobuf(net::MsgS2CSyncStat* msg) const
 {
-	/*msg->set_name(Name.Str);
-	msg->set_level(Level);
+	msg->set_name(Name.GetString());
 	msg->set_modifier_list(ModifierListIndex);
+	msg->set_full(true);
+
+	for (uint32_t i = 0; i < IndexedProperties.size(); i++) {
+		IndexedPropertyToProtobuf(i, msg->add_indexed_properties());
+	}
+
+	ObjectFieldsToProtobuf(msg);
+}
+
+bool Object::IndexedPropertyToProtobuf(uint32_t index, net::StatIndexedProperty* msg) const
+{
+	msg->set_index(index);
 
 	auto stats = GetStaticSymbols().GetStats();
-	auto modifierList = stats->modifierList.Find(ModifierListIndex);
-
-	for (size_t i = 0; i < IndexedProperties.size(); i++) {
-		auto value = IndexedProperties[i];
-		auto indexedProp = msg->add_indexed_properties();
-		auto modifier = modifierList->Attributes.Find((uint32_t)i);
-		auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
-		if (enumeration->IsIndexedProperty()) {
-			if (enumeration->IsStringIndexedProperty()) {
-				indexedProp->set_stringval(stats->ModifierFSSet[value].Str);
-			} else {
-				indexedProp->set_intval(value);
-			}
+	auto modifierList = stats->ModifierLists.Find(ModifierListIndex);
+	auto modifier = modifierList ? modifierList->Attributes.Find(index) : nullptr;
+	auto enumeration = modifier ? stats->ModifierValueLists.Find(modifier->EnumerationIndex) : nullptr;
+	if (enumeration == nullptr) {
+		return false;
+	}
+
+	auto value = IndexedProperties[index];
+	switch (enumeration->GetPropertyType()) {
+	case RPGEnumerationType::Int:
+	case RPGEnumerationType::Enumeration:
+		msg->set_intval(value);
+		break;
+
+	case RPGEnumerationType::Float:
+	{
+		auto val = stats->GetFloat(value);
+		if (val) {
+			msg->set_floatval(**val);
 		}
+		break;
 	}
 
-	msg->set_ai_flags(AIFlags.Str);
+	case RPGEnumerationType::Flags:
+	{
+		auto val = stats->GetInt64(value);
+		if (val) {
+			msg->set_int64val(**val);
+		}
+		break;
+	}
 
-	for (auto const& reqmt : Requirements) {
-		reqmt.ToProtobuf(msg->add_requirements());
+	case RPGEnumerationType::FixedString:
+	{
+		auto val = stats->GetFixedString(value);
+		if (val) {
+			msg->set_stringval((*val)->GetString());
+		}
+		break;
 	}
 
-	for (auto const& reqmt : MemorizationRequirements) {
-		reqmt.ToProtobuf(msg->add_memorization_requirements());
+	case RPGEnumerationType::GUID:
+	{
+		auto val = stats->GetGuid(value);
+		if (val) {
+			auto guid = msg->mutable_guidval();
+			guid->set_uuid1((*val)->Val[0]);
+			guid->set_uuid2((*val)->Val[1]);
+		}
+		break;
 	}
 
-	for (auto const& category : ComboCategories) {
-		msg->add_combo_categories(category.Str);
+	case RPGEnumerationType::Conditions:
+	{
+		auto val = stats->GetConditions(value);
+		if (val) {
+			msg->set_stringval((*val)->data(), (*val)->size());
+		}
+		break;
+	}
+
+	case RPGEnumerationType::TranslatedString:
+	{
+		auto val = stats->GetTranslatedString(value);
+		if (val) {
+			auto ts = msg->mutable_tsval();
+			ts->set_handle((*val)->Handle.Handle.GetString());
+			ts->set_version((*val)->Handle.Version);
+			ts->set_argument_handle((*val)->ArgumentString.Handle.GetString());
+			ts->set_argument_version((*val)->ArgumentString.Version);
+		}
+		break;
+	}
+
+	case RPGEnumerationType::RollConditions:
+	{
+		auto conditions = RollConditions.try_get(modifier->Name);
+		if (conditions) {
+			auto rollConditions = msg->mutable_rollval();
+			for (auto const& cond : *conditions) {
+				auto condMsg = rollConditions->add_conditions();
+				condMsg->set_name(cond.Name.GetString());
+				auto val = stats->GetConditions(cond.ConditionsId);
+				if (val) {
+					condMsg->set_conditions((*val)->data(), (*val)->size());
+				}
+			}
+		}
+		break;
 	}
 
-	PropertyList.Iterate([msg](auto const& key, auto const& propertyList) {
-		propertyList->ToProtobuf(key, msg->add_property_lists());
-	});*/
+	default:
+		// Functors are not synced until they're mapped
+		return false;
+	}
+
+	return true;
 }
 
-void Object::FromProtobuf(MsgS2CSyncStat const& msg)
+void Object::ObjectFieldsToProtobuf(net::MsgS2CSyncStat* msg) const
 {
-	/*auto stats = GetStaticSymbols().GetStats();
-	Level = msg.level();
+	msg->set_has_object_fields(true);
+	if (AIFlags) {
+		msg->set_ai_flags(AIFlags.GetString());
+	}
+
+	for (auto const& reqmt : Requirements) {
+		reqmt.ToProtobuf(msg->add_requirements());
+	}
+
+	for (auto const& category : ComboCategories) {
+		msg->add_combo_categories(category.GetString());
+	}
+}
 
-	if (msg.indexed_properties_size() != IndexedProperties.size()) {
+void Object::FromProtobuf(net::MsgS2CSyncStat const& msg)
+{
+	if (msg.full() && msg.indexed_properties_size() != (int)IndexedProperties.size()) {
 		OsiError("IndexedProperties size mismatch for '" << Name << "'! Got "
 			<< msg.indexed_properties_size() << ", expected " << IndexedProperties.size());
 		return;
 	}
 
-	auto modifierList = stats->modifierList.Find(ModifierListIndex);
-	for (size_t i = 0; i < IndexedProperties.size(); i++) {
-		auto modifier = modifierList->Attributes.Find((uint32_t)i);
-		auto enumeration = stats->modifierValueList.Find(modifier->RPGEnumerationIndex);
-		if (enumeration->IsIndexedProperty()) {
-			auto const& prop = msg.indexed_properties().Get((uint32_t)i);
-			if (enumeration->IsStringIndexedProperty()) {
-				IndexedProperties[i] = stats->GetOrCreateFixedString(prop.stringval().c_str());
-			} else {
-				IndexedProperties[i] = prop.intval();
-			}
-		} else {
-			IndexedProperties[i] = 0;
-		}
+	for (auto const& prop : msg.indexed_properties()) {
+		IndexedPropertyFromProtobuf(prop);
 	}
 
-	AIFlags = MakeFixedString(msg.ai_flags().c_str());
+	if (msg.has_object_fields()) {
+		AIFlags = FixedString(msg.ai_flags().c_str());
 
-	Requirements.Clear();
-	for (auto const& reqmt : msg.requirements()) {
-		Requirement requirement;
-		requirement.FromProtobuf(reqmt);
-		Requirements.Add(requirement);
-	}
-
-	MemorizationRequirements.Clear();
-	for (auto const& reqmt : msg.memorization_requirements()) {
-		Requirement requirement;
-		requirement.FromProtobuf(reqmt);
-		MemorizationRequirements.Add(requirement);
-	}
+		Requirements.clear();
+		for (auto const& reqmt : msg.requirements()) {
+			Requirement requirement;
+			requirement.FromProtobuf(reqmt);
+			Requirements.Add(requirement);
+		}
 
-	ComboCategories.Clear();
-	for (auto const& category : msg.combo_categories()) {
-		ComboCategories.Add(MakeFixedString(category.c_str()));
+		ComboCategories.clear();
+		for (auto const& category : msg.combo_categories()) {
+			ComboCategories.Add(FixedString(category.c_str()));
+		}
 	}
-
-	PropertyList.Clear();
-	for (auto const& props : msg.property_lists()) {
-		auto name = MakeFixedString(props.name().c_str());
-		auto propertyList = stats->ConstructPropertyList(name);
-		propertyList->FromProtobuf(props);
-		PropertyList.Insert(name, propertyList);
-	}*/
 }
 
-void Object::BroadcastSyncMessage(bool syncDuringLoading) const
+void Object::IndexedPropertyFromProtobuf(net::StatIndexedProperty const& msg)
 {
-	/*auto msg = gExtender->GetNetworkManager().GetFreeServerMessage(ReservedUserId);
-	if (!msg) {
-		OsiErrorS("Failed to get free message");
+	auto index = msg.index();
+	if (index >= IndexedProperties.size()) {
+		OsiError("Indexed property " << index << " out of range for '" << Name << "'");
 		return;
 	}
 
-	auto& wrap = msg->GetMessage();
-	ToProtobuf(wrap.mutable_s2c_sync_stat());
-	if (syncDuringLoading) {
-		gExtender->GetNetworkManager().ServerBroadcastToConnectedPeers(msg, ReservedUserId, true);
-	} else {
-		gExtender->GetNetworkManager().ServerBroadcast(msg, ReservedUserId, true);
-	}*/
+	auto stats = GetStaticSymbols().GetStats();
+	auto modifierList = stats->ModifierLists.Find(ModifierListIndex);
+	auto modifier = modifierList ? modifierList->Attributes.Find(index) : nullptr;
+	auto enumeration = modifier ? stats->ModifierValueLists.Find(modifier->EnumerationIndex) : nullptr;
+	if (enumeration == nullptr) {
+		return;
+	}
+
+	auto& value = IndexedProperties[index];
+	switch (enumeration->GetPropertyType()) {
+	case RPGEnumerationType::Int:
+	case RPGEnumerationType::Enumeration:
+		value = msg.intval();
+		break;
+
+	case RPGEnumerationType::Float:
+		value = -1;
+		if (msg.has_floatval()) {
+			auto flt = stats->GetOrCreateFloat(value);
+			if (flt != nullptr) {
+				*flt = msg.floatval();
+			}
+		}
+		break;
+
+	case RPGEnumerationType::Flags:
+		value = -1;
+		if (msg.has_int64val()) {
+			auto i64 = stats->GetOrCreateInt64(value);
+			if (i64 != nullptr) {
+				*i64 = msg.int64val();
+			}
+		}
+		break;
+
+	case RPGEnumerationType::FixedString:
+		value = -1;
+		if (msg.has_stringval()) {
+			auto fs = stats->GetOrCreateFixedString(value);
+			if (fs != nullptr) {
+				*fs = FixedString(msg.stringval().c_str());
+			}
+		}
+		break;
+
+	case RPGEnumerationType::GUID:
+		value = -1;
+		if (msg.has_guidval()) {
+			auto guid = stats->GetOrCreateGuid(value);
+			if (guid != nullptr) {
+				guid->Val[0] = msg.guidval().uuid1();
+				guid->Val[1] = msg.guidval().uuid2();
+			}
+		}
+		break;
+
+	case RPGEnumerationType::Conditions:
+		value = msg.has_stringval() ? stats->GetOrCreateConditions(STDString(msg.stringval())) : -1;
+		break;
+
+	case RPGEnumerationType::TranslatedString:
+		value = -1;
+		if (msg.has_tsval()) {
+			auto ts = stats->GetOrCreateTranslatedString(value);
+			if (ts != nullptr) {
+				auto const& tsMsg = msg.tsval();
+				ts->Handle.Handle = FixedString(tsMsg.handle().c_str());
+				ts->Handle.Version = (uint16_t)tsMsg.version();
+				ts->ArgumentString.Handle = FixedString(tsMsg.argument_handle().c_str());
+				ts->ArgumentString.Version = (uint16_t)tsMsg.argument_version();
+			}
+		}
+		break;
+
+	case RPGEnumerationType::RollConditions:
+		// Properties without a value were removed on the server
+		if (!msg.has_rollval()) {
+			RollConditions.remove(modifier->Name);
+		} else {
+			Array<RollCondition> conditions;
+			for (auto const& condMsg : msg.rollval().conditions()) {
+				RollCondition cond;
+				cond.Name = FixedString(condMsg.name().c_str());
+				cond.ConditionsId = stats->GetOrCreateConditions(STDString(condMsg.conditions()));
+				conditions.Add(cond);
+			}
+
+			RollConditions.set(modifier->Name, conditions);
+		}
+		break;
+
+	default:
+		break;
+	}
 }
 	
 
@@ -502,17 +648,28 @@ std::optional<Object*> RPGStats::CreateObject(FixedString const& name, int32_t m
 	}
 
 	Objects.Add(name, object);
+	gExtender->GetStatsIndex().OnObjectCreated(object);
 	return object;
 }
 
-/*void RPGStats::SyncObjectFromServer(MsgS2CSyncStat const& msg)
+void RPGStats::SyncObjectFromServer(net::MsgS2CSyncStat const& msg)
 {
-	auto object = objects.Find(ToFixedString(msg.name().c_str()));
+	auto object = Objects.Find(FixedString(msg.name().c_str()));
 	if (object) {
+		if (object->ModifierListIndex != (uint32_t)msg.modifier_list()) {
+			OsiError("Stats entry '" << object->Name << "' has a different type on the server; it will not be synced");
+			return;
+		}
+
 		object->FromProtobuf(msg);
 		SyncWithPrototypeManager(object);
 	} else {
-		auto newObject = CreateObject(MakeFixedString(msg.name().c_str()), msg.modifier_list());
+		if (!msg.full()) {
+			OsiError("Got delta sync for stats entry '" << msg.name() << "' that doesn't exist on the client");
+			return;
+		}
+
+		auto newObject = CreateObject(FixedString(msg.name().c_str()), msg.modifier_list());
 		if (!newObject) {
 			OsiError("Could not construct stats object from server: " << msg.name());
 			return;
@@ -521,7 +678,7 @@ std::optional<Object*> RPGStats::CreateObject(FixedString const& name, int32_t m
 		(*newObject)->FromProtobuf(msg);
 		SyncWithPrototypeManager(*newObject);
 	}
-}*/
+}
 
 void RPGStats::SyncWithPrototypeManager(Object* object)
 {
@@ -549,18 +706,6 @@ void RPGStats::SyncWithPrototypeManager(Object* object)
 	}
 }
 
-/*void RPGStats::BroadcastSyncAll()
-{
-	for (auto const& statsId : gExtender->GetServer().GetExtensionState().GetDynamicStats()) {
-		auto object = objects.Find(statsId);
-		if (!object) {
-			OsiError("Stat entry '" << statsId << "' is marked as dynamic but cannot be found! It will not be synced to the client!");
-		} else {
-			object->BroadcastSyncMessage(true);
-		}
-	}
-}*/
-
 std::optional<int> RPGStats::EnumLabelToIndex(FixedString const& enumName, char const* enumLabel)
 {
 	auto rpgEnum = ModifierValueLists.Find(enumName);
@@ -585,13 +730,7 @@ FixedString RPGStats::EnumIndexToLabel(FixedString const& enumName, int index)
 		return FixedString{};
 	}
 
-	auto value = rpgEnum->Values.find_by_value(index);
-	if (value != rpgEnum->Values.end()) {
-		return value.Key();
-	}
-	else {
-		return FixedString{};
-	}
+	return gExtender->GetStatsIndex().EnumIndexToLabel(rpgEnum, index);
 }
 
 std::optional<FixedString*> RPGStats::GetFixedString(int stringId)
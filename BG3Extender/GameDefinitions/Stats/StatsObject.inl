@@ -55,9 +55,9 @@ std::optional<STDString> Object::GetString(FixedString const& attributeName)
 			}
 		}
 	} else if (typeInfo->Values.size() > 0) {
-		auto enumLabel = typeInfo->Values.find_by_value(index);
-		if (enumLabel != typeInfo->Values.end()) {
-			return enumLabel.Key().GetString();
+		auto enumLabel = gExtender->GetStatsIndex().EnumIndexToLabel(typeInfo, index);
+		if (enumLabel) {
+			return enumLabel.GetString();
 		}
 	}
 
@@ -511,7 +511,7 @@ bool Object::SetRollConditions(FixedString const& attributeName, std::optional<A
 	if (value) {
 		RollConditions.set(attributeName, *value);
 	} else {
-		// FIXME - clearing roll conditions not implemented!
+		RollConditions.remove(attributeName);
 	}
 
 	return true;
@@ -7,6 +7,7 @@
 #include <functional>
 #include <psapi.h>
 #include <DbgHelp.h>
+#include <ShlObj.h>
 #include "resource.h"
 
 namespace bg3se
@@ -25,6 +26,21 @@ namespace bg3se
 		: symbolMapper_(mappings_)
 	{}
 
+	std::wstring LibraryManager::GetSymbolCachePath()
+	{
+		wchar_t appDataPath[MAX_PATH];
+		if (!SUCCEEDED(SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, appDataPath))) {
+			return L"";
+		}
+
+		std::wstring cacheDir = std::wstring(appDataPath) + L"\\BG3ScriptExtender";
+		if (!TryCreateDirectory(cacheDir)) {
+			return L"";
+		}
+
+		return cacheDir + L"\\SymbolCache.bin";
+	}
+
 	bool LibraryManager::FindLibraries(uint32_t gameRevision)
 	{
 		RegisterSymbols();
@@ -53,6 +69,9 @@ namespace bg3se
 		}
 
 		RegisterLibraries(symbolMapper_);
+		if (gExtender->GetConfig().EnableSymbolCache) {
+			symbolMapper_.SetCachePath(GetSymbolCachePath());
+		}
 		symbolMapper_.MapAllSymbols(false);
 
 		CriticalInitFailed = CriticalInitFailed || symbolMapper_.HasFailedCriticalMappings();
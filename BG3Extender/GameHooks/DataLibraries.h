@@ -58,11 +58,17 @@ namespace bg3se {
 			return symbolMapper_;
 		}
 
+		inline SymbolMappings const& Mappings() const
+		{
+			return mappings_;
+		}
+
 	private:
 		void PreRegisterLibraries(SymbolMappingLoader& loader);
 		void RegisterLibraries(SymbolMapper& mapper);
 		void RegisterSymbols();
 		bool BindApp();
+		std::wstring GetSymbolCachePath();
 		SymbolMapper::MappingResult BindECSContext(uint8_t const*);
 		SymbolMapper::MappingResult BindECSIndex(uint8_t const*);
 		SymbolMapper::MappingResult BindECSStaticStringConstructor(uint8_t const*);
@@ -0,0 +1,23 @@
+#pragma once
+
+BEGIN_NS(lua::binary)
+
+// Compact binary encoding of Lua values, used for storing composite user variables.
+// Blobs start with a marker byte that cannot appear at the start of a JSON document,
+// so code that reads stored values can accept both formats.
+static constexpr uint8_t BinaryValueMarker = 0xB1;
+static constexpr uint8_t BinaryValueVersion = 1;
+static constexpr uint32_t MaxSerializationDepth = 64;
+
+bool IsBinaryValue(StringView blob);
+// Serializes the value at the specified stack index; throws std::runtime_error if the value is not serializable
+void Serialize(lua_State* L, int index, STDString& blob);
+// Pushes the deserialized value to the stack; returns false (and pushes nothing) if the blob is malformed
+bool Deserialize(lua_State* L, StringView blob);
+// Converts a binary blob to JSON (for export and for peers that don't support the binary format)
+bool ToJson(StringView blob, STDString& json);
+
+void Base64Encode(StringView data, STDString& out);
+bool Base64Decode(StringView data, STDString& out);
+
+END_NS()
@@ -0,0 +1,673 @@
+#include <Lua/Libs/BinaryValue.h>
+
+#include <unordered_map>
+#include <json/json.h>
+
+BEGIN_NS(lua::binary)
+
+enum class BinaryValueTag : uint8_t
+{
+	Nil = 0,
+	False = 1,
+	True = 2,
+	// Zigzag varint
+	Int = 3,
+	Double = 4,
+	// Varint length + bytes; each string is added to the string table of the blob
+	String = 5,
+	// Varint index of a previously seen string
+	StringRef = 6,
+	// Canonical lowercase UUID strings, stored as 16 bytes
+	Guid = 7,
+	// Entity, stored as the 16 byte UUID of the entity (entity handles are not stable across peers/savegames)
+	Entity = 8,
+	// Varint count + values; tables with keys 1..n
+	Array = 9,
+	// Varint count + key/value pairs
+	Map = 10,
+	// Tags >= FixInt store integers in the range 0..127 inline
+	FixInt = 0x80
+};
+
+class BinaryValueWriter
+{
+public:
+	inline BinaryValueWriter(lua_State* L, STDString& out)
+		: L_(L), out_(out)
+	{}
+
+	void WriteHeader()
+	{
+		WriteByte(BinaryValueMarker);
+		WriteByte(BinaryValueVersion);
+	}
+
+	void Write(int index, uint32_t depth)
+	{
+		if (depth > MaxSerializationDepth) {
+			throw std::runtime_error("Recursion depth exceeded while serializing value");
+		}
+
+		index = lua_absindex(L_, index);
+		switch (lua_type(L_, index)) {
+		case LUA_TNIL:
+			WriteTag(BinaryValueTag::Nil);
+			break;
+
+		case LUA_TBOOLEAN:
+			WriteTag(lua_toboolean(L_, index) ? BinaryValueTag::True : BinaryValueTag::False);
+			break;
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L_, index)) {
+				WriteInt(lua_tointeger(L_, index));
+			} else {
+				WriteDouble(lua_tonumber(L_, index));
+			}
+			break;
+
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto str = lua_tolstring(L_, index, &len);
+			WriteString(StringView(str, len));
+			break;
+		}
+
+		case LUA_TTABLE:
+			WriteTable(index, depth);
+			break;
+
+		case LUA_TUSERDATA:
+		case LUA_TLIGHTCPPOBJECT:
+		case LUA_TCPPOBJECT:
+			WriteCppValue(index);
+			break;
+
+		case LUA_TLIGHTUSERDATA:
+		case LUA_TFUNCTION:
+		case LUA_TTHREAD:
+		default:
+			throw std::runtime_error("Attempted to serialize a lightuserdata, userdata, function or thread value");
+		}
+	}
+
+private:
+	lua_State* L_;
+	STDString& out_;
+	// Strings are referenced by the string table while they're being serialized;
+	// since the root value is on the stack, none of them can be collected until we're done
+	std::unordered_map<StringView, uint32_t> strings_;
+
+	inline void WriteByte(uint8_t v)
+	{
+		out_.push_back((char)v);
+	}
+
+	inline void WriteTag(BinaryValueTag tag)
+	{
+		WriteByte((uint8_t)tag);
+	}
+
+	void WriteVarint(uint64_t v)
+	{
+		while (v >= 0x80) {
+			WriteByte((uint8_t)(v | 0x80));
+			v >>= 7;
+		}
+
+		WriteByte((uint8_t)v);
+	}
+
+	void WriteInt(int64_t v)
+	{
+		if (v >= 0 && v < 0x80) {
+			WriteByte((uint8_t)BinaryValueTag::FixInt | (uint8_t)v);
+		} else {
+			WriteTag(BinaryValueTag::Int);
+			WriteVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+		}
+	}
+
+	void WriteDouble(double v)
+	{
+		WriteTag(BinaryValueTag::Double);
+		out_.append(reinterpret_cast<char const*>(&v), sizeof(v));
+	}
+
+	void WriteGuid(BinaryValueTag tag, Guid const& guid)
+	{
+		WriteTag(tag);
+		out_.append(reinterpret_cast<char const*>(&guid.Val[0]), sizeof(guid.Val));
+	}
+
+	// Expects a null-terminated string (Lua and FixedString strings are)
+	void WriteString(StringView s)
+	{
+		if (s.size() == 36 && s[8] == '-' && s[13] == '-' && s[18] == '-' && s[23] == '-') {
+			auto guid = Guid::Parse(s);
+			// Only strings that round trip exactly can be stored as a UUID
+			if (guid && StringView(guid->ToString()) == s) {
+				WriteGuid(BinaryValueTag::Guid, *guid);
+				return;
+			}
+		}
+
+		auto it = strings_.find(s);
+		if (it != strings_.end()) {
+			WriteTag(BinaryValueTag::StringRef);
+			WriteVarint(it->second);
+		} else {
+			WriteTag(BinaryValueTag::String);
+			WriteVarint(s.size());
+			out_.append(s.data(), s.size());
+			strings_.insert(std::make_pair(s, (uint32_t)strings_.size()));
+		}
+	}
+
+	void WriteFixedString(FixedString const& s)
+	{
+		WriteString(StringView(s.GetString(), s.GetLength()));
+	}
+
+	void WriteTable(int index, uint32_t depth)
+	{
+		if (!lua_checkstack(L_, 3)) {
+			throw std::runtime_error("Stack overflow while serializing value");
+		}
+
+		uint32_t count = 0;
+		lua_Integer maxKey = 0;
+		bool isArray = true;
+		lua_pushnil(L_);
+		while (lua_next(L_, index) != 0) {
+			count++;
+			if (isArray && lua_isinteger(L_, -2)) {
+				auto key = lua_tointeger(L_, -2);
+				if (key < 1) {
+					isArray = false;
+				} else if (key > maxKey) {
+					maxKey = key;
+				}
+			} else {
+				isArray = false;
+			}
+
+			lua_pop(L_, 1);
+		}
+
+		// Keys are unique, so count positive integer keys with a maximum of count must be exactly 1..count
+		if (isArray && maxKey == count) {
+			WriteTag(BinaryValueTag::Array);
+			WriteVarint(count);
+			for (uint32_t i = 1; i <= count; i++) {
+				lua_rawgeti(L_, index, i);
+				Write(-1, depth + 1);
+				lua_pop(L_, 1);
+			}
+		} else {
+			WriteTag(BinaryValueTag::Map);
+			WriteVarint(count);
+			lua_pushnil(L_);
+			while (lua_next(L_, index) != 0) {
+				auto keyType = lua_type(L_, -2);
+				if (keyType != LUA_TSTRING && keyType != LUA_TNUMBER && keyType != LUA_TBOOLEAN) {
+					throw std::runtime_error("Can only serialize string, number or boolean table keys");
+				}
+
+				Write(-2, depth + 1);
+				Write(-1, depth + 1);
+				lua_pop(L_, 1);
+			}
+		}
+	}
+
+	void WriteCppValue(int index)
+	{
+		CppValueMetadata meta;
+		if (lua_try_get_cppvalue(L_, index, EnumValueMetatable::MetaTag, meta)) {
+			WriteFixedString(EnumValueMetatable::GetLabel(meta));
+			return;
+		}
+
+		if (lua_try_get_cppvalue(L_, index, BitfieldValueMetatable::MetaTag, meta)) {
+			auto labels = BitfieldValueMetatable::ToJson(meta);
+			WriteTag(BinaryValueTag::Array);
+			WriteVarint(labels.size());
+			for (auto const& label : labels) {
+				WriteFixedString(FixedString(label.asCString()));
+			}
+			return;
+		}
+
+		if (lua_try_get_cppvalue(L_, index, EntityProxyMetatable::MetaTag, meta)) {
+			auto uuid = entity::HandleToUuid(L_, EntityProxyMetatable::GetHandle(meta));
+			if (!uuid) {
+				throw std::runtime_error("Only entities that have a UUID can be serialized");
+			}
+
+			WriteGuid(BinaryValueTag::Entity, *uuid);
+			return;
+		}
+
+		throw std::runtime_error("Attempted to serialize a lightuserdata, userdata, function or thread value");
+	}
+};
+
+class BinaryValueReader
+{
+public:
+	inline BinaryValueReader(StringView blob)
+		: cur_(reinterpret_cast<uint8_t const*>(blob.data())),
+		end_(reinterpret_cast<uint8_t const*>(blob.data() + blob.size()))
+	{}
+
+	bool ReadHeader()
+	{
+		uint8_t marker, version;
+		return ReadByte(marker) && marker == BinaryValueMarker
+			&& ReadByte(version) && version == BinaryValueVersion;
+	}
+
+	inline bool AtEnd() const
+	{
+		return cur_ == end_;
+	}
+
+	inline uint64_t Remaining() const
+	{
+		return (uint64_t)(end_ - cur_);
+	}
+
+	inline bool ReadByte(uint8_t& v)
+	{
+		if (cur_ == end_) return false;
+		v = *cur_++;
+		return true;
+	}
+
+	bool ReadVarint(uint64_t& v)
+	{
+		v = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			uint8_t b;
+			if (!ReadByte(b)) return false;
+			v |= (uint64_t)(b & 0x7f) << shift;
+			if ((b & 0x80) == 0) return true;
+		}
+
+		return false;
+	}
+
+	bool ReadInt(int64_t& v)
+	{
+		uint64_t zz;
+		if (!ReadVarint(zz)) return false;
+		v = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+		return true;
+	}
+
+	bool ReadDouble(double& v)
+	{
+		if (Remaining() < sizeof(v)) return false;
+		memcpy(&v, cur_, sizeof(v));
+		cur_ += sizeof(v);
+		return true;
+	}
+
+	bool ReadGuid(Guid& v)
+	{
+		if (Remaining() < sizeof(v.Val)) return false;
+		memcpy(&v.Val[0], cur_, sizeof(v.Val));
+		cur_ += sizeof(v.Val);
+		return true;
+	}
+
+	bool ReadString(BinaryValueTag tag, StringView& v)
+	{
+		uint64_t val;
+		if (!ReadVarint(val)) return false;
+
+		if (tag == BinaryValueTag::StringRef) {
+			if (val >= strings_.size()) return false;
+			v = strings_[(uint32_t)val];
+		} else {
+			if (val > Remaining()) return false;
+			v = StringView(reinterpret_cast<char const*>(cur_), (std::size_t)val);
+			cur_ += val;
+			strings_.push_back(v);
+		}
+
+		return true;
+	}
+
+private:
+	uint8_t const* cur_;
+	uint8_t const* end_;
+	Array<StringView> strings_;
+};
+
+class BinaryValueLuaDecoder
+{
+public:
+	inline BinaryValueLuaDecoder(lua_State* L, BinaryValueReader& reader)
+		: L_(L), reader_(reader)
+	{}
+
+	bool Read(uint32_t depth)
+	{
+		uint8_t tag;
+		if (depth > MaxSerializationDepth || !reader_.ReadByte(tag)) return false;
+
+		if (tag >= (uint8_t)BinaryValueTag::FixInt) {
+			push(L_, (int64_t)(tag & 0x7f));
+			return true;
+		}
+
+		switch ((BinaryValueTag)tag) {
+		case BinaryValueTag::Nil:
+			lua_pushnil(L_);
+			return true;
+
+		case BinaryValueTag::False:
+		case BinaryValueTag::True:
+			push(L_, (BinaryValueTag)tag == BinaryValueTag::True);
+			return true;
+
+		case BinaryValueTag::Int:
+		{
+			int64_t v;
+			if (!reader_.ReadInt(v)) return false;
+			push(L_, v);
+			return true;
+		}
+
+		case BinaryValueTag::Double:
+		{
+			double v;
+			if (!reader_.ReadDouble(v)) return false;
+			push(L_, v);
+			return true;
+		}
+
+		case BinaryValueTag::String:
+		case BinaryValueTag::StringRef:
+		{
+			StringView v;
+			if (!reader_.ReadString((BinaryValueTag)tag, v)) return false;
+			lua_pushlstring(L_, v.data(), v.size());
+			return true;
+		}
+
+		case BinaryValueTag::Guid:
+		{
+			Guid v;
+			if (!reader_.ReadGuid(v)) return false;
+			push(L_, v);
+			return true;
+		}
+
+		case BinaryValueTag::Entity:
+		{
+			Guid v;
+			if (!reader_.ReadGuid(v)) return false;
+			auto handle = entity::UuidToHandle(L_, v);
+			if (handle) {
+				EntityProxyMetatable::Make(L_, handle);
+			} else {
+				lua_pushnil(L_);
+			}
+			return true;
+		}
+
+		case BinaryValueTag::Array:
+		case BinaryValueTag::Map:
+			return ReadTable((BinaryValueTag)tag, depth);
+
+		default:
+			return false;
+		}
+	}
+
+private:
+	lua_State* L_;
+	BinaryValueReader& reader_;
+
+	bool ReadTable(BinaryValueTag tag, uint32_t depth)
+	{
+		uint64_t count;
+		// Each value takes at least one byte; reject counts that can't be satisfied before preallocating
+		if (!reader_.ReadVarint(count) || count > reader_.Remaining() || !lua_checkstack(L_, 3)) return false;
+
+		if (tag == BinaryValueTag::Array) {
+			lua_createtable(L_, (int)count, 0);
+			for (uint64_t i = 1; i <= count; i++) {
+				if (!Read(depth + 1)) return false;
+				lua_rawseti(L_, -2, (lua_Integer)i);
+			}
+		} else {
+			lua_createtable(L_, 0, (int)count);
+			for (uint64_t i = 0; i < count; i++) {
+				if (!Read(depth + 1)) return false;
+				if (lua_isnil(L_, -1) || (lua_type(L_, -1) == LUA_TNUMBER && !lua_isinteger(L_, -1) && std::isnan(lua_tonumber(L_, -1)))) {
+					return false;
+				}
+
+				if (!Read(depth + 1)) return false;
+				lua_rawset(L_, -3);
+			}
+		}
+
+		return true;
+	}
+};
+
+class BinaryValueJsonDecoder
+{
+public:
+	inline BinaryValueJsonDecoder(BinaryValueReader& reader)
+		: reader_(reader)
+	{}
+
+	bool Read(Json::Value& val, uint32_t depth)
+	{
+		uint8_t tag;
+		if (depth > MaxSerializationDepth || !reader_.ReadByte(tag)) return false;
+
+		if (tag >= (uint8_t)BinaryValueTag::FixInt) {
+			val = Json::Value((Json::Int64)(tag & 0x7f));
+			return true;
+		}
+
+		switch ((BinaryValueTag)tag) {
+		case BinaryValueTag::Nil:
+			val = Json::Value(Json::nullValue);
+			return true;
+
+		case BinaryValueTag::False:
+		case BinaryValueTag::True:
+			val = Json::Value((BinaryValueTag)tag == BinaryValueTag::True);
+			return true;
+
+		case BinaryValueTag::Int:
+		{
+			int64_t v;
+			if (!reader_.ReadInt(v)) return false;
+			val = Json::Value((Json::Int64)v);
+			return true;
+		}
+
+		case BinaryValueTag::Double:
+		{
+			double v;
+			if (!reader_.ReadDouble(v)) return false;
+			val = Json::Value(v);
+			return true;
+		}
+
+		case BinaryValueTag::String:
+		case BinaryValueTag::StringRef:
+		{
+			StringView v;
+			if (!reader_.ReadString((BinaryValueTag)tag, v)) return false;
+			val = Json::Value(v.data(), v.data() + v.size());
+			return true;
+		}
+
+		case BinaryValueTag::Guid:
+		case BinaryValueTag::Entity:
+		{
+			Guid v;
+			if (!reader_.ReadGuid(v)) return false;
+			val = Json::Value(v.ToString().c_str());
+			return true;
+		}
+
+		case BinaryValueTag::Array:
+		{
+			uint64_t count;
+			if (!reader_.ReadVarint(count) || count > reader_.Remaining()) return false;
+			val = Json::Value(Json::arrayValue);
+			for (uint64_t i = 0; i < count; i++) {
+				if (!Read(val.append(Json::Value()), depth + 1)) return false;
+			}
+			return true;
+		}
+
+		case BinaryValueTag::Map:
+		{
+			uint64_t count;
+			if (!reader_.ReadVarint(count) || count > reader_.Remaining()) return false;
+			val = Json::Value(Json::objectValue);
+			for (uint64_t i = 0; i < count; i++) {
+				Json::Value key, value;
+				if (!Read(key, depth + 1) || !Read(value, depth + 1)) return false;
+
+				// Same key conversion as Json.Stringify()
+				switch (key.type()) {
+				case Json::stringValue: val[key.asString()] = value; break;
+				case Json::intValue: val[std::to_string(key.asInt64())] = value; break;
+				case Json::realValue:
+				{
+					char buf[32];
+					sprintf_s(buf, "%.14g", key.asDouble());
+					val[buf] = value;
+					break;
+				}
+				case Json::booleanValue: val[key.asBool() ? "true" : "false"] = value; break;
+				default: return false;
+				}
+			}
+			return true;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+private:
+	BinaryValueReader& reader_;
+};
+
+bool IsBinaryValue(StringView blob)
+{
+	return blob.size() >= 2 && (uint8_t)blob[0] == BinaryValueMarker;
+}
+
+void Serialize(lua_State* L, int index, STDString& blob)
+{
+	StackCheck _(L);
+	blob.clear();
+	BinaryValueWriter writer(L, blob);
+	writer.WriteHeader();
+	writer.Write(index, 0);
+}
+
+bool Deserialize(lua_State* L, StringView blob)
+{
+	auto top = lua_gettop(L);
+	BinaryValueReader reader(blob);
+	BinaryValueLuaDecoder decoder(L, reader);
+	if (!reader.ReadHeader() || !decoder.Read(0) || !reader.AtEnd()) {
+		ERR("Unable to parse binary value: blob is malformed");
+		lua_settop(L, top);
+		return false;
+	}
+
+	return true;
+}
+
+bool ToJson(StringView blob, STDString& json)
+{
+	BinaryValueReader reader(blob);
+	BinaryValueJsonDecoder decoder(reader);
+	Json::Value root;
+	if (!reader.ReadHeader() || !decoder.Read(root, 0) || !reader.AtEnd()) {
+		return false;
+	}
+
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = "";
+	std::stringstream ss;
+	std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+	writer->write(root, &ss);
+	json = ss.str();
+	return true;
+}
+
+static constexpr char Base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void Base64Encode(StringView data, STDString& out)
+{
+	out.reserve(out.size() + (data.size() + 2) / 3 * 4);
+	auto p = reinterpret_cast<uint8_t const*>(data.data());
+	std::size_t i = 0;
+	for (; i + 2 < data.size(); i += 3) {
+		uint32_t v = (p[i] << 16) | (p[i + 1] << 8) | p[i + 2];
+		out.push_back(Base64Chars[(v >> 18) & 0x3f]);
+		out.push_back(Base64Chars[(v >> 12) & 0x3f]);
+		out.push_back(Base64Chars[(v >> 6) & 0x3f]);
+		out.push_back(Base64Chars[v & 0x3f]);
+	}
+
+	if (i < data.size()) {
+		uint32_t v = p[i] << 16;
+		if (i + 1 < data.size()) v |= p[i + 1] << 8;
+		out.push_back(Base64Chars[(v >> 18) & 0x3f]);
+		out.push_back(Base64Chars[(v >> 12) & 0x3f]);
+		out.push_back(i + 1 < data.size() ? Base64Chars[(v >> 6) & 0x3f] : '=');
+		out.push_back('=');
+	}
+}
+
+bool Base64Decode(StringView data, STDString& out)
+{
+	if (data.size() % 4 != 0) return false;
+
+	out.reserve(out.size() + data.size() / 4 * 3);
+	uint32_t v = 0;
+	unsigned bits = 0;
+	for (std::size_t i = 0; i < data.size(); i++) {
+		auto ch = data[i];
+		uint32_t digit;
+		if (ch >= 'A' && ch <= 'Z') digit = ch - 'A';
+		else if (ch >= 'a' && ch <= 'z') digit = ch - 'a' + 26;
+		else if (ch >= '0' && ch <= '9') digit = ch - '0' + 52;
+		else if (ch == '+') digit = 62;
+		else if (ch == '/') digit = 63;
+		else if (ch == '=' && i + 2 >= data.size()) break;
+		else return false;
+
+		v = (v << 6) | digit;
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			out.push_back((char)((v >> bits) & 0xff));
+		}
+	}
+
+	return true;
+}
+
+END_NS()
@@ -3,16 +3,22 @@ BEGIN_NS(ecl::lua::net)
 
 void PostMessageToServer(char const* channel, char const* payload)
 {
-	auto & networkMgr = gExtender->GetClient().GetNetworkManager();
-	auto msg = networkMgr.GetFreeMessage();
-	if (msg != nullptr) {
-		auto postMsg = msg->GetMessage().mutable_post_lua();
-		postMsg->set_channel_name(channel);
-		postMsg->set_payload(payload);
-		networkMgr.Send(msg);
-	} else {
-		OsiErrorS("Could not get free message!");
-	}
+	gExtender->GetClient().GetNetworkManager().PostLuaMessage(channel, payload, strlen(payload));
+}
+
+void SetBatchedChannel(FixedString const& channel, bool batched)
+{
+	gExtender->GetClient().GetNetworkManager().GetBatcher().SetChannelBatched(channel, batched);
+}
+
+UserReturn GetBatchStats(lua_State* L)
+{
+	auto const& stats = gExtender->GetClient().GetNetworkManager().GetBatcher().GetStats();
+	lua_createtable(L, 0, 3);
+	setfield(L, "BatchedMessages", stats.BatchedMessages);
+	setfield(L, "SentBatches", stats.SentBatches);
+	setfield(L, "MessagesSaved", stats.MessagesSaved);
+	return 1;
 }
 
 
@@ -21,6 +27,8 @@ void RegisterNetLib()
 	DECLARE_MODULE(Net, Client)
 	BEGIN_MODULE()
 	MODULE_FUNCTION(PostMessageToServer)
+	MODULE_FUNCTION(SetBatchedChannel)
+	MODULE_FUNCTION(GetBatchStats)
 	END_MODULE()
 }
 
@@ -1,4 +1,5 @@
 #include <Extender/ScriptExtender.h>
+#include <random>
 
 /// <lua_module>Debug</lua_module>
 BEGIN_NS(lua::debug)
@@ -36,6 +37,341 @@ void DebugDumpLifetimes(lua_State* L)
 	std::cout << "L2: " << l2free << " free pages, " << l2partial << " partially saturated pages, " << l2full << " full pages" << std::endl;
 	std::cout << "L3: " << l3free << " free pages, " << l3partial << " partially saturated pages, " << l3full << " full pages" << std::endl;
 	std::cout << "Objects: " << 262144 << " in pool, " << totalObjs << " free" << std::endl;
+	std::cout << "Blocks: " << pool.NumCommittedBlocks() << " of " << pool.NumBlocks << " committed" << std::endl;
+}
+
+template <class TAllocator>
+void BenchmarkLifetimeAllocator(char const* name, TAllocator& allocator, unsigned iterations, unsigned depth)
+{
+	using namespace std::chrono;
+
+	Array<Lifetime*> frames;
+	frames.resize(depth);
+
+	auto start = high_resolution_clock::now();
+	for (unsigned i = 0; i < iterations; i++) {
+		for (unsigned j = 0; j < depth; j++) {
+			frames[j] = allocator.Allocate();
+		}
+
+		for (unsigned j = depth; j > 0; j--) {
+			allocator.Free(frames[j - 1]);
+		}
+	}
+	auto end = high_resolution_clock::now();
+
+	auto ops = (std::size_t)iterations * depth;
+	INFO("%s: %d x %d lifetimes; %.2f ns/allocate+free", name, iterations, depth,
+		ops ? (double)duration_cast<nanoseconds>(end - start).count() / ops : 0.0);
+}
+
+// Development-only function for measuring lifetime churn from nested LifetimeStackPin frames
+void BenchmarkLifetimes(lua_State* L, std::optional<uint32_t> numIterations, std::optional<uint32_t> frameDepth)
+{
+	using namespace std::chrono;
+
+	auto iterations = numIterations.value_or(100000);
+	auto depth = std::min(frameDepth.value_or(8), 0x800u);
+
+	auto& stack = State::FromLua(L)->GetStack();
+	auto start = high_resolution_clock::now();
+	for (unsigned i = 0; i < iterations; i++) {
+		for (unsigned j = 0; j < depth; j++) {
+			stack.Push();
+		}
+
+		for (unsigned j = 0; j < depth; j++) {
+			stack.PopAndKill();
+		}
+	}
+	auto end = high_resolution_clock::now();
+
+	auto ops = (std::size_t)iterations * depth;
+	INFO("LifetimeStack: %d x %d frames; %.2f ns/push+pop", iterations, depth,
+		ops ? (double)duration_cast<nanoseconds>(end - start).count() / ops : 0.0);
+
+	auto localPool = std::make_unique<HierarchicalPoolAllocator<Lifetime, LifetimeHandle::MaxPoolSize>>();
+	BenchmarkLifetimeAllocator("HierarchicalPoolAllocator", *localPool, iterations, depth);
+}
+
+UserReturn GetStringCacheStats(lua_State* L)
+{
+	auto const& stats = lua_get_string_cache_stats(L);
+	lua_createtable(L, 0, 6);
+	setfield(L, "DeferredStrings", stats.DeferredStrings);
+	setfield(L, "AttachedStrings", stats.AttachedStrings);
+	setfield(L, "LazyInterns", stats.LazyInterns);
+	setfield(L, "LazyLookups", stats.LazyLookups);
+	setfield(L, "UncachedInterns", stats.UncachedInterns);
+	setfield(L, "CacheHits", stats.CacheHits);
+	return 1;
+}
+
+UserReturn GetPropertyCacheStats(lua_State* L)
+{
+	auto const& cache = State::FromLua(L)->GetPropertyAccessCache();
+	lua_createtable(L, 0, 3);
+	setfield(L, "Hits", cache.Hits);
+	setfield(L, "Misses", cache.Misses);
+	setfield(L, "Evictions", cache.Evictions);
+	return 1;
+}
+
+UserReturn GetEventStats(lua_State* L)
+{
+	auto const& events = State::FromLua(L)->GetEventManager().GetEvents();
+	lua_createtable(L, 0, (int)events.size());
+	for (auto const& event : events) {
+		auto const& stats = event->GetStats();
+		lua_createtable(L, 0, 6);
+		setfield(L, "Subscribers", event->NumSubscribers());
+		setfield(L, "Dispatches", stats.Dispatches);
+		setfield(L, "HandlerCalls", stats.HandlerCalls);
+		setfield(L, "HandlerErrors", stats.HandlerErrors);
+		setfield(L, "TotalTime", stats.TotalTime);
+		setfield(L, "MaxTime", stats.MaxTime);
+		lua_setfield(L, -2, event->GetName().GetString());
+	}
+
+	return 1;
+}
+
+void ResetEventStats(lua_State* L)
+{
+	for (auto const& event : State::FromLua(L)->GetEventManager().GetEvents()) {
+		event->ResetStats();
+	}
+}
+
+template <class TMap, class TKey>
+void BenchmarkMap(char const* name, Array<TKey> const& keys, Array<TKey> const& missingKeys, unsigned rounds)
+{
+	using namespace std::chrono;
+
+	TMap map;
+	auto insertStart = high_resolution_clock::now();
+	for (auto const& key : keys) {
+		map.set(key, 1);
+	}
+	auto insertEnd = high_resolution_clock::now();
+
+	uint64_t found{ 0 };
+	for (unsigned i = 0; i < rounds; i++) {
+		for (auto const& key : keys) {
+			found += map.try_get(key) ? 1 : 0;
+		}
+	}
+	auto hitEnd = high_resolution_clock::now();
+
+	for (unsigned i = 0; i < rounds; i++) {
+		for (auto const& key : missingKeys) {
+			found += map.try_get(key) ? 1 : 0;
+		}
+	}
+	auto missEnd = high_resolution_clock::now();
+
+	auto perOp = [](auto start, auto end, std::size_t ops) {
+		return ops ? (double)duration_cast<nanoseconds>(end - start).count() / ops : 0.0;
+	};
+
+	INFO("%s: %zu keys; insert %.2f ns/op, hit %.2f ns/op, miss %.2f ns/op (%llu found)", name, (std::size_t)keys.size(),
+		perOp(insertStart, insertEnd, keys.size()),
+		perOp(insertEnd, hitEnd, (std::size_t)keys.size() * rounds),
+		perOp(hitEnd, missEnd, (std::size_t)missingKeys.size() * rounds),
+		(unsigned long long)found);
+}
+
+template <class TKey>
+void BenchmarkMapPair(char const* keyType, Array<TKey> const& keys, Array<TKey> const& missingKeys, unsigned rounds)
+{
+	STDString name = STDString("MultiHashMap<") + keyType + ">";
+	BenchmarkMap<MultiHashMap<TKey, int32_t>>(name.c_str(), keys, missingKeys, rounds);
+	name = STDString("FlatHashMap<") + keyType + ">";
+	BenchmarkMap<FlatHashMap<TKey, int32_t>>(name.c_str(), keys, missingKeys, rounds);
+}
+
+// Development-only function for comparing extender-owned hash map implementations
+void BenchmarkHashMaps(std::optional<uint32_t> numKeys, std::optional<uint32_t> numRounds)
+{
+	auto count = numKeys.value_or(10000);
+	auto rounds = numRounds.value_or(100);
+	std::mt19937_64 rng(count);
+
+	Array<int32_t> ints, missingInts;
+	for (uint32_t i = 0; i < count; i++) {
+		ints.push_back((int32_t)(rng() & 0x7fffffff));
+		missingInts.push_back(-1 - (int32_t)(rng() & 0x7fffffff));
+	}
+
+	Array<Guid> guids, missingGuids;
+	for (uint32_t i = 0; i < count; i++) {
+		guids.push_back(Guid{ rng(), rng() });
+		missingGuids.push_back(Guid{ rng(), rng() });
+	}
+
+	// Use property names for FixedString keys to avoid creating new GST entries;
+	// every second distinct name is used as a missing key
+	Array<FixedString> strings, missingStrings;
+	MultiHashSet<FixedString> seen;
+	for (auto pm : gExtender->GetPropertyMapManager().GetPropertyMaps()) {
+		for (auto const& prop : pm->Properties.keys()) {
+			if (!seen.contains(prop)) {
+				seen.insert(prop);
+				((seen.size() & 1) ? strings : missingStrings).push_back(prop);
+			}
+		}
+	}
+
+	BenchmarkMapPair("int32", ints, missingInts, rounds);
+	BenchmarkMapPair("Guid", guids, missingGuids, rounds);
+	BenchmarkMapPair("FixedString", strings, missingStrings, rounds);
+}
+
+std::vector<uint8_t const*> ScanSinglePattern(Pattern const& pattern, uint8_t const* start, std::size_t size)
+{
+	std::vector<uint8_t const*> matches;
+	pattern.Scan(start, size, [&matches](uint8_t const* match) {
+		matches.push_back(match);
+		return Pattern::ScanAction::Continue;
+	});
+	return matches;
+}
+
+// Development-only function for checking MultiPatternScanner results on synthetic data.
+// Matches are checked against both the expected offsets and the results of Pattern::Scan().
+bool TestPatternScanner()
+{
+	struct TestPattern
+	{
+		char const* Name;
+		char const* Bytes;
+		std::vector<std::size_t> Offsets;
+		Pattern Compiled;
+		MultiPatternScanner::PatternId Id;
+	};
+
+	// 4 chunks of 1 MB each when scanning with 4 threads
+	constexpr std::size_t ChunkSize = 0x100000;
+	std::vector<uint8_t> buf(ChunkSize * 4);
+	auto size = buf.size();
+
+	// Filler bytes never match the first byte of any test pattern
+	std::mt19937 rng(1);
+	for (auto& b : buf) {
+		b = (uint8_t)(rng() & 0x3f);
+	}
+
+	auto plant = [&buf](std::size_t offset, std::initializer_list<uint8_t> bytes) {
+		std::copy(bytes.begin(), bytes.end(), buf.begin() + offset);
+	};
+
+	// Wildcard bytes are left as filler
+	plant(0x1000, { 0xE8 });
+	plant(0x1005, { 0x48, 0x8B, 0xC8 });
+	// Match across the first chunk seam
+	plant(ChunkSize - 4, { 0x48, 0x8B, 0x05 });
+	plant(ChunkSize + 3, { 0x48, 0x85, 0xC0 });
+	// Match starting on the last byte of the second chunk; the 16-bit prefix spans the seam
+	plant(ChunkSize * 2 - 1, { 0xE8 });
+	plant(ChunkSize * 2 + 4, { 0x48, 0x8B, 0xC8 });
+	// Self-overlapping matches across the third chunk seam
+	plant(ChunkSize * 3 - 3, { 0x90, 0x90, 0x90, 0x90, 0x90, 0x90 });
+	plant(0x2000, { 0xC3 });
+	// Match at the last position accepted by Pattern::Scan(); a match on the last byte isn't reported by either scanner
+	plant(size - 11, { 0x48, 0x8B, 0x05 });
+	plant(size - 4, { 0x48, 0x85, 0xC0 });
+	plant(size - 1, { 0xC3 });
+
+	std::vector<TestPattern> patterns{
+		{ "Wildcard", "E8 ?? ?? ?? ?? 48 8B C8 ", { 0x1000, ChunkSize * 2 - 1 } },
+		{ "Seam", "48 8B 05 ?? ?? ?? ?? 48 85 C0 ", { ChunkSize - 4, size - 11 } },
+		// Prefix of the previous pattern, so both match at the same positions
+		{ "Overlapping", "48 8B 05 ", { ChunkSize - 4, size - 11 } },
+		{ "SelfOverlapping", "90 90 90 90 ", { ChunkSize * 3 - 3, ChunkSize * 3 - 2, ChunkSize * 3 - 1 } },
+		{ "SingleByte", "C3 ", { 0x2000 } }
+	};
+
+	for (auto& pattern : patterns) {
+		if (!pattern.Compiled.FromString(pattern.Bytes)) {
+			ERR("TestPatternScanner(): Failed to parse pattern '%s'", pattern.Name);
+			return false;
+		}
+	}
+
+	bool passed = true;
+	auto check = [&](TestPattern const& pattern, std::vector<uint8_t const*> const& matches, char const* scanType) {
+		std::vector<uint8_t const*> expected;
+		for (auto offset : pattern.Offsets) {
+			expected.push_back(buf.data() + offset);
+		}
+
+		if (matches != expected) {
+			ERR("TestPatternScanner(): %s scan of pattern '%s' returned %zu matches, expected %zu",
+				scanType, pattern.Name, matches.size(), expected.size());
+			passed = false;
+		}
+	};
+
+	for (auto numThreads : { 1u, 4u }) {
+		MultiPatternScanner scanner;
+		for (auto& pattern : patterns) {
+			pattern.Id = scanner.Add(pattern.Compiled);
+		}
+
+		scanner.Scan(buf.data(), size, numThreads);
+		for (auto const& pattern : patterns) {
+			check(pattern, scanner.GetMatches(pattern.Id), numThreads == 1 ? "Single-chunk" : "Multi-chunk");
+		}
+	}
+
+	for (auto const& pattern : patterns) {
+		check(pattern, ScanSinglePattern(pattern.Compiled, buf.data(), size), "Single pattern");
+	}
+
+	return passed;
+}
+
+// Development-only function for comparing MultiPatternScanner with per-pattern scans over the game binary
+void BenchmarkPatternScanner(std::optional<uint32_t> numThreads)
+{
+	using namespace std::chrono;
+
+	auto& libraryMgr = gExtender->GetLibraryManager();
+	auto const& modules = libraryMgr.Mapper().Modules();
+	auto module = modules.find("Main");
+	if (module == modules.end()) {
+		OsiError("Main module was not found");
+		return;
+	}
+
+	MultiPatternScanner scanner;
+	std::vector<Pattern const*> patterns;
+	for (auto const& mapping : libraryMgr.Mappings().Mappings) {
+		if (mapping.second.Module == "Main" && mapping.second.Scope == SymbolMappings::MatchScope::kText) {
+			patterns.push_back(&mapping.second.Pattern);
+			scanner.Add(mapping.second.Pattern);
+		}
+	}
+
+	auto textStart = module->second.ModuleTextStart;
+	auto textSize = module->second.ModuleTextSize;
+	auto multiStart = high_resolution_clock::now();
+	scanner.Scan(textStart, textSize, numThreads.value_or(0));
+	auto multiEnd = high_resolution_clock::now();
+
+	std::size_t mismatches{ 0 };
+	for (uint32_t i = 0; i < patterns.size(); i++) {
+		if (ScanSinglePattern(*patterns[i], textStart, textSize) != scanner.GetMatches(i)) {
+			mismatches++;
+		}
+	}
+	auto singleEnd = high_resolution_clock::now();
+
+	INFO("%zu patterns in %zu KB: multi-pattern scan %lld us, per-pattern scan %lld us (%zu mismatches)",
+		patterns.size(), textSize / 1024,
+		(int64_t)duration_cast<microseconds>(multiEnd - multiStart).count(),
+		(int64_t)duration_cast<microseconds>(singleEnd - multiEnd).count(),
+		mismatches);
 }
 
 void DumpStack(lua_State* L)
@@ -276,6 +612,14 @@ void RegisterDebugLib()
 	BEGIN_MODULE()
 	MODULE_FUNCTION(DumpStack)
 	MODULE_FUNCTION(DebugDumpLifetimes)
+	MODULE_FUNCTION(GetStringCacheStats)
+	MODULE_FUNCTION(GetPropertyCacheStats)
+	MODULE_FUNCTION(GetEventStats)
+	MODULE_FUNCTION(ResetEventStats)
+	MODULE_FUNCTION(BenchmarkHashMaps)
+	MODULE_FUNCTION(TestPatternScanner)
+	MODULE_FUNCTION(BenchmarkPatternScanner)
+	MODULE_FUNCTION(BenchmarkLifetimes)
 	MODULE_FUNCTION(GenerateIdeHelpers)
 	MODULE_NAMED_FUNCTION("DebugBreak", LuaDebugBreak)
 	MODULE_FUNCTION(IsDeveloperMode)
@@ -47,17 +47,166 @@ Array<EntityHandle> GetAllEntitiesWithComponent(lua_State* L, ExtComponentType c
 	auto componentType = ecs->GetComponentIndex(component);
 	if (!componentType) return {};
 
+	auto classes = ecs->GetEntityClassesWithComponent(*componentType);
+	uint32_t numEntities = 0;
+	for (auto const& entry : classes) {
+		numEntities += entry.Class->InstanceToPageMap.size();
+	}
+
 	Array<EntityHandle> entities;
-	auto world = State::FromLua(L)->GetEntitySystemHelpers()->GetEntityWorld();
-	for (auto cls : world->EntityTypes->EntityClasses) {
-		if (cls->ComponentTypeToIndex.try_get(*componentType)) {
-			std::copy(cls->InstanceToPageMap.keys().begin(), cls->InstanceToPageMap.keys().end(), std::back_inserter(entities));
+	entities.reserve(numEntities);
+	for (auto const& entry : classes) {
+		for (auto const& handle : entry.Class->InstanceToPageMap.keys()) {
+			entities.push_back(handle);
 		}
 	}
 
 	return entities;
 }
 
+// Stateless iterator function for IterateEntitiesWithComponent.
+// The control variable is a cursor encoding the index of the entity class (high 32 bits)
+// and the index of the next instance within that class (low 32 bits).
+int EntityComponentIteratorNext(lua_State* L)
+{
+	auto component = get<ExtComponentType>(L, 1);
+	auto cursor = (uint64_t)lua_tointeger(L, 2);
+	auto ecs = State::FromLua(L)->GetEntitySystemHelpers();
+	auto componentType = ecs->GetComponentIndex(component);
+	if (componentType) {
+		auto classes = ecs->GetEntityClassesWithComponent(*componentType);
+		auto classIndex = (uint32_t)(cursor >> 32);
+		auto instanceIndex = (uint32_t)(cursor & 0xffffffff);
+		while (classIndex < classes.size()) {
+			auto const& instances = classes[classIndex].Class->InstanceToPageMap.keys();
+			if (instanceIndex < instances.size()) {
+				push(L, ((uint64_t)classIndex << 32) | (instanceIndex + 1));
+				push(L, instances[instanceIndex]);
+				return 2;
+			}
+
+			classIndex++;
+			instanceIndex = 0;
+		}
+	}
+
+	push(L, nullptr);
+	return 1;
+}
+
+UserReturn IterateEntitiesWithComponent(lua_State* L, ExtComponentType component)
+{
+	lua_pushcfunction(L, &EntityComponentIteratorNext);
+	push(L, component);
+	push(L, 0);
+	return 3;
+}
+
+struct ComponentColumn
+{
+	RawPropertyAccessors const* Accessor{ nullptr };
+	FixedString Property;
+	Array<STDString> SubPath;
+};
+
+void ParseComponentColumn(lua_State* L, GenericPropertyMap const& pm, char const* path, ComponentColumn& column)
+{
+	auto sep = strchr(path, '.');
+	column.Property = sep ? FixedString(StringView(path, sep - path)) : FixedString(path);
+	column.Accessor = pm.FindProperty(column.Property);
+	if (column.Accessor == nullptr && pm.FallbackGetter == nullptr) {
+		luaL_error(L, "Component '%s' has no property named '%s'", pm.Name.GetString(), column.Property.GetString());
+	}
+
+	while (sep) {
+		auto start = sep + 1;
+		sep = strchr(start, '.');
+		column.SubPath.push_back(sep ? STDString(start, sep - start) : STDString(start));
+	}
+}
+
+// Reads the specified fields of every instance of a component in one pass over the entity class pools.
+// Results are returned as one Lua array per field path (plus an "Entity" column), indexed in the same order.
+UserReturn GetComponentColumns(lua_State* L, ExtComponentType component)
+{
+	luaL_checktype(L, 2, LUA_TTABLE);
+	auto ecs = State::FromLua(L)->GetEntitySystemHelpers();
+	auto const& meta = ecs->GetComponentMeta(component);
+	auto pm = ecs->GetPropertyMap(component);
+	if (meta.ComponentIndex == ecs::UndefinedComponent || pm == nullptr) {
+		luaL_error(L, "Columnar reads are not supported for components of type %s", EnumInfo<ExtComponentType>::Store->Find((EnumUnderlyingType)component).GetString());
+	}
+
+	auto numPaths = (int)lua_rawlen(L, 2);
+	Array<ComponentColumn> columns;
+	columns.resize(numPaths);
+	for (int i = 0; i < numPaths; i++) {
+		lua_rawgeti(L, 2, i + 1);
+		if (lua_type(L, -1) != LUA_TSTRING) {
+			luaL_error(L, "Field path #%d is not a string", i + 1);
+		}
+		ParseComponentColumn(L, *pm, lua_tostring(L, -1), columns[i]);
+		lua_pop(L, 1);
+	}
+
+	auto sources = ecs->GetEntityClassesWithComponent(meta.ComponentIndex);
+	uint32_t numRows = 0;
+	for (auto const& source : sources) {
+		numRows += source.Class->InstanceToPageMap.size();
+	}
+
+	luaL_checkstack(L, numPaths + 4, "too many field paths");
+	lua_createtable(L, 0, numPaths + 1);
+	auto resultIdx = lua_absindex(L, -1);
+
+	lua_createtable(L, (int)numRows, 0);
+	auto entityColumnIdx = lua_absindex(L, -1);
+	for (int i = 0; i < numPaths; i++) {
+		lua_createtable(L, (int)numRows, 0);
+	}
+
+	auto lifetime = GetCurrentLifetime(L);
+	lua_Integer row = 1;
+	for (auto const& source : sources) {
+		for (auto const& instance : source.Class->InstanceToPageMap) {
+			auto object = source.Class->GetComponent(instance.Value(), source.ComponentSlot, meta.Size, meta.IsProxy);
+			push(L, instance.Key());
+			lua_rawseti(L, entityColumnIdx, row);
+
+			for (int i = 0; i < numPaths; i++) {
+				auto const& column = columns[i];
+				auto result = column.Accessor
+					? column.Accessor->Get(L, lifetime, object, *column.Accessor)
+					: pm->FallbackGetter(L, lifetime, object, column.Property);
+				if (result != PropertyOperationResult::Success) {
+					push(L, nullptr);
+				}
+
+				for (auto const& key : column.SubPath) {
+					if (lua_isnil(L, -1)) break;
+					lua_getfield(L, -1, key.c_str());
+					lua_remove(L, -2);
+				}
+
+				lua_rawseti(L, entityColumnIdx + 1 + i, row);
+			}
+
+			row++;
+		}
+	}
+
+	for (int i = numPaths - 1; i >= 0; i--) {
+		lua_rawgeti(L, 2, i + 1);
+		lua_insert(L, -2);
+		lua_rawset(L, resultIdx);
+	}
+
+	lua_setfield(L, resultIdx, "Entity");
+	push(L, numRows);
+	lua_setfield(L, resultIdx, "Count");
+	return 1;
+}
+
 Array<EntityHandle> GetAllEntities(lua_State* L)
 {
 	Array<EntityHandle> entities;
@@ -143,6 +292,8 @@ void RegisterEntityLib()
 	MODULE_FUNCTION(Get)
 	MODULE_FUNCTION(GetAllEntitiesWithUuid)
 	MODULE_FUNCTION(GetAllEntitiesWithComponent)
+	MODULE_FUNCTION(IterateEntitiesWithComponent)
+	MODULE_FUNCTION(GetComponentColumns)
 	MODULE_FUNCTION(GetAllEntities)
 	MODULE_FUNCTION(Subscribe)
 	MODULE_NAMED_FUNCTION("OnChange", Subscribe)
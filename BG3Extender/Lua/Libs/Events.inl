@@ -0,0 +1,49 @@
+// Native backend of Ext.Events; the Lua-facing event objects are defined in Libs/Event.lua
+BEGIN_NS(lua::events)
+
+SubscribableEvent* GetEvent(lua_State* L, FixedString const& name)
+{
+	auto event = State::FromLua(L)->GetEventManager().GetEvent(name);
+	if (event == nullptr) {
+		luaL_error(L, "Event '%s' does not exist", name.GetString());
+	}
+
+	return event;
+}
+
+void RegisterEvent(lua_State* L, FixedString name)
+{
+	State::FromLua(L)->GetEventManager().RegisterEvent(name);
+}
+
+uint32_t Subscribe(lua_State* L, FixedString name, FunctionRef handler, std::optional<double> priority, std::optional<bool> once)
+{
+	auto event = GetEvent(L, name);
+	return event->Subscribe(RegistryEntry(L, handler.Index), priority ? *priority : 100.0, once ? *once : false);
+}
+
+bool Unsubscribe(lua_State* L, FixedString name, uint32_t index)
+{
+	return GetEvent(L, name)->Unsubscribe(index);
+}
+
+void Throw(lua_State* L, FixedString name, AnyRef evt)
+{
+	auto event = GetEvent(L, name);
+	lua_pushvalue(L, evt.Index);
+	event->Throw(L, nullptr);
+	lua_pop(L, 1);
+}
+
+void RegisterEventsLib()
+{
+	DECLARE_MODULE(_Events, Both)
+	BEGIN_MODULE()
+	MODULE_FUNCTION(RegisterEvent)
+	MODULE_FUNCTION(Subscribe)
+	MODULE_FUNCTION(Unsubscribe)
+	MODULE_FUNCTION(Throw)
+	END_MODULE()
+}
+
+END_NS()
@@ -12,7 +12,8 @@ struct StringifyContext
 	std::unordered_set<void*> SeenUserdata;
 };
 
-std::string Stringify(lua_State * L, StringifyContext& ctx, int index);
+// Appends the JSON representation of the value at the specified stack index to the output buffer
+void Stringify(lua_State * L, StringifyContext& ctx, int index, STDString& out);
 bool Parse(lua_State* L, StringView json);
 
 END_NS()
@@ -1,6 +1,7 @@
 #include <Lua/Libs/Json.h>
 
 #include <fstream>
+#include <charconv>
 #include <unordered_set>
 #include <json/json.h>
 #include <lstate.h>
@@ -8,82 +9,391 @@
 /// <lua_module>Json</lua_module>
 BEGIN_NS(lua::json)
 
-void Parse(lua_State * L, Json::Value const & val);
-
-void ParseArray(lua_State * L, Json::Value const & val)
+// SAX-style JSON parser that pushes Lua values to the stack as the tokens are read,
+// without building an intermediate document.
+// Accepts the same documents as the jsoncpp reader with default settings
+// (comments, trailing commas, UTF-8 BOM and trailing data after the root value are allowed).
+class JsonReader
 {
-	lua_createtable(L, (int)val.size(), 0);
-	int idx = 1;
-	for (auto it = val.begin(), end = val.end(); it != end; ++it) {
-		push(L, idx++);
-		Parse(L, *it);
-		lua_rawset(L, -3);
+public:
+	// Same as the default jsoncpp stack limit
+	static constexpr uint32_t MaxDepth = 1000;
+
+	inline JsonReader(lua_State* L, StringView json)
+		: L_(L), begin_(json.data()), pos_(json.data()), end_(json.data() + json.size())
+	{}
+
+	// Pushes the parsed value to the stack; pushes nothing if the document is malformed
+	bool Parse()
+	{
+		auto top = lua_gettop(L_);
+		if (end_ - pos_ >= 3 && memcmp(pos_, "\xEF\xBB\xBF", 3) == 0) {
+			pos_ += 3;
+		}
+
+		if (!ReadValue(0)) {
+			lua_settop(L_, top);
+			return false;
+		}
+
+		return true;
 	}
-}
 
-void ParseObject(lua_State * L, Json::Value const & val)
-{
-	lua_createtable(L, 0, (int)val.size());
-	for (auto it = val.begin(), end = val.end(); it != end; ++it) {
-		Parse(L, it.key());
-		Parse(L, *it);
-		lua_rawset(L, -3);
+	STDString GetError() const
+	{
+		unsigned line = 1;
+		auto lineStart = begin_;
+		for (auto p = begin_; p < errorPos_; p++) {
+			if (*p == '\n') {
+				line++;
+				lineStart = p + 1;
+			}
+		}
+
+		char buf[256];
+		sprintf_s(buf, "Line %u, Column %u: %s", line, (unsigned)(errorPos_ - lineStart + 1), error_);
+		return buf;
 	}
-}
 
-void Parse(lua_State * L, Json::Value const & val)
-{
-	switch (val.type()) {
-	case Json::nullValue:
-		lua_pushnil(L);
-		break;
+private:
+	lua_State* L_;
+	char const* begin_;
+	char const* pos_;
+	char const* end_;
+	char const* error_{ nullptr };
+	char const* errorPos_{ nullptr };
+	// Decoding buffer for strings with escape sequences and for number tokens
+	STDString scratch_;
+
+	bool Fail(char const* error, char const* pos = nullptr)
+	{
+		error_ = error;
+		errorPos_ = pos ? pos : pos_;
+		return false;
+	}
 
-	case Json::intValue:
-		push(L, val.asInt64());
-		break;
+	bool SkipWhitespace()
+	{
+		while (pos_ != end_) {
+			auto ch = *pos_;
+			if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+				pos_++;
+			} else if (ch == '/' && end_ - pos_ >= 2 && pos_[1] == '/') {
+				while (pos_ != end_ && *pos_ != '\n') pos_++;
+			} else if (ch == '/' && end_ - pos_ >= 2 && pos_[1] == '*') {
+				auto start = pos_;
+				pos_ += 2;
+				while (end_ - pos_ >= 2 && !(pos_[0] == '*' && pos_[1] == '/')) pos_++;
+				if (end_ - pos_ < 2) {
+					return Fail("Unterminated comment", start);
+				}
+				pos_ += 2;
+			} else {
+				break;
+			}
+		}
 
-	case Json::uintValue:
-		push(L, (int64_t)val.asUInt64());
-		break;
+		return true;
+	}
 
-	case Json::realValue:
-		push(L, val.asDouble());
-		break;
+	inline bool Peek(char ch) const
+	{
+		return pos_ != end_ && *pos_ == ch;
+	}
 
-	case Json::stringValue:
-		push(L, val.asCString());
-		break;
+	bool ReadValue(uint32_t depth)
+	{
+		if (!SkipWhitespace()) return false;
+		if (pos_ == end_) {
+			return Fail("Syntax error: value, object or array expected");
+		}
 
-	case Json::booleanValue:
-		push(L, val.asBool());
-		break;
+		switch (*pos_) {
+		case '{': return ReadObject(depth);
+		case '[': return ReadArray(depth);
+		case '"': return ReadString();
+		case 't':
+			if (!ReadLiteral("true")) return false;
+			lua_pushboolean(L_, 1);
+			return true;
 
-	case Json::arrayValue:
-		ParseArray(L, val);
-		break;
+		case 'f':
+			if (!ReadLiteral("false")) return false;
+			lua_pushboolean(L_, 0);
+			return true;
 
-	case Json::objectValue:
-		ParseObject(L, val);
-		break;
+		case 'n':
+			if (!ReadLiteral("null")) return false;
+			lua_pushnil(L_);
+			return true;
 
-	default:
-		luaL_error(L, "Attempted to parse unknown Json value");
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			return ReadNumber();
+		default:
+			return Fail("Syntax error: value, object or array expected");
+		}
 	}
-}
+
+	bool ReadLiteral(StringView literal)
+	{
+		if ((std::size_t)(end_ - pos_) < literal.size() || memcmp(pos_, literal.data(), literal.size()) != 0) {
+			return Fail("Syntax error: value, object or array expected");
+		}
+
+		pos_ += literal.size();
+		return true;
+	}
+
+	bool EnterContainer(uint32_t depth)
+	{
+		if (depth >= MaxDepth) {
+			return Fail("Exceeded nesting depth limit");
+		}
+
+		// Table, key, value
+		if (!lua_checkstack(L_, 3)) {
+			return Fail("Stack overflow while parsing JSON");
+		}
+
+		pos_++;
+		lua_newtable(L_);
+		return SkipWhitespace();
+	}
+
+	bool ReadObject(uint32_t depth)
+	{
+		if (!EnterContainer(depth)) return false;
+
+		while (!Peek('}')) {
+			if (!Peek('"')) {
+				return Fail("Missing '}' or object member name");
+			}
+
+			if (!ReadString() || !SkipWhitespace()) return false;
+			if (!Peek(':')) {
+				return Fail("Missing ':' after object member name");
+			}
+
+			pos_++;
+			if (!ReadValue(depth + 1) || !SkipWhitespace()) return false;
+			lua_rawset(L_, -3);
+
+			if (Peek(',')) {
+				pos_++;
+				if (!SkipWhitespace()) return false;
+			} else if (!Peek('}')) {
+				return Fail("Missing ',' or '}' in object declaration");
+			}
+		}
+
+		pos_++;
+		return true;
+	}
+
+	bool ReadArray(uint32_t depth)
+	{
+		if (!EnterContainer(depth)) return false;
+
+		lua_Integer index = 1;
+		while (!Peek(']')) {
+			if (!ReadValue(depth + 1) || !SkipWhitespace()) return false;
+			lua_rawseti(L_, -2, index++);
+
+			if (Peek(',')) {
+				pos_++;
+				if (!SkipWhitespace()) return false;
+			} else if (!Peek(']')) {
+				return Fail("Missing ',' or ']' in array declaration");
+			}
+		}
+
+		pos_++;
+		return true;
+	}
+
+	bool ReadString()
+	{
+		auto start = pos_++;
+		auto run = pos_;
+		while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\') pos_++;
+
+		// Fast path for strings without escape sequences; they're pushed directly from the input
+		if (pos_ != end_ && *pos_ == '"') {
+			lua_pushlstring(L_, run, pos_ - run);
+			pos_++;
+			return true;
+		}
+
+		scratch_.assign(run, pos_);
+		while (pos_ != end_) {
+			auto ch = *pos_++;
+			if (ch == '"') {
+				lua_pushlstring(L_, scratch_.data(), scratch_.size());
+				return true;
+			}
+
+			if (ch != '\\') {
+				scratch_.push_back(ch);
+				continue;
+			}
+
+			if (pos_ == end_) break;
+
+			switch (*pos_++) {
+			case '"': scratch_.push_back('"'); break;
+			case '\\': scratch_.push_back('\\'); break;
+			case '/': scratch_.push_back('/'); break;
+			case 'b': scratch_.push_back('\b'); break;
+			case 'f': scratch_.push_back('\f'); break;
+			case 'n': scratch_.push_back('\n'); break;
+			case 'r': scratch_.push_back('\r'); break;
+			case 't': scratch_.push_back('\t'); break;
+			case 'u':
+			{
+				uint32_t codePoint;
+				if (!ReadUnicodeEscape(codePoint)) return false;
+				AppendUtf8(codePoint);
+				break;
+			}
+			default:
+				return Fail("Bad escape sequence in string", pos_ - 2);
+			}
+		}
+
+		return Fail("Missing '\"' at end of string", start);
+	}
+
+	bool ReadHex4(uint32_t& value)
+	{
+		if (end_ - pos_ < 4) {
+			return Fail("Bad unicode escape sequence in string: four digits expected");
+		}
+
+		value = 0;
+		for (unsigned i = 0; i < 4; i++) {
+			auto ch = *pos_++;
+			value <<= 4;
+			if (ch >= '0' && ch <= '9') value |= ch - '0';
+			else if (ch >= 'a' && ch <= 'f') value |= ch - 'a' + 10;
+			else if (ch >= 'A' && ch <= 'F') value |= ch - 'A' + 10;
+			else return Fail("Bad unicode escape sequence in string: hexadecimal digit expected", pos_ - 1);
+		}
+
+		return true;
+	}
+
+	bool ReadUnicodeEscape(uint32_t& codePoint)
+	{
+		if (!ReadHex4(codePoint)) return false;
+
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+			uint32_t low;
+			if (end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u') {
+				return Fail("Additional six characters expected to parse unicode surrogate pair");
+			}
+
+			pos_ += 2;
+			if (!ReadHex4(low)) return false;
+			if (low < 0xDC00 || low > 0xDFFF) {
+				return Fail("Expecting a low surrogate in unicode surrogate pair", pos_ - 6);
+			}
+
+			codePoint = 0x10000 + ((codePoint & 0x3FF) << 10) + (low & 0x3FF);
+		}
+
+		return true;
+	}
+
+	void AppendUtf8(uint32_t codePoint)
+	{
+		if (codePoint < 0x80) {
+			scratch_.push_back((char)codePoint);
+		} else if (codePoint < 0x800) {
+			scratch_.push_back((char)(0xC0 | (codePoint >> 6)));
+			scratch_.push_back((char)(0x80 | (codePoint & 0x3F)));
+		} else if (codePoint < 0x10000) {
+			scratch_.push_back((char)(0xE0 | (codePoint >> 12)));
+			scratch_.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+			scratch_.push_back((char)(0x80 | (codePoint & 0x3F)));
+		} else {
+			scratch_.push_back((char)(0xF0 | (codePoint >> 18)));
+			scratch_.push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+			scratch_.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+			scratch_.push_back((char)(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	bool SkipDigits()
+	{
+		auto start = pos_;
+		while (pos_ != end_ && *pos_ >= '0' && *pos_ <= '9') pos_++;
+		return pos_ != start;
+	}
+
+	bool ReadNumber()
+	{
+		auto start = pos_;
+		bool isInteger = true;
+
+		if (Peek('-')) pos_++;
+		if (!SkipDigits()) {
+			return Fail("Syntax error: value, object or array expected", start);
+		}
+
+		if (Peek('.')) {
+			pos_++;
+			isInteger = false;
+			if (!SkipDigits()) {
+				return Fail("Bad number: digits expected after decimal point", start);
+			}
+		}
+
+		if (Peek('e') || Peek('E')) {
+			pos_++;
+			isInteger = false;
+			if (Peek('+') || Peek('-')) pos_++;
+			if (!SkipDigits()) {
+				return Fail("Bad number: digits expected in exponent", start);
+			}
+		}
+
+		// The input is not necessarily null-terminated
+		scratch_.assign(start, pos_);
+
+		if (isInteger) {
+			errno = 0;
+			auto value = strtoll(scratch_.c_str(), nullptr, 10);
+			if (errno != ERANGE) {
+				lua_pushinteger(L_, value);
+				return true;
+			}
+
+			if (*start != '-') {
+				// Values that only fit into an uint64 are stored as integers, same as the previous jsoncpp reader
+				errno = 0;
+				auto uvalue = strtoull(scratch_.c_str(), nullptr, 10);
+				if (errno != ERANGE) {
+					lua_pushinteger(L_, (lua_Integer)uvalue);
+					return true;
+				}
+			}
+		}
+
+		lua_pushnumber(L_, strtod(scratch_.c_str(), nullptr));
+		return true;
+	}
+};
 
 bool Parse(lua_State * L, StringView json)
 {
-	Json::CharReaderBuilder factory;
-	std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
-
-	Json::Value root;
-	std::string errs;
-	if (!reader->parse(json.data(), json.data() + json.size(), &root, &errs)) {
-		ERR("Unable to parse JSON: %s", errs.c_str());
+	JsonReader reader(L, json);
+	if (!reader.Parse()) {
+		ERR("Unable to parse JSON: %s", reader.GetError().c_str());
 		return false;
 	}
 
-	Parse(L, root);
 	return true;
 }
 
@@ -93,16 +403,11 @@ UserReturn LuaParse(lua_State * L)
 	size_t length;
 	auto json = luaL_checklstring(L, 1, &length);
 
-	Json::CharReaderBuilder factory;
-	std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
-
-	Json::Value root;
-	std::string errs;
-	if (!reader->parse(json, json + length, &root, &errs)) {
-		return luaL_error(L, "Unable to parse JSON: %s", errs.c_str());
+	JsonReader reader(L, StringView(json, length));
+	if (!reader.Parse()) {
+		return luaL_error(L, "Unable to parse JSON: %s", reader.GetError().c_str());
 	}
 
-	Parse(L, root);
 	return 1;
 }
 
@@ -244,318 +549,488 @@ bool IsMapLikeUserdata(lua_State* L, int index)
 	return false;
 }
 
-Json::Value Stringify(lua_State * L, int index, unsigned depth, StringifyContext& ctx);
-
-Json::Value StringifyUserdata(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
+// Writes JSON directly from the Lua stack into a single output buffer, without building an intermediate document.
+// The output layout is the same as that of the styled jsoncpp writer that was used previously
+// (object members are sorted by name, nested containers of object members start on a new line).
+class JsonWriter
 {
-	StackCheck _(L, 0);
-
-	index = lua_absindex(L, index);
-
-	if (CheckForRecursion(L, index, ctx)) {
-		return Json::Value("*RECURSION*");
+public:
+	inline JsonWriter(lua_State* L, StringifyContext& ctx, STDString& out)
+		: L_(L), ctx_(ctx), out_(out)
+	{
+		keys_.resize(ctx.MaxDepth + 1);
 	}
 
-	Json::Value arr;
-	if (IsArrayLikeUserdata(L, index)) {
-		arr = Json::Value(Json::arrayValue);
-	} else {
-		arr = Json::Value(Json::objectValue);
-	}
+	// memberValue: the value is an object member, so a non-empty container starts on a new line
+	void Write(int index, uint32_t depth, bool memberValue)
+	{
+		if (depth > ctx_.MaxDepth) {
+			throw std::runtime_error("Recursion depth exceeded while stringifying JSON");
+		}
 
-	bool isMap = IsMapLikeUserdata(L, index);
+		index = lua_absindex(L_, index);
+		switch (lua_type(L_, index)) {
+		case LUA_TNIL:
+			out_.append("null", 4);
+			break;
 
-	if (!TryGetUserdataPairs(L, index)) {
-		return Json::Value();
-	}
+		case LUA_TBOOLEAN:
+			if (lua_toboolean(L_, index)) {
+				out_.append("true", 4);
+			} else {
+				out_.append("false", 5);
+			}
+			break;
 
-#if !defined(NDEBUG)
-	auto ptrVal = GetPointerValue(L, index);
-#endif
+		case LUA_TNUMBER:
+			if (lua_isinteger(L_, index)) {
+				WriteInt(lua_tointeger(L_, index));
+			} else {
+				WriteDouble(lua_tonumber(L_, index));
+			}
+			break;
 
-	// Call __pairs(obj)
-	auto nextIndex = lua_absindex(L, -1);
-	lua_pushvalue(L, index);
-	lua_call(L, 1, 3); // returns __next, obj, nil
+		case LUA_TSTRING:
+		{
+			size_t len;
+			auto str = lua_tolstring(L_, index, &len);
+			WriteString(StringView(str, len));
+			break;
+		}
 
-	// Push next, obj, k
-	lua_pushvalue(L, nextIndex);
-	lua_pushvalue(L, nextIndex + 1);
-	lua_pushvalue(L, nextIndex + 2);
-	// Call __next(obj, k)
-	lua_call(L, 2, 2); // returns k, val
+		case LUA_TTABLE:
+			if (ctx_.LimitDepth != -1 && depth > (uint32_t)ctx_.LimitDepth) {
+				WriteString("*DEPTH LIMIT EXCEEDED*");
+			} else {
+				WriteTable(index, depth, memberValue);
+			}
+			break;
 
-	int numElements{ 0 };
-	while (lua_type(L, -2) != LUA_TNIL) {
-		if (isMap && ctx.LimitArrayElements != -1 && numElements > ctx.LimitArrayElements) {
+		case LUA_TUSERDATA:
+		case LUA_TLIGHTCPPOBJECT:
+		case LUA_TCPPOBJECT:
+			WriteUserdata(index, depth, memberValue);
 			break;
-		}
 
-#if !defined(NDEBUG)
-		STDString key;
-		if (lua_type(L, -2) == LUA_TSTRING) {
-			key = lua_tostring(L, -2);
-		} else if (lua_type(L, -2) == LUA_TNUMBER) {
-			lua_pushvalue(L, -2);
-			key = lua_tostring(L, -1);
-			lua_pop(L, 1);
+		case LUA_TLIGHTUSERDATA:
+		case LUA_TFUNCTION:
+		case LUA_TTHREAD:
+			WriteInternalType(index);
+			break;
+
+		default:
+			throw std::runtime_error("Attempted to stringify an unknown type");
 		}
-#endif
+	}
 
-		Json::Value val(Stringify(L, -1, depth + 1, ctx));
+private:
+	struct Container
+	{
+		char Open;
+		char Close;
+		bool NewLineBeforeOpen;
+		bool Empty{ true };
+	};
+
+	struct ObjectKey
+	{
+		// Points to the key in the table for string keys; null for number keys
+		char const* String;
+		std::size_t Length;
+		bool IsInteger;
+		lua_Integer Integer;
+		lua_Number Number;
+		char NumberName[32];
+
+		inline StringView GetName() const
+		{
+			return StringView(String ? String : NumberName, Length);
+		}
+	};
+
+	lua_State* L_;
+	StringifyContext& ctx_;
+	STDString& out_;
+	uint32_t indent_{ 0 };
+	// Key lists of the tables being written, indexed by depth; reused to avoid allocating for every table
+	std::vector<std::vector<ObjectKey>> keys_;
+
+	void WriteIndent()
+	{
+		if (ctx_.Beautify) {
+			out_.push_back('\n');
+			out_.append(indent_, '\t');
+		}
+	}
 
-		auto type = lua_type(L, -2);
-		if (type == LUA_TSTRING) {
-			auto key = lua_tostring(L, -2);
-			arr[key] = val;
-		} else if (type == LUA_TNUMBER) {
-			auto key = lua_tointeger(L, -2);
-			if (ctx.LimitArrayElements != -1 && key > ctx.LimitArrayElements) {
-				break;
+	void BeginElement(Container& container)
+	{
+		if (container.Empty) {
+			if (container.NewLineBeforeOpen) {
+				WriteIndent();
 			}
 
-			if (arr.type() == Json::arrayValue) {
-				arr[(uint32_t)key - 1] = val;
-			} else {
-				lua_pushvalue(L, -2);
-				auto key = lua_tostring(L, -1);
-				arr[key] = val;
-				lua_pop(L, 1);
-			}
-		} else if ((type == LUA_TUSERDATA || type == LUA_TLIGHTCPPOBJECT || type == LUA_TCPPOBJECT) && ctx.StringifyInternalTypes) {
-			int top = lua_gettop(L);
-			lua_getglobal(L, "tostring");  /* function to be called */
-			lua_pushvalue(L, -3);   /* value to print */
-			lua_call(L, 1, 1);
-			const char* key = lua_tostring(L, -1);  /* get result */
-			if (key) {
-				arr[key] = val;
-			}
-			int top2 = lua_gettop(L);
-			lua_pop(L, 1);  /* pop result */
-		} else if (type == LUA_TLIGHTUSERDATA && ctx.StringifyInternalTypes) {
-			auto handle = get<EntityHandle>(L, -2);
-			char key[100];
-			sprintf_s(key, "%016llx", handle.Handle);
-			arr[key] = val;
+			out_.push_back(container.Open);
+			container.Empty = false;
+			indent_++;
 		} else {
-			throw std::runtime_error("Can only stringify string or number table keys");
+			out_.push_back(',');
 		}
 
-		// Push next, obj, k
-		lua_pushvalue(L, nextIndex);
-		lua_pushvalue(L, nextIndex + 1);
-		lua_pushvalue(L, nextIndex + 3);
-		lua_remove(L, -4);
-		lua_remove(L, -4);
-		// Call __next(obj, k)
-		lua_call(L, 2, 2); // returns k, val
-		numElements++;
+		WriteIndent();
 	}
 
-	lua_pop(L, 2);
-
-	// Pop __next, obj, nil
-	lua_pop(L, 3);
-	return arr;
-}
+	void EndContainer(Container& container)
+	{
+		if (container.Empty) {
+			out_.push_back(container.Open);
+		} else {
+			indent_--;
+			WriteIndent();
+		}
 
-Json::Value StringifyTableAsObject(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
-{
-	Json::Value arr(Json::objectValue);
-	lua_pushnil(L);
+		out_.push_back(container.Close);
+	}
 
-	if (index < 0) index--;
+	void WriteMemberName(StringView name)
+	{
+		WriteString(name);
+		if (ctx_.Beautify) {
+			out_.append(" : ", 3);
+		} else {
+			out_.push_back(':');
+		}
+	}
 
-	while (lua_next(L, index) != 0) {
-		Json::Value val(Stringify(L, -1, depth + 1, ctx));
+	void WriteInt(int64_t v)
+	{
+		char buf[32];
+		auto result = std::to_chars(buf, buf + sizeof(buf), v);
+		out_.append(buf, result.ptr - buf);
+	}
 
-		if (lua_type(L, -2) == LUA_TSTRING) {
-			auto key = lua_tostring(L, -2);
-			arr[key] = val;
-		} else if (lua_type(L, -2) == LUA_TNUMBER) {
-			lua_pushvalue(L, -2);
-			auto key = lua_tostring(L, -1);
-			arr[key] = val;
-			lua_pop(L, 1);
+	void WriteDouble(double v)
+	{
+		if (std::isnan(v)) {
+			out_.append("null", 4);
+		} else if (std::isinf(v)) {
+			out_.append(v < 0 ? "-1e+9999" : "1e+9999");
 		} else {
-			throw std::runtime_error("Can only stringify string or number table keys");
+			char buf[40];
+			auto len = sprintf_s(buf, "%.17g", v);
+			out_.append(buf, len);
+			// Keep the value a real number when it's parsed again
+			if (!memchr(buf, '.', len) && !memchr(buf, 'e', len)) {
+				out_.append(".0", 2);
+			}
 		}
-
-		lua_pop(L, 1);
 	}
 
-	return arr;
-}
+	void WriteString(StringView s)
+	{
+		out_.push_back('"');
+
+		auto run = s.data();
+		auto end = s.data() + s.size();
+		for (auto p = run; p != end; p++) {
+			auto ch = (uint8_t)*p;
+			if (ch >= 0x20 && ch != '"' && ch != '\\') continue;
+
+			out_.append(run, p - run);
+			run = p + 1;
+
+			switch (ch) {
+			case '"': out_.append("\\\"", 2); break;
+			case '\\': out_.append("\\\\", 2); break;
+			case '\b': out_.append("\\b", 2); break;
+			case '\f': out_.append("\\f", 2); break;
+			case '\n': out_.append("\\n", 2); break;
+			case '\r': out_.append("\\r", 2); break;
+			case '\t': out_.append("\\t", 2); break;
+			default:
+			{
+				char buf[8];
+				sprintf_s(buf, "\\u%04x", ch);
+				out_.append(buf, 6);
+				break;
+			}
+			}
+		}
 
-Json::Value StringifyTableAsArray(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
-{
-	Json::Value arr(Json::arrayValue);
-	lua_pushnil(L);
+		out_.append(run, end - run);
+		out_.push_back('"');
+	}
 
-	if (index < 0) index--;
+	void WriteInternalType(int index)
+	{
+		if (!ctx_.StringifyInternalTypes) {
+			throw std::runtime_error("Attempted to stringify a lightuserdata, userdata, function or thread value");
+		}
 
-	while (lua_next(L, index) != 0) {
-		arr.append(Stringify(L, -1, depth + 1, ctx));
-		lua_pop(L, 1);
+		size_t len;
+		auto str = luaL_tolstring(L_, index, &len);
+		WriteString(StringView(str, len));
+		lua_pop(L_, 1);
 	}
 
-	return arr;
-}
+	void WriteTable(int index, uint32_t depth, bool memberValue)
+	{
+		if (CheckForRecursion(L_, index, ctx_)) {
+			WriteString("*RECURSION*");
+			return;
+		}
 
-bool JsonCanStringifyAsArray(lua_State * L, int index)
-{
-	Json::Value arr(Json::objectValue);
-	lua_pushnil(L);
-
-	if (index < 0) index--;
-
-	int next = 1;
-	bool isArray = true;
-	while (lua_next(L, index) != 0) {
-#if LUA_VERSION_NUM > 501
-		if (lua_isinteger(L, -2)) {
-			auto key = lua_tointeger(L, -2);
-			if (key != next++) {
-				isArray = false;
-			}
-		} else {
-			isArray = false;
+		if (!lua_checkstack(L_, 3)) {
+			throw std::runtime_error("Stack overflow while stringifying JSON");
 		}
-#else
-		if (lua_isnumber(L, -2)) {
-			auto key = lua_tonumber(L, -2);
-			if (abs(key - next++) < 0.0001) {
+
+		lua_Integer count = 0;
+		lua_Integer maxKey = 0;
+		bool isArray = true;
+		lua_pushnil(L_);
+		while (lua_next(L_, index) != 0) {
+			count++;
+			if (isArray && lua_isinteger(L_, -2)) {
+				auto key = lua_tointeger(L_, -2);
+				if (key < 1) {
+					isArray = false;
+				} else if (key > maxKey) {
+					maxKey = key;
+				}
+			} else {
 				isArray = false;
 			}
-		} else {
-			isArray = false;
+
+			lua_pop(L_, 1);
 		}
-#endif
 
-		lua_pop(L, 1);
+		// Keys are unique, so count positive integer keys with a maximum of count must be exactly 1..count
+		if (isArray && maxKey == count) {
+			WriteTableAsArray(index, count, depth, memberValue);
+		} else {
+			WriteTableAsObject(index, depth, memberValue);
+		}
 	}
 
-	return isArray;
-}
+	void WriteTableAsArray(int index, lua_Integer count, uint32_t depth, bool memberValue)
+	{
+		Container arr{ '[', ']', memberValue };
+		for (lua_Integer i = 1; i <= count; i++) {
+			lua_rawgeti(L_, index, i);
+			BeginElement(arr);
+			Write(-1, depth + 1, false);
+			lua_pop(L_, 1);
+		}
 
-Json::Value StringifyTable(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
-{
-	if (CheckForRecursion(L, index, ctx)) {
-		return Json::Value("*RECURSION*");
+		EndContainer(arr);
 	}
 
-	if (JsonCanStringifyAsArray(L, index)) {
-		return StringifyTableAsArray(L, index, depth, ctx);
-	} else {
-		return StringifyTableAsObject(L, index, depth, ctx);
-	}
-}
+	void WriteTableAsObject(int index, uint32_t depth, bool memberValue)
+	{
+		auto& keys = keys_[depth];
+		keys.clear();
+
+		lua_pushnil(L_);
+		while (lua_next(L_, index) != 0) {
+			lua_pop(L_, 1);
+
+			ObjectKey key;
+			auto type = lua_type(L_, -1);
+			if (type == LUA_TSTRING) {
+				key.String = lua_tolstring(L_, -1, &key.Length);
+			} else if (type == LUA_TNUMBER) {
+				key.String = nullptr;
+				key.IsInteger = lua_isinteger(L_, -1) != 0;
+				key.Integer = lua_tointeger(L_, -1);
+				key.Number = lua_tonumber(L_, -1);
+				// Same conversion as tostring()
+				lua_pushvalue(L_, -1);
+				size_t len;
+				auto name = lua_tolstring(L_, -1, &len);
+				key.Length = std::min(len, sizeof(key.NumberName));
+				memcpy(key.NumberName, name, key.Length);
+				lua_pop(L_, 1);
+			} else {
+				lua_pop(L_, 1);
+				throw std::runtime_error("Can only stringify string or number table keys");
+			}
 
+			keys.push_back(key);
+		}
 
-Json::Value StringifyInternalType(lua_State * L, int index, StringifyContext& ctx)
-{
-	if (ctx.StringifyInternalTypes) {
-		auto val = Json::Value(luaL_tolstring(L, index, NULL));
-		lua_pop(L, 1);
-		return val;
-	} else {
-		throw std::runtime_error("Attempted to stringify a lightuserdata, userdata, function or thread value");
-	}
-}
+		// String keys sort before number keys of the same name (e.g. "1" and 1),
+		// so the string key is kept when the duplicate names are merged below
+		std::sort(keys.begin(), keys.end(), [](ObjectKey const& a, ObjectKey const& b) {
+			auto cmp = a.GetName().compare(b.GetName());
+			return cmp < 0 || (cmp == 0 && a.String != nullptr && b.String == nullptr);
+		});
+
+		auto last = std::unique(keys.begin(), keys.end(), [](ObjectKey const& a, ObjectKey const& b) {
+			return a.GetName() == b.GetName();
+		});
+		keys.erase(last, keys.end());
+
+		Container obj{ '{', '}', memberValue };
+		for (auto const& key : keys) {
+			if (key.String) {
+				lua_pushlstring(L_, key.String, key.Length);
+			} else if (key.IsInteger) {
+				lua_pushinteger(L_, key.Integer);
+			} else {
+				lua_pushnumber(L_, key.Number);
+			}
 
-Json::Value TryStringifyUserdata(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
-{
-	CppValueMetadata meta;
-	index = lua_absindex(L, index);
-	if (lua_try_get_cppvalue(L, index, EnumValueMetatable::MetaTag, meta)) {
-		return Json::Value(EnumValueMetatable::GetLabel(meta).GetString());
-	}
+			lua_rawget(L_, index);
+			BeginElement(obj);
+			WriteMemberName(key.GetName());
+			Write(-1, depth + 1, true);
+			lua_pop(L_, 1);
+		}
 
-	if (lua_try_get_cppvalue(L, index, BitfieldValueMetatable::MetaTag, meta)) {
-		return BitfieldValueMetatable::ToJson(meta);
+		EndContainer(obj);
 	}
 
-	if (ctx.IterateUserdata) {
-		if (ctx.LimitDepth != -1 && depth > (uint32_t)ctx.LimitDepth) {
-			return Json::Value("*DEPTH LIMIT EXCEEDED*");
+	void WriteUserdata(int index, uint32_t depth, bool memberValue)
+	{
+		CppValueMetadata meta;
+		if (lua_try_get_cppvalue(L_, index, EnumValueMetatable::MetaTag, meta)) {
+			auto label = EnumValueMetatable::GetLabel(meta);
+			WriteString(StringView(label.GetString(), label.GetLength()));
+			return;
 		}
 
-		auto obj = StringifyUserdata(L, index, depth, ctx);
-		if (!obj.isNull()) {
-			return obj;
+		if (lua_try_get_cppvalue(L_, index, BitfieldValueMetatable::MetaTag, meta)) {
+			Container arr{ '[', ']', memberValue };
+			for (auto const& label : BitfieldValueMetatable::ToJson(meta)) {
+				BeginElement(arr);
+				WriteString(label.asCString());
+			}
+			EndContainer(arr);
+			return;
 		}
-	}
 
-	return StringifyInternalType(L, index, ctx);
-}
+		if (ctx_.IterateUserdata) {
+			if (ctx_.LimitDepth != -1 && depth > (uint32_t)ctx_.LimitDepth) {
+				WriteString("*DEPTH LIMIT EXCEEDED*");
+				return;
+			}
 
-Json::Value Stringify(lua_State * L, int index, unsigned depth, StringifyContext& ctx)
-{
-	if (depth > ctx.MaxDepth) {
-		throw std::runtime_error("Recursion depth exceeded while stringifying JSON");
-	}
+			if (IterateUserdata(index, depth, memberValue)) {
+				return;
+			}
+		}
 
-	switch (lua_type(L, index)) {
-	case LUA_TNIL:
-		return Json::Value(Json::nullValue);
+		WriteInternalType(index);
+	}
 
-	case LUA_TBOOLEAN:
-		return Json::Value(lua_toboolean(L, index) == 1);
+	bool IterateUserdata(int index, uint32_t depth, bool memberValue)
+	{
+		StackCheck _(L_, 0);
 
-	case LUA_TNUMBER:
-#if LUA_VERSION_NUM > 501
-		if (lua_isinteger(L, index)) {
-			return Json::Value(lua_tointeger(L, index));
-		} else {
-			return Json::Value(lua_tonumber(L, index));
+		if (CheckForRecursion(L_, index, ctx_)) {
+			WriteString("*RECURSION*");
+			return true;
 		}
-#else
-		return Json::Value(lua_tonumber(L, index));
-#endif
 
-	case LUA_TSTRING:
-		return Json::Value(lua_tostring(L, index));
+		bool isArray = IsArrayLikeUserdata(L_, index);
+		bool isMap = IsMapLikeUserdata(L_, index);
 
-	case LUA_TTABLE:
-		if (ctx.LimitDepth != -1 && depth > (uint32_t)ctx.LimitDepth) {
-			return Json::Value("*DEPTH LIMIT EXCEEDED*");
+		if (!lua_checkstack(L_, 8)) {
+			throw std::runtime_error("Stack overflow while stringifying JSON");
 		}
 
-		return StringifyTable(L, index, depth, ctx);
+		if (!TryGetUserdataPairs(L_, index)) {
+			return false;
+		}
 
-	case LUA_TUSERDATA:
-	case LUA_TLIGHTCPPOBJECT:
-	case LUA_TCPPOBJECT:
-		return TryStringifyUserdata(L, index, depth, ctx);
+		// Call __pairs(obj)
+		auto nextIndex = lua_absindex(L_, -1);
+		lua_pushvalue(L_, index);
+		lua_call(L_, 1, 3); // returns __next, obj, nil
+
+		Container container{ isArray ? '[' : '{', isArray ? ']' : '}', memberValue };
+		int numElements{ 0 };
+		for (;;) {
+			// Call __next(obj, k)
+			lua_pushvalue(L_, nextIndex);
+			lua_pushvalue(L_, nextIndex + 1);
+			lua_pushvalue(L_, nextIndex + 2);
+			lua_call(L_, 2, 2); // returns k, val
+
+			if (lua_type(L_, -2) == LUA_TNIL
+				|| (isMap && ctx_.LimitArrayElements != -1 && numElements > ctx_.LimitArrayElements)) {
+				lua_pop(L_, 2);
+				break;
+			}
 
-	case LUA_TLIGHTUSERDATA:
-	case LUA_TFUNCTION:
-	case LUA_TTHREAD:
-		return StringifyInternalType(L, index, ctx);
+			// Key is the control variable of the next __next call
+			lua_pushvalue(L_, -2);
+			lua_replace(L_, nextIndex + 2);
 
-	default:
-		throw std::runtime_error("Attempted to stringify an unknown type");
+			bool written = WriteUserdataElement(container, isArray, depth);
+			lua_pop(L_, 2);
+			if (!written) break;
+
+			numElements++;
+		}
+
+		// Pop __next, obj, k
+		lua_pop(L_, 3);
+		EndContainer(container);
+		return true;
 	}
-}
 
+	// Writes the key-value pair at the top of the stack; returns false if the element limit was reached
+	bool WriteUserdataElement(Container& container, bool isArray, uint32_t depth)
+	{
+		auto keyIndex = lua_absindex(L_, -2);
+		auto type = lua_type(L_, keyIndex);
 
-std::string Stringify(lua_State * L, StringifyContext& ctx, int index)
-{
-	StackCheck _(L);
+		if (type == LUA_TNUMBER && ctx_.LimitArrayElements != -1
+			&& lua_tointeger(L_, keyIndex) > ctx_.LimitArrayElements) {
+			return false;
+		}
 
-	Json::Value root;
-	root = Stringify(L, index, 0, ctx);
+		if (isArray) {
+			BeginElement(container);
+			Write(keyIndex + 1, depth + 1, false);
+			return true;
+		}
+
+		if (type == LUA_TSTRING || type == LUA_TNUMBER) {
+			// Number keys are converted on a copy, lua_tolstring() would change the key in place
+			lua_pushvalue(L_, keyIndex);
+			size_t len;
+			auto key = lua_tolstring(L_, -1, &len);
+			BeginElement(container);
+			WriteMemberName(StringView(key, len));
+			lua_pop(L_, 1);
+		} else if ((type == LUA_TUSERDATA || type == LUA_TLIGHTCPPOBJECT || type == LUA_TCPPOBJECT) && ctx_.StringifyInternalTypes) {
+			size_t len;
+			auto key = luaL_tolstring(L_, keyIndex, &len);
+			BeginElement(container);
+			WriteMemberName(StringView(key, len));
+			lua_pop(L_, 1);
+		} else if (type == LUA_TLIGHTUSERDATA && ctx_.StringifyInternalTypes) {
+			auto handle = get<EntityHandle>(L_, keyIndex);
+			char key[100];
+			sprintf_s(key, "%016llx", handle.Handle);
+			BeginElement(container);
+			WriteMemberName(key);
+		} else {
+			throw std::runtime_error("Can only stringify string or number table keys");
+		}
 
-	Json::StreamWriterBuilder builder;
-	if (ctx.Beautify) {
-		builder["indentation"] = "\t";
+		Write(keyIndex + 1, depth + 1, true);
+		return true;
 	}
-	std::stringstream ss;
-	std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-	writer->write(root, &ss);
+};
 
-	return ss.str();
+void Stringify(lua_State * L, StringifyContext& ctx, int index, STDString& out)
+{
+	StackCheck _(L);
+	JsonWriter writer(L, ctx, out);
+	writer.Write(index, 0, false);
 }
 
 UserReturn LuaStringify(lua_State * L)
@@ -600,14 +1075,17 @@ UserReturn LuaStringify(lua_State * L)
 		}
 	}
 
+	STDString json;
 	DisablePropertyWarnings();
 	try {
-		push(L, Stringify(L, ctx, 1));
+		Stringify(L, ctx, 1, json);
 	} catch (std::runtime_error& e) {
 		return luaL_error(L, "%s", e.what());
 	}
 	EnablePropertyWarnings();
 
+	lua_pushlstring(L, json.data(), json.size());
+
 	return 1;
 }
 
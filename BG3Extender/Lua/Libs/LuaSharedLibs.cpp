@@ -4,8 +4,10 @@
 #include <Lua/Shared/LuaMethodCallHelpers.h>
 #include <Lua/Libs/Debug.inl>
 #include <Lua/Libs/Entity.inl>
+#include <Lua/Libs/Events.inl>
 #include <Lua/Libs/IO.inl>
 #include <Lua/Libs/Json.inl>
+#include <Lua/Libs/BinaryValue.inl>
 #include <Lua/Libs/Localization.inl>
 #include <Lua/Libs/Math.inl>
 #include <Lua/Libs/Mod.inl>
@@ -67,6 +69,7 @@ void RegisterSharedLibraries()
 {
 	utils::RegisterUtilsLib();
 	entity::RegisterEntityLib();
+	events::RegisterEventsLib();
 	json::RegisterJsonLib();
 	types::RegisterTypesLib();
 	io::RegisterIOLib();
@@ -8,30 +8,17 @@ void BroadcastMessage(lua_State* L, char const* channel, char const* payload, st
 		excludeCharacter = State::FromLua(L)->GetEntitySystemHelpers()->GetComponent<Character>(*excludeCharacterGuid);
 	}
 
-	auto & networkMgr = gExtender->GetServer().GetNetworkManager();
-	auto msg = networkMgr.GetFreeMessage(ReservedUserId);
-	if (msg != nullptr) {
-		auto postMsg = msg->GetMessage().mutable_post_lua();
-		postMsg->set_channel_name(channel);
-		postMsg->set_payload(payload);
-		if (excludeCharacter != nullptr) {
-			networkMgr.Broadcast(msg, excludeCharacter->UserID);
-		} else {
-			networkMgr.Broadcast(msg, ReservedUserId);
-		}
-	}
+	bg3se::net::LuaMessageTarget target{
+		.ExcludeUser = excludeCharacter != nullptr ? excludeCharacter->UserID : ReservedUserId,
+		.Broadcast = true
+	};
+	gExtender->GetServer().GetNetworkManager().PostLuaMessage(target, channel, payload, strlen(payload));
 }
 
 void PostMessageToUserInternal(UserId userId, char const* channel, char const* payload)
 {
-	auto& networkMgr = gExtender->GetServer().GetNetworkManager();
-	auto msg = networkMgr.GetFreeMessage(userId);
-	if (msg != nullptr) {
-		auto postMsg = msg->GetMessage().mutable_post_lua();
-		postMsg->set_channel_name(channel);
-		postMsg->set_payload(payload);
-		networkMgr.Send(msg, userId);
-	}
+	bg3se::net::LuaMessageTarget target{ .User = userId };
+	gExtender->GetServer().GetNetworkManager().PostLuaMessage(target, channel, payload, strlen(payload));
 }
 
 void PostMessageToClient(lua_State* L, Guid characterGuid, char const* channel, char const* payload)
@@ -67,6 +54,21 @@ std::optional<bool> PlayerHasExtender(lua_State* L, Guid characterGuid)
 	return networkMgr.CanSendExtenderMessages(character->UserID.GetPeerId());
 }
 
+void SetBatchedChannel(FixedString const& channel, bool batched)
+{
+	gExtender->GetServer().GetNetworkManager().GetBatcher().SetChannelBatched(channel, batched);
+}
+
+UserReturn GetBatchStats(lua_State* L)
+{
+	auto const& stats = gExtender->GetServer().GetNetworkManager().GetBatcher().GetStats();
+	lua_createtable(L, 0, 3);
+	setfield(L, "BatchedMessages", stats.BatchedMessages);
+	setfield(L, "SentBatches", stats.SentBatches);
+	setfield(L, "MessagesSaved", stats.MessagesSaved);
+	return 1;
+}
+
 void RegisterNetLib()
 {
 	DECLARE_MODULE(Net, Server)
@@ -75,6 +77,8 @@ void RegisterNetLib()
 	MODULE_FUNCTION(PostMessageToClient)
 	MODULE_FUNCTION(PostMessageToUser)
 	MODULE_FUNCTION(PlayerHasExtender)
+	MODULE_FUNCTION(SetBatchedChannel)
+	MODULE_FUNCTION(GetBatchStats)
 	END_MODULE()
 }
 
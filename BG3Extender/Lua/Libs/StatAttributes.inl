@@ -23,8 +23,7 @@ namespace bg3se::lua::stats
 		stats->SyncWithPrototypeManager(object);
 
 		if (gExtender->GetServer().IsInServerThread()) {
-			object->BroadcastSyncMessage(false);
-
+			gExtender->GetServer().GetStatSyncWriter().Sync(object->Name);
 			gExtender->GetServer().GetExtensionState().MarkDynamicStat(object->Name);
 			if (persist) {
 				gExtender->GetServer().GetExtensionState().MarkPersistentStat(object->Name);
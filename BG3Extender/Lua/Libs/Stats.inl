@@ -103,24 +103,18 @@ Array<FixedString> FetchTreasureCategoryEntries(RPGStats* stats)
 
 Array<FixedString> FetchStatEntries(RPGStats * stats, FixedString const& statType)
 {
-	ModifierList* modifierList{ nullptr };
 	if (statType) {
-		modifierList = stats->ModifierLists.Find(statType);
-		if (modifierList == nullptr) {
+		auto modifierListIndex = stats->ModifierLists.FindIndex(statType);
+		if (!modifierListIndex) {
 			OsiError("Unknown stats entry type: " << statType);
 			return {};
 		}
+
+		return gExtender->GetStatsIndex().GetObjectNames(stats, *modifierListIndex);
 	}
 
 	Array<FixedString> names;
 	for (auto object : stats->Objects.Primitives) {
-		if (statType) {
-			auto type = stats->GetTypeInfo(object);
-			if (modifierList != nullptr && type != modifierList) {
-				continue;
-			}
-		}
-
 		names.push_back(object->Name);
 	}
 
@@ -611,8 +605,7 @@ void Sync(FixedString const& statName, std::optional<bool> persist)
 	stats->SyncWithPrototypeManager(object);
 
 	if (gExtender->GetServer().IsInServerThread()) {
-		object->BroadcastSyncMessage(false);
-
+		gExtender->GetServer().GetStatSyncWriter().Sync(statName);
 		gExtender->GetServer().GetExtensionState().MarkDynamicStat(statName);
 		if (persist && *persist) {
 			gExtender->GetServer().GetExtensionState().MarkPersistentStat(statName);
@@ -674,13 +667,7 @@ std::optional<FixedString> EnumIndexToLabel(FixedString const& enumName, int ind
 
 	auto valueList = GetStaticSymbols().GetStats()->ModifierValueLists.Find(enumName);
 	if (valueList) {
-		std::optional<FixedString> value;
-		for (auto const& val : valueList->Values) {
-			if (val.Value == index) {
-				value = val.Key;
-			}
-		}
-
+		auto value = gExtender->GetStatsIndex().EnumIndexToLabel(valueList, index);
 		if (value) {
 			return value;
 		} else {
@@ -784,6 +771,7 @@ std::optional<int32_t> AddEnumerationValue(FixedString const& typeName, FixedStr
 
 	auto value = valueList->Values.size();
 	valueList->Values.insert(std::make_pair(enumLabel, value));
+	gExtender->GetStatsIndex().OnEnumerationValueAdded(valueList);
 	return value;
 }
 
@@ -53,6 +53,10 @@ UserVariableFlags ParseUserVariableFlags(lua_State* L, int index)
 		flags |= UserVariableFlags::SyncOnTick;
 	}
 
+	if (try_gettable<bool>(L, "DeltaSync", index, false)) {
+		flags |= UserVariableFlags::DeltaSync;
+	}
+
 	return flags;
 }
 
@@ -153,6 +157,32 @@ void DirtyModVariables(std::optional<Guid> moduleUuid, std::optional<FixedString
 	}
 }
 
+void PushSyncStats(lua_State* L, UserVariableSyncStats const& stats)
+{
+	lua_createtable(L, 0, 10);
+	setfield(L, "QueuedSyncs", stats.QueuedSyncs);
+	setfield(L, "CoalescedWrites", stats.CoalescedWrites);
+	setfield(L, "BytesSaved", stats.BytesSaved);
+	setfield(L, "SentVariables", stats.SentVariables);
+	setfield(L, "SentBytes", stats.SentBytes);
+	setfield(L, "DeltaSyncs", stats.DeltaSyncs);
+	setfield(L, "DeltaBytesSaved", stats.DeltaBytesSaved);
+	setfield(L, "CompressedMessages", stats.CompressedMessages);
+	setfield(L, "CompressionBytesSaved", stats.CompressionBytesSaved);
+	setfield(L, "FullSyncRequests", stats.FullSyncRequests);
+}
+
+UserReturn GetSyncStats(lua_State* L)
+{
+	auto state = gExtender->GetCurrentExtensionState();
+	lua_createtable(L, 0, 2);
+	PushSyncStats(L, state->GetUserVariables().GetSyncStats());
+	lua_setfield(L, -2, "UserVariables");
+	PushSyncStats(L, state->GetModVariables().GetSyncStats());
+	lua_setfield(L, -2, "ModVariables");
+	return 1;
+}
+
 void RegisterVarsLib()
 {
 	DECLARE_MODULE(Vars, Both)
@@ -165,6 +195,7 @@ void RegisterVarsLib()
 	MODULE_FUNCTION(GetModVariables)
 	MODULE_FUNCTION(SyncModVariables)
 	MODULE_FUNCTION(DirtyModVariables)
+	MODULE_FUNCTION(GetSyncStats)
 	END_MODULE()
 }
 
@@ -6,6 +6,7 @@
 #include <fstream>
 #include <lstate.h>
 #include <Lua/Shared/EntityComponentEvents.inl>
+#include <Lua/Shared/EngineEvents.inl>
 
 // Callback from the Lua runtime when a handled (i.e. pcall/xpcall'd) error was thrown.
 // This is needed to capture errors for the Lua debugger, as there is no
@@ -252,9 +253,10 @@ namespace bg3se::lua
 	{
 		L = lua_newstate(LuaAlloc, nullptr);
 		internal_ = lua_new_internal_state();
+		// State must be reachable from the string cache hooks before they're installed
+		*reinterpret_cast<State**>(lua_getextraspace(L)) = this;
 		lua_setup_cppobjects(L, &LuaCppAlloc, &LuaCppFree, &LuaCppGetLightMetatable, &LuaCppGetMetatable, &LuaCppCanonicalize);
 		lua_setup_strcache(L, &LuaCacheString, &LuaReleaseString);
-		*reinterpret_cast<State**>(lua_getextraspace(L)) = this;
 #if LUA_VERSION_NUM <= 501
 		luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
 #endif
@@ -264,6 +266,8 @@ namespace bg3se::lua
 
 	State::~State()
 	{
+		// Handlers must be unreferenced before the Lua state is closed
+		eventManager_.Clear();
 		lifetimePool_.Release(globalLifetime_);
 		lua_close(L);
 	}
@@ -343,7 +347,7 @@ namespace bg3se::lua
 		int top = lua_gettop(L);
 
 		/* Load the file containing the script we are going to run */
-		int status = luaL_loadbufferx(L, script.c_str(), script.size(), name.c_str(), "text");
+		int status = gExtender->GetLuaBytecodeCache().Load(L, script, name.c_str());
 		if (status != LUA_OK) {
 			LuaError("Failed to parse script: " << lua_tostring(L, -1));
 			lua_pop(L, 1);  /* pop error message from the stack */
@@ -446,18 +450,17 @@ namespace bg3se::lua
 		}
 	}
 
-	EventResult State::DispatchEvent(EventBase& evt, char const* eventName, bool canPreventAction, uint32_t restrictions)
+	EventResult State::DispatchEvent(SubscribableEvent& event, EventBase& evt, bool canPreventAction, uint32_t restrictions)
 	{
-		auto stackSize = lua_gettop(L) - 2;
+		// Event object is on the top of the stack
+		auto stackSize = lua_gettop(L);
 
 		try {
 			Restriction restriction(*this, restrictions);
-			evt.Name = FixedString(eventName);
+			evt.Name = event.GetName();
 			evt.CanPreventAction = canPreventAction;
-
-			if (!CheckedCall(L, 1, "_ThrowEvent")) {
-				return EventResult::Failed;
-			}
+			event.Throw(L, &evt);
+			lua_pop(L, 1);
 
 			if (evt.ActionPrevented) {
 				return EventResult::ActionPrevented;
@@ -467,13 +470,13 @@ namespace bg3se::lua
 		} catch (Exception&) {
 			auto stackRemaining = lua_gettop(L) - stackSize;
 			if (stackRemaining > 0) {
-				LuaError("Failed to dispatch event '" << eventName << "': " << lua_tostring(L, -1));
-				lua_pop(L, stackRemaining);
+				LuaError("Failed to dispatch event '" << event.GetName().GetString() << "': " << lua_tostring(L, -1));
 			}
 			else {
-				LuaError("Internal error while dispatching event '" << eventName << "'");
+				LuaError("Internal error while dispatching event '" << event.GetName().GetString() << "'");
 			}
 
+			lua_settop(L, stackSize - 1);
 			return EventResult::Failed;
 		}
 	}
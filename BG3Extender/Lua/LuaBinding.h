@@ -13,6 +13,7 @@
 #include <Lua/Shared/Proxies/LuaBitfieldValue.h>
 #include <Lua/Shared/Proxies/LuaUserVariableHolder.h>
 #include <Lua/Shared/EntityComponentEvents.h>
+#include <Lua/Shared/EngineEvents.h>
 #include <Extender/Shared/UserVariables.h>
 
 #include <mutex>
@@ -120,6 +121,11 @@ namespace bg3se::lua
 			return metatableManager_;
 		}
 
+		inline PropertyAccessCache& GetPropertyAccessCache()
+		{
+			return propertyAccessCache_;
+		}
+
 		inline CachedUserVariableManager& GetVariableManager()
 		{
 			return variableManager_;
@@ -143,6 +149,11 @@ namespace bg3se::lua
 			return entityHooks_;
 		}
 
+		EngineEventManager& GetEventManager()
+		{
+			return eventManager_;
+		}
+
 		void FinishStartup();
 		void LoadBootstrap(STDString const& path, STDString const& modTable);
 		virtual void OnGameSessionLoading();
@@ -184,11 +195,16 @@ namespace bg3se::lua
 		EventResult ThrowEvent(char const* eventName, TEvent& evt, bool canPreventAction = false, uint32_t restrictions = 0)
 		{
 			static_assert(std::is_base_of_v<EventBase, TEvent>, "Event object must be a descendant of EventBase");
+			auto event = eventManager_.GetEvent(eventName);
+			// Nothing to do if nobody is listening; avoid creating the event object
+			if (event == nullptr || !event->HasSubscribers()) {
+				return EventResult::Successful;
+			}
+
 			StackCheck _(L, 0);
 			LifetimeStackPin _p(GetStack());
-			PushInternalFunction(L, "_ThrowEvent");
 			MakeObjectRef(L, &evt);
-			return DispatchEvent(evt, eventName, canPreventAction, restrictions);
+			return DispatchEvent(*event, evt, canPreventAction, restrictions);
 		}
 
 		std::optional<int> LoadScript(STDString const & script, STDString const & name = "", int globalsIdx = 0);
@@ -208,13 +224,15 @@ namespace bg3se::lua
 		LifetimeHandle globalLifetime_;
 
 		CppMetatableManager metatableManager_;
+		PropertyAccessCache propertyAccessCache_;
 
 		CachedUserVariableManager variableManager_;
 		CachedModVariableManager modVariableManager_;
 		EntityComponentEventHooks entityHooks_;
+		EngineEventManager eventManager_;
 
 		void OpenLibs();
-		EventResult DispatchEvent(EventBase& evt, char const* eventName, bool canPreventAction, uint32_t restrictions);
+		EventResult DispatchEvent(SubscribableEvent& event, EventBase& evt, bool canPreventAction, uint32_t restrictions);
 	};
 
 	class Restriction
@@ -88,6 +88,11 @@ namespace bg3se::esv::lua
 	}
 
 	void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, bool allowNil)
+	{
+		LuaToOsi(L, i, tv, osiType, GetBaseType(osiType), allowNil);
+	}
+
+	void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, ValueType baseType, bool allowNil)
 	{
 		tv.VMT = gExtender->GetServer().Osiris().GetGlobals().TypedValueVMT;
 		tv.TypeId = (uint32_t)osiType;
@@ -98,7 +103,7 @@ namespace bg3se::esv::lua
 			return;
 		}
 
-		switch (GetBaseType(osiType)) {
+		switch (baseType) {
 		case ValueType::Integer:
 			tv.Value.Int32 = (int32_t)LuaToInt(L, i, type);
 			break;
@@ -142,6 +147,11 @@ namespace bg3se::esv::lua
 	}
 
 	void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, bool allowNil, bool reuseStrings)
+	{
+		LuaToOsi(L, i, arg, osiType, GetBaseType(osiType), allowNil, reuseStrings);
+	}
+
+	void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, ValueType baseType, bool allowNil, bool reuseStrings)
 	{
 		arg.TypeId = osiType;
 		auto type = lua_type(L, i);
@@ -150,7 +160,7 @@ namespace bg3se::esv::lua
 			return;
 		}
 
-		switch (GetBaseType(osiType)) {
+		switch (baseType) {
 		case ValueType::Integer:
 			arg.Int32 = (int32_t)LuaToInt(L, i, type);
 			break;
@@ -285,6 +295,64 @@ namespace bg3se::esv::lua
 	};
 
 
+	void OsiFunctionStub::Bind(Function const* func)
+	{
+		switch (func->Type) {
+		case FunctionType::Call:
+			CallKind = Kind::Call;
+			break;
+
+		case FunctionType::Event:
+		case FunctionType::Proc:
+			CallKind = Kind::Insert;
+			break;
+
+		case FunctionType::Database:
+		{
+			// User queries appear in the function table using the 'Database' type,
+			// however the node is a UserQueryNode, not a DatabaseNode.
+			// Catch this case by checking if the node is a descendant of a DataNode or not.
+			auto node = func->Node.Get();
+			if (node) {
+				CallKind = node->IsDataNode() ? Kind::Insert : Kind::UserQuery;
+			} else {
+				CallKind = Kind::Unsupported;
+			}
+			break;
+		}
+
+		case FunctionType::Query:
+			CallKind = Kind::Query;
+			break;
+
+		case FunctionType::SysQuery:
+		case FunctionType::UserQuery:
+			CallKind = Kind::UserQuery;
+			break;
+
+		default:
+			CallKind = Kind::Unsupported;
+			break;
+		}
+
+		auto const& outParams = func->Signature->OutParamList;
+		auto const& params = func->Signature->Params->Params;
+		Params.clear();
+		NumOutParams = 0;
+
+		auto argType = params.Head->Next;
+		for (uint32_t i = 0; i < params.Size; i++) {
+			auto type = (ValueType)argType->Item.Type;
+			bool out = outParams.isOutParam(i);
+			Params.push_back(Param{ type, GetBaseType(type), out });
+			if (out) {
+				NumOutParams++;
+			}
+
+			argType = argType->Next;
+		}
+	}
+
 	bool OsiFunction::Bind(Function const * func, ServerState & state)
 	{
 		if (func->Type == FunctionType::Query
@@ -307,6 +375,7 @@ namespace bg3se::esv::lua
 		}
 
 		function_ = func;
+		stub_ = state.Osiris().GetFunctionStub(func);
 		state_ = &state;
 		return true;
 	}
@@ -314,6 +383,7 @@ namespace bg3se::esv::lua
 	void OsiFunction::Unbind()
 	{
 		function_ = nullptr;
+		stub_ = nullptr;
 	}
 
 	int OsiFunction::LuaCall(lua_State * L)
@@ -331,87 +401,227 @@ namespace bg3se::esv::lua
 			return luaL_error(L, "Attempted to call Osiris function in restricted context");
 		}
 
-		switch (function_->Type) {
-		case FunctionType::Call:
+		switch (stub_->CallKind) {
+		case OsiFunctionStub::Kind::Call:
 			OsiCall(L);
 			return 0;
 
-		case FunctionType::Event:
-		case FunctionType::Proc:
+		case OsiFunctionStub::Kind::Insert:
 			OsiInsert(L, false);
 			return 0;
 
-		case FunctionType::Database:
-		{
-			// User queries appear in the function table using the 'Database' type,
-			// however the node is a UserQueryNode, not a DatabaseNode.
-			// Catch this case by checking if the node is a descendant of a DataNode or not.
-			auto node = function_->Node.Get();
-			if (node) {
-				if (node->IsDataNode()) {
-					OsiInsert(L, false);
-					return 0;
-				} else {
-					return OsiUserQuery(L);
-				}
-			} else {
-				return luaL_error(L, "Function has no node!");
-			}
-		}
-
-		case FunctionType::Query:
+		case OsiFunctionStub::Kind::Query:
 			return OsiQuery(L);
 
-		case FunctionType::SysQuery:
-		case FunctionType::UserQuery:
+		case OsiFunctionStub::Kind::UserQuery:
 			return OsiUserQuery(L);
 
-		case FunctionType::SysCall:
+		case OsiFunctionStub::Kind::Unsupported:
 		default:
-			return luaL_error(L, "Cannot call function of type %d", function_->Type);
+			if (function_->Type == FunctionType::Database) {
+				return luaL_error(L, "Function has no node!");
+			} else {
+				return luaL_error(L, "Cannot call function of type %d", function_->Type);
+			}
 		}
 	}
 
-	int OsiFunction::LuaGet(lua_State * L)
+	void OsiFunction::CheckDatabaseAccess(lua_State * L, char const * operation)
 	{
 		if (!IsBound()) {
-			return luaL_error(L, "Attempted to read an unbound Osiris database");
+			luaL_error(L, "Attempted to %s an unbound Osiris database", operation);
 		}
 
 		if (!IsDB()) {
-			return luaL_error(L, "Attempted to read function that's not a database");
+			luaL_error(L, "Attempted to %s function that's not a database", operation);
 		}
 
 		int numArgs = lua_gettop(L);
 		if (numArgs < 1) {
-			return luaL_error(L, "Read Osi database without 'self' argument?");
+			luaL_error(L, "Read Osi database without 'self' argument?");
 		}
 
 		if (state_->RestrictionFlags & State::RestrictOsiris) {
-			return luaL_error(L, "Attempted to read Osiris database in restricted context");
+			luaL_error(L, "Attempted to %s Osiris database in restricted context", operation);
 		}
+	}
 
-		auto db = function_->Node.Get()->Database.Get();
-		
+	// Calls fn for each fact matching the query parameters on the stack, until fn returns false.
+	// Uses the database index (if one was enabled) to avoid scanning the whole database.
+	template <class Fn>
+	void OsiFunction::ForEachMatch(lua_State * L, Database * db, Fn fn)
+	{
+		auto dbIndex = state_->Osiris().GetDatabaseIndices().GetIndex(function_, db);
+		auto facts = dbIndex ? ProbeIndex(L, 2, *dbIndex) : nullptr;
+
+		if (facts) {
+			for (auto fact : *facts) {
+				if (MatchTuple(L, 2, fact->Item) && !fn(fact->Item)) {
+					return;
+				}
+			}
+
+			return;
+		}
 
 		auto head = db->Facts.Head;
 		auto current = head->Next;
+		while (current != head) {
+			if (MatchTuple(L, 2, current->Item) && !fn(current->Item)) {
+				return;
+			}
 
+			current = current->Next;
+		}
+	}
+
+	int OsiFunction::LuaGet(lua_State * L)
+	{
+		CheckDatabaseAccess(L, "read");
+
+		auto db = function_->Node.Get()->Database.Get();
 		lua_newtable(L);
 		auto index = 1;
+		ForEachMatch(L, db, [&](TupleVec const& tuple) {
+			push(L, index++);
+			ConstructTuple(L, tuple);
+			lua_rawset(L, -3);
+			return true;
+		});
+
+		return 1;
+	}
+
+	int OsiFunction::LuaFirst(lua_State * L)
+	{
+		CheckDatabaseAccess(L, "read");
+
+		auto db = function_->Node.Get()->Database.Get();
+		TupleVec const* first{ nullptr };
+		ForEachMatch(L, db, [&](TupleVec const& tuple) {
+			first = &tuple;
+			return false;
+		});
+
+		if (first) {
+			return PushTupleValues(L, *first);
+		} else {
+			push(L, nullptr);
+			return 1;
+		}
+	}
+
+	int OsiFunction::LuaCount(lua_State * L)
+	{
+		CheckDatabaseAccess(L, "read");
+
+		auto db = function_->Node.Get()->Database.Get();
+		bool hasFilter{ false };
+		for (auto i = 2; i <= lua_gettop(L); i++) {
+			hasFilter = hasFilter || !lua_isnil(L, i);
+		}
+
+		if (!hasFilter) {
+			push(L, db->Facts.Size);
+			return 1;
+		}
+
+		uint64_t count{ 0 };
+		ForEachMatch(L, db, [&](TupleVec const& tuple) {
+			count++;
+			return true;
+		});
+
+		push(L, count);
+		return 1;
+	}
+
+	int OsiFunction::LuaIterate(lua_State * L)
+	{
+		CheckDatabaseAccess(L, "iterate");
+
+		auto db = function_->Node.Get()->Database.Get();
+		auto numParams = lua_gettop(L) - 1;
+		luaL_checkstack(L, numParams + 2, "too many parameters");
+
+		auto it = FactIterator::New(L, *this, state_->Osiris().GenerationId(), (uint32_t)numParams);
+		state_->Osiris().GetDatabaseIndices().PinCursor(it->Cursor, db, db->Facts.Head->Next);
+
+		for (auto i = 0; i < numParams; i++) {
+			lua_pushvalue(L, i + 2);
+		}
+
+		lua_pushcclosure(L, &LuaIteratorNext, numParams + 1);
+		return 1;
+	}
+
+	int OsiFunction::LuaIteratorNext(lua_State * L)
+	{
+		auto it = reinterpret_cast<FactIterator*>(lua_touserdata(L, lua_upvalueindex(1)));
+		auto& self = it->Function;
+		if (self.state_->RestrictionFlags & State::RestrictOsiris) {
+			return luaL_error(L, "Attempted to iterate Osiris database in restricted context");
+		}
+
+		if (self.state_->Osiris().GenerationId() != it->GenerationId) {
+			return luaL_error(L, "Story was reloaded while iterating database '%s'", self.function_->Signature->Name);
+		}
+
+		auto& cursor = it->Cursor;
+		if (cursor.Manager == nullptr) {
+			// Iteration already finished
+			push(L, nullptr);
+			return 1;
+		}
+
+		// Facts deleted by the loop body were already skipped by the delete hook
+		auto head = cursor.Db->Facts.Head;
+
+		// Query parameters are expected to start at stack index 2
+		lua_settop(L, 1);
+		luaL_checkstack(L, it->NumParams + 1, "too many parameters");
+		for (uint32_t i = 0; i < it->NumParams; i++) {
+			lua_pushvalue(L, lua_upvalueindex(i + 2));
+		}
+
+		auto current = cursor.Next;
 		while (current != head) {
-			if (MatchTuple(L, 2, current->Item)) {
-				push(L, index++);
-				ConstructTuple(L, current->Item);
-				lua_rawset(L, -3);
+			if (self.MatchTuple(L, 2, current->Item)) {
+				cursor.Next = current->Next;
+				return self.PushTupleValues(L, current->Item);
 			}
 
 			current = current->Next;
 		}
 
+		cursor.Manager->UnpinCursor(cursor);
+		push(L, nullptr);
 		return 1;
 	}
 
+	OsirisDatabaseIndex::Bucket const* OsiFunction::ProbeIndex(lua_State * L, int firstIndex, OsirisDatabaseIndex & index)
+	{
+		// Probe every bound column and use the smallest candidate list;
+		// returns null if no bound columns are indexable, in which case the whole database is scanned
+		OsirisDatabaseIndex::Bucket const* best{ nullptr };
+		auto numArgs = lua_gettop(L) - firstIndex + 1;
+		auto argType = function_->Signature->Params->Params.Head->Next;
+		for (int i = 0; i < numArgs; i++, argType = argType->Next) {
+			if (lua_isnil(L, firstIndex + i) || !index.IsIndexable(i)) continue;
+
+			auto key = GetLuaIndexKey(L, firstIndex + i, (ValueType)argType->Item.Type);
+			if (!key) continue;
+
+			auto facts = index.Probe(i, *key);
+			if (facts && (best == nullptr || facts->size() < best->size())) {
+				best = facts;
+				if (best->empty()) break;
+			}
+		}
+
+		return best;
+	}
+
 	int OsiFunction::LuaDelete(lua_State * L)
 	{
 		if (!IsBound()) {
@@ -435,6 +645,171 @@ namespace bg3se::esv::lua
 		return 0;
 	}
 
+	void OsiFunction::CheckWritableDatabase(lua_State * L, char const * operation)
+	{
+		CheckDatabaseAccess(L, operation);
+
+		// User queries are registered with the 'Database' type as well
+		if (stub_->CallKind != OsiFunctionStub::Kind::Insert) {
+			luaL_error(L, "Attempted to %s function that's not a database", operation);
+		}
+
+		if (function_->Node.Id == 0) {
+			luaL_error(L, "Function has no node");
+		}
+	}
+
+	int OsiFunction::LuaInsertMany(lua_State * L, int rowsIndex)
+	{
+		CheckWritableDatabase(L, "insert into");
+		ValidateRows(L, rowsIndex, false);
+		push(L, OsiInsertRows(L, rowsIndex, false, false));
+		return 1;
+	}
+
+	int OsiFunction::LuaDeleteMany(lua_State * L, int rowsIndex)
+	{
+		CheckWritableDatabase(L, "delete from");
+		ValidateRows(L, rowsIndex, true);
+		push(L, OsiInsertRows(L, rowsIndex, true, false));
+		return 1;
+	}
+
+	int OsiFunction::LuaReplace(lua_State * L, int rowsIndex)
+	{
+		CheckWritableDatabase(L, "replace rows of");
+		// Rows are validated and converted before deleting anything, so a bad row leaves the database untouched
+		ValidateRows(L, rowsIndex, false);
+		push(L, OsiInsertRows(L, rowsIndex, false, true));
+		return 1;
+	}
+
+	// Checks the row count and value types of every row without converting them,
+	// so conversion errors can't interrupt a batch halfway through
+	void OsiFunction::ValidateRows(lua_State * L, int rowsIndex, bool allowNil)
+	{
+		auto numRows = (uint32_t)lua_rawlen(L, rowsIndex);
+		auto numColumns = stub_->Params.size();
+		for (uint32_t row = 1; row <= numRows; row++) {
+			if (lua_rawgeti(L, rowsIndex, row) != LUA_TTABLE) {
+				luaL_error(L, "Row %d of '%s' is not a table", row, function_->Signature->Name);
+			}
+
+			// Trailing nil columns of deleted rows don't count towards the length
+			auto rowLength = (uint32_t)lua_rawlen(L, -1);
+			if (allowNil ? rowLength > numColumns : rowLength != numColumns) {
+				luaL_error(L, "Row %d of '%s' has %d columns; expected %s%d", 
+					row, function_->Signature->Name, rowLength, allowNil ? "at most " : "", numColumns);
+			}
+
+			for (uint32_t i = 0; i < numColumns; i++) {
+				auto type = lua_rawgeti(L, -1, i + 1);
+				bool ok;
+				switch (stub_->Params[i].BaseType) {
+				case ValueType::Integer:
+				case ValueType::Integer64:
+					ok = (type == LUA_TNUMBER || type == LUA_TLIGHTUSERDATA);
+					break;
+
+				case ValueType::Real:
+					ok = (type == LUA_TNUMBER);
+					break;
+
+				case ValueType::String:
+				case ValueType::GuidString:
+					ok = (type == LUA_TSTRING);
+					break;
+
+				default:
+					ok = false;
+					break;
+				}
+
+				if (!ok && !(allowNil && type == LUA_TNIL)) {
+					luaL_error(L, "Row %d of '%s': unexpected %s value in column %d", 
+						row, function_->Signature->Name, lua_typename(L, type), i + 1);
+				}
+
+				lua_pop(L, 1);
+			}
+
+			lua_pop(L, 1);
+		}
+	}
+
+	uint32_t OsiFunction::OsiInsertRows(lua_State * L, int rowsIndex, bool deleteTuple, bool deleteAll)
+	{
+		auto numRows = (uint32_t)lua_rawlen(L, rowsIndex);
+		auto numColumns = stub_->Params.size();
+
+		// Every row is converted before the first insert, as inserts can run rules and Lua listeners
+		// that throw errors or modify the row table
+		OsiArgumentListPin<TypedValue> tvs(state_->Osiris().GetTypedValuePool(), numRows * numColumns);
+		OsiArgumentListPin<ListNode<TypedValue *>> nodes(state_->Osiris().GetTypedValueNodePool(), numRows * (numColumns + 1));
+		std::vector<TuplePtrLL> tuples(numRows);
+
+		for (uint32_t row = 0; row < numRows; row++) {
+			lua_rawgeti(L, rowsIndex, row + 1);
+			auto rowIndex = lua_gettop(L);
+
+			auto rowValues = tvs.Args() + row * numColumns;
+			auto rowNodes = nodes.Args() + row * (numColumns + 1);
+			auto & args = tuples[row].Items;
+			args.Init(rowNodes);
+
+			auto prev = args.Head;
+			for (uint32_t i = 0; i < numColumns; i++) {
+				lua_rawgeti(L, rowIndex, i + 1);
+				auto tv = rowValues + i;
+				auto const& param = stub_->Params[i];
+				LuaToOsi(L, rowIndex + 1, *tv, param.Type, param.BaseType, deleteTuple);
+				lua_pop(L, 1);
+
+				auto node = rowNodes + i + 1;
+				args.Insert(tv, node, prev);
+				prev = node;
+			}
+
+			lua_pop(L, 1);
+		}
+
+		if (deleteAll) {
+			OsiDeleteAll();
+		}
+
+		for (auto & tuple : tuples) {
+			OsiInsertTuple(tuple, deleteTuple);
+		}
+
+		return numRows;
+	}
+
+	void OsiFunction::OsiDeleteAll()
+	{
+		auto numColumns = stub_->Params.size();
+		OsiArgumentListPin<TypedValue> tvs(state_->Osiris().GetTypedValuePool(), numColumns);
+		OsiArgumentListPin<ListNode<TypedValue *>> nodes(state_->Osiris().GetTypedValueNodePool(), numColumns + 1);
+
+		TuplePtrLL tuple;
+		auto & args = tuple.Items;
+		args.Init(nodes.Args());
+
+		// A tuple with no bound columns matches every fact
+		auto prev = args.Head;
+		for (uint32_t i = 0; i < numColumns; i++) {
+			auto tv = tvs.Args() + i;
+			tv->VMT = gExtender->GetServer().Osiris().GetGlobals().TypedValueVMT;
+			tv->TypeId = (uint32_t)ValueType::None;
+			auto node = nodes.Args() + i + 1;
+			args.Insert(tv, node, prev);
+			prev = node;
+		}
+
+		// Open iterators of the database end here; rows inserted afterwards (eg. by Replace) aren't visited
+		state_->Osiris().GetDatabaseIndices().EndCursors(function_->Node.Get()->Database.Get());
+		OsiInsertTuple(tuple, true);
+	}
+
 	int OsiFunction::LuaDeferredNotification(lua_State * L)
 	{
 		if (function_ == nullptr) {
@@ -524,9 +899,61 @@ namespace bg3se::esv::lua
 		}
 	}
 
+	int OsiFunction::PushTupleValues(lua_State * L, TupleVec const & tuple)
+	{
+		luaL_checkstack(L, tuple.Size, "too many columns");
+		for (auto i = 0; i < tuple.Size; i++) {
+			OsiToLua(L, tuple.Values[i]);
+		}
+
+		return tuple.Size;
+	}
+
+	uint32_t OsiFunction::GetStringArgumentSize(lua_State * L)
+	{
+		uint32_t size{ 0 };
+		int index = 2;
+		for (auto const& param : stub_->Params) {
+			if (param.Out) continue;
+
+			if ((param.BaseType == ValueType::String || param.BaseType == ValueType::GuidString)
+				&& lua_type(L, index) == LUA_TSTRING) {
+				size_t len;
+				lua_tolstring(L, index, &len);
+				size += (uint32_t)len + 1;
+			}
+
+			index++;
+		}
+
+		return size;
+	}
+
+	void OsiFunction::LuaToStubArgument(lua_State * L, int i, OsiArgumentValue & arg, OsiFunctionStub::Param const & param, char *& strings)
+	{
+		if (param.BaseType != ValueType::String && param.BaseType != ValueType::GuidString) {
+			LuaToOsi(L, i, arg, param.Type, param.BaseType, false, false);
+			return;
+		}
+
+		auto type = lua_type(L, i);
+		if (type != LUA_TSTRING) {
+			luaL_error(L, "String expected for argument %d, got %s", i, lua_typename(L, type));
+		}
+
+		// Call/query arguments only need to live until the call returns,
+		// so they're copied to the string pool instead of being duplicated on the heap
+		size_t len;
+		auto str = lua_tolstring(L, i, &len);
+		memcpy(strings, str, len + 1);
+		arg.TypeId = param.Type;
+		arg.String = strings;
+		strings += len + 1;
+	}
+
 	void OsiFunction::OsiCall(lua_State * L)
 	{
-		auto funcArgs = function_->Signature->Params->Params.Size;
+		auto funcArgs = stub_->Params.size();
 		int numArgs = lua_gettop(L);
 		if (numArgs - 1 != funcArgs) {
 			luaL_error(L, "Incorrect number of arguments for '%s'; expected %d, got %d",
@@ -534,14 +961,14 @@ namespace bg3se::esv::lua
 		}
 
 		OsiArgumentListPin<OsiArgumentDesc> args(state_->Osiris().GetArgumentDescPool(), (uint32_t)funcArgs);
-		auto argType = function_->Signature->Params->Params.Head->Next;
+		OsiArgumentListPin<char> strings(state_->Osiris().GetStringPool(), GetStringArgumentSize(L));
+		auto nextString = strings.Args();
 		for (uint32_t i = 0; i < funcArgs; i++) {
 			auto arg = args.Args() + i;
 			if (i > 0) {
 				args.Args()[i - 1].NextParam = arg;
 			}
-			LuaToOsi(L, i + 2, arg->Value, (ValueType)argType->Item.Type);
-			argType = argType->Next;
+			LuaToStubArgument(L, i + 2, arg->Value, stub_->Params[i], nextString);
 		}
 
 		gExtender->GetServer().Osiris().GetWrappers().Call.CallWithHooks(function_->GetHandle(), funcArgs == 0 ? nullptr : args.Args());
@@ -587,7 +1014,7 @@ namespace bg3se::esv::lua
 
 	void OsiFunction::OsiInsert(lua_State * L, bool deleteTuple)
 	{
-		auto funcArgs = function_->Signature->Params->Params.Size;
+		auto funcArgs = stub_->Params.size();
 		int numArgs = lua_gettop(L);
 		if (numArgs - 1 != funcArgs) {
 			luaL_error(L, "Incorrect number of arguments for '%s'; expected %d, got %d",
@@ -603,31 +1030,46 @@ namespace bg3se::esv::lua
 
 		TuplePtrLL tuple;
 		auto & args = tuple.Items;
-		auto argType = function_->Signature->Params->Params.Head->Next;
 		args.Init(nodes.Args());
 
 		auto prev = args.Head;
 		for (uint32_t i = 0; i < funcArgs; i++) {
 			auto tv = tvs.Args() + i;
-			LuaToOsi(L, i + 2, *tv, (ValueType)argType->Item.Type, deleteTuple);
+			auto const& param = stub_->Params[i];
+			LuaToOsi(L, i + 2, *tv, param.Type, param.BaseType, deleteTuple);
 			auto node = nodes.Args() + i + 1;
 			args.Insert(tv, node, prev);
 			prev = node;
-			argType = argType->Next;
 		}
 
+		OsiInsertTuple(tuple, deleteTuple);
+	}
+
+	void OsiFunction::OsiInsertTuple(TuplePtrLL & tuple, bool deleteTuple)
+	{
 		auto node = function_->Node.Get();
+		// When the node VMTs are hooked, database indices are updated by the insert/delete hooks
+		auto& indices = state_->Osiris().GetDatabaseIndices();
+		bool updateIndices = !state_->Osiris().GetOsirisCallbacks().IsHooked();
+		if (updateIndices) {
+			indices.InsertPreHook(node, &tuple, deleteTuple);
+		}
+
 		if (deleteTuple) {
 			node->DeleteTuple(&tuple);
 		} else {
 			node->InsertTuple(&tuple);
 		}
+
+		if (updateIndices) {
+			indices.InsertPostHook(node, &tuple, deleteTuple);
+		}
 	}
 
 	int OsiFunction::OsiQuery(lua_State * L)
 	{
-		auto outParams = function_->Signature->OutParamList.numOutParams();
-		auto numParams = function_->Signature->Params->Params.Size;
+		auto outParams = stub_->NumOutParams;
+		auto numParams = stub_->Params.size();
 		auto inParams = numParams - outParams;
 
 		int numArgs = lua_gettop(L);
@@ -637,7 +1079,8 @@ namespace bg3se::esv::lua
 		}
 
 		OsiArgumentListPin<OsiArgumentDesc> args(state_->Osiris().GetArgumentDescPool(), (uint32_t)numParams);
-		auto argType = function_->Signature->Params->Params.Head->Next;
+		OsiArgumentListPin<char> strings(state_->Osiris().GetStringPool(), GetStringArgumentSize(L));
+		auto nextString = strings.Args();
 		uint32_t inputArg = 2;
 		for (uint32_t i = 0; i < numParams; i++) {
 			auto arg = args.Args() + i;
@@ -645,13 +1088,12 @@ namespace bg3se::esv::lua
 				args.Args()[i - 1].NextParam = arg;
 			}
 
-			if (function_->Signature->OutParamList.isOutParam(i)) {
-				arg->Value.TypeId = (ValueType)argType->Item.Type;
+			auto const& param = stub_->Params[i];
+			if (param.Out) {
+				arg->Value.TypeId = param.Type;
 			} else {
-				LuaToOsi(L, inputArg++, arg->Value, (ValueType)argType->Item.Type);
+				LuaToStubArgument(L, inputArg++, arg->Value, param, nextString);
 			}
-
-			argType = argType->Next;
 		}
 
 		bool handled = gExtender->GetServer().Osiris().GetWrappers().Query.CallWithHooks(function_->GetHandle(), numParams == 0 ? nullptr : args.Args());
@@ -661,7 +1103,7 @@ namespace bg3se::esv::lua
 		} else {
 			if (handled) {
 				for (uint32_t i = 0; i < numParams; i++) {
-					if (function_->Signature->OutParamList.isOutParam(i)) {
+					if (stub_->Params[i].Out) {
 						OsiToLua(L, args.Args()[i].Value);
 					}
 				}
@@ -677,8 +1119,8 @@ namespace bg3se::esv::lua
 
 	int OsiFunction::OsiUserQuery(lua_State * L)
 	{
-		auto outParams = function_->Signature->OutParamList.numOutParams();
-		auto numParams = function_->Signature->Params->Params.Size;
+		auto outParams = stub_->NumOutParams;
+		auto numParams = stub_->Params.size();
 		auto inParams = numParams - outParams;
 
 		int numArgs = lua_gettop(L);
@@ -692,7 +1134,6 @@ namespace bg3se::esv::lua
 		VirtTupleLL tuple;
 		
 		auto & args = tuple.Data.Items;
-		auto argType = function_->Signature->Params->Params.Head->Next;
 		args.Init(nodes.Args());
 
 		auto prev = args.Head;
@@ -701,8 +1142,9 @@ namespace bg3se::esv::lua
 			auto node = nodes.Args() + i + 1;
 			args.Insert(node, prev);
 			node->Item.Index = i;
-			if (!function_->Signature->OutParamList.isOutParam(i)) {
-				LuaToOsi(L, inputArgIndex + 2, node->Item.Value, (ValueType)argType->Item.Type);
+			auto const& param = stub_->Params[i];
+			if (!param.Out) {
+				LuaToOsi(L, inputArgIndex + 2, node->Item.Value, param.Type, param.BaseType, false);
 				inputArgIndex++;
 			} else {
 				node->Item.Value.VMT = gExtender->GetServer().Osiris().GetGlobals().TypedValueVMT;
@@ -710,22 +1152,19 @@ namespace bg3se::esv::lua
 			}
 
 			prev = node;
-			argType = argType->Next;
 		}
 
 		auto node = (*gExtender->GetServer().Osiris().GetGlobals().Nodes)->Db.Elements[function_->Node.Id - 1];
 		bool valid = node->IsValid(&tuple, adapter_.Id);
 		if (valid) {
 			if (outParams > 0) {
-				auto retType = function_->Signature->Params->Params.Head->Next;
 				auto ret = args.Head->Next;
 				for (uint32_t i = 0; i < numParams; i++) {
-					if (function_->Signature->OutParamList.isOutParam(i)) {
+					if (stub_->Params[i].Out) {
 						OsiToLua(L, ret->Item.Value);
 					}
 
 					ret = ret->Next;
-					retType = retType->Next;
 				}
 
 				return outParams;
@@ -750,6 +1189,14 @@ namespace bg3se::esv::lua
 
 
 	char const * const OsiFunctionNameProxy::MetatableName = "OsiFunctionNameProxy";
+	char const * const OsiFunction::FactIterator::MetatableName = "OsiFactIterator";
+
+	OsiFunction::FactIterator::~FactIterator()
+	{
+		if (Cursor.Manager != nullptr) {
+			Cursor.Manager->UnpinCursor(Cursor);
+		}
+	}
 
 	void OsiFunctionNameProxy::PopulateMetatable(lua_State * L)
 	{
@@ -758,12 +1205,30 @@ namespace bg3se::esv::lua
 		lua_pushcfunction(L, &LuaGet);
 		lua_setfield(L, -2, "Get");
 
+		lua_pushcfunction(L, &LuaIterate);
+		lua_setfield(L, -2, "Iterate");
+
+		lua_pushcfunction(L, &LuaFirst);
+		lua_setfield(L, -2, "First");
+
+		lua_pushcfunction(L, &LuaCount);
+		lua_setfield(L, -2, "Count");
+
 		lua_pushcfunction(L, &LuaDelete);
 		lua_setfield(L, -2, "Delete");
 
 		lua_pushcfunction(L, &LuaDeferredNotification);
 		lua_setfield(L, -2, "Defer");
 
+		lua_pushcfunction(L, &LuaInsertMany);
+		lua_setfield(L, -2, "InsertMany");
+
+		lua_pushcfunction(L, &LuaDeleteMany);
+		lua_setfield(L, -2, "DeleteMany");
+
+		lua_pushcfunction(L, &LuaReplace);
+		lua_setfield(L, -2, "Replace");
+
 		lua_setfield(L, -2, "__index");
 	}
 
@@ -807,23 +1272,71 @@ namespace bg3se::esv::lua
 		return func->LuaCall(L);
 	}
 
-	int OsiFunctionNameProxy::LuaGet(lua_State * L)
+	OsiFunction * OsiFunctionNameProxy::CheckDatabase(lua_State * L)
 	{
 		auto self = OsiFunctionNameProxy::CheckUserData(L, 1);
-		if (!self->BeforeCall(L)) return 1;
+		self->BeforeCall(L);
 
 		auto arity = (uint32_t)lua_gettop(L) - 1;
+		return CheckDatabase(L, self, arity);
+	}
+
+	// Bulk operations take a list of rows and an optional column count;
+	// if no column count is passed, it's determined from the first row
+	OsiFunction * OsiFunctionNameProxy::CheckBulkDatabase(lua_State * L)
+	{
+		auto self = OsiFunctionNameProxy::CheckUserData(L, 1);
+		self->BeforeCall(L);
+		luaL_checktype(L, 2, LUA_TTABLE);
 
+		uint32_t arity;
+		if (!lua_isnoneornil(L, 3)) {
+			arity = get<uint32_t>(L, 3);
+		} else {
+			if (lua_rawgeti(L, 2, 1) != LUA_TTABLE) {
+				luaL_error(L, "Cannot determine column count of database '%s'; pass the column count explicitly", self->name_.c_str());
+			}
+
+			arity = (uint32_t)lua_rawlen(L, -1);
+			lua_pop(L, 1);
+		}
+
+		lua_settop(L, 2);
+		return CheckDatabase(L, self, arity);
+	}
+
+	OsiFunction * OsiFunctionNameProxy::CheckDatabase(lua_State * L, OsiFunctionNameProxy * self, uint32_t arity)
+	{
 		auto func = self->TryGetFunction(arity);
 		if (func == nullptr) {
-			return luaL_error(L, "No database named '%s(%d)' exists", self->name_.c_str(), arity);
+			luaL_error(L, "No database named '%s(%d)' exists", self->name_.c_str(), arity);
 		}
 
 		if (!func->IsDB()) {
-			return luaL_error(L, "Function '%s(%d)' is not a database", self->name_.c_str(), arity);
+			luaL_error(L, "Function '%s(%d)' is not a database", self->name_.c_str(), arity);
 		}
 
-		return func->LuaGet(L);
+		return func;
+	}
+
+	int OsiFunctionNameProxy::LuaGet(lua_State * L)
+	{
+		return CheckDatabase(L)->LuaGet(L);
+	}
+
+	int OsiFunctionNameProxy::LuaIterate(lua_State * L)
+	{
+		return CheckDatabase(L)->LuaIterate(L);
+	}
+
+	int OsiFunctionNameProxy::LuaFirst(lua_State * L)
+	{
+		return CheckDatabase(L)->LuaFirst(L);
+	}
+
+	int OsiFunctionNameProxy::LuaCount(lua_State * L)
+	{
+		return CheckDatabase(L)->LuaCount(L);
 	}
 
 	int OsiFunctionNameProxy::LuaDelete(lua_State * L)
@@ -861,6 +1374,21 @@ namespace bg3se::esv::lua
 		return func->LuaDeferredNotification(L);
 	}
 
+	int OsiFunctionNameProxy::LuaInsertMany(lua_State * L)
+	{
+		return CheckBulkDatabase(L)->LuaInsertMany(L, 2);
+	}
+
+	int OsiFunctionNameProxy::LuaDeleteMany(lua_State * L)
+	{
+		return CheckBulkDatabase(L)->LuaDeleteMany(L, 2);
+	}
+
+	int OsiFunctionNameProxy::LuaReplace(lua_State * L)
+	{
+		return CheckBulkDatabase(L)->LuaReplace(L, 2);
+	}
+
 	OsiFunction * OsiFunctionNameProxy::TryGetFunction(uint32_t arity)
 	{
 		if (functions_.size() > arity
@@ -36,8 +36,8 @@ void PendingCallbackManager::Exit(Array<uint32_t>* v)
 }
 
 
-OsirisCallbackManager::OsirisCallbackManager(ExtensionState& state)
-	: state_(state)
+OsirisCallbackManager::OsirisCallbackManager(ExtensionState& state, OsirisDatabaseIndexManager& databaseIndices)
+	: state_(state), databaseIndices_(databaseIndices)
 {}
 
 OsirisCallbackManager::~OsirisCallbackManager()
@@ -324,10 +324,14 @@ void OsirisCallbackManager::InsertPreHook(Node* node, TuplePtrLL* tuple, bool de
 	}
 
 	RunHandlers(nodeRef, tuple);
+	// Called after the Lua handlers, as they may modify the database as well
+	databaseIndices_.InsertPreHook(node, tuple, deleted);
 }
 
 void OsirisCallbackManager::InsertPostHook(Node* node, TuplePtrLL* tuple, bool deleted)
 {
+	databaseIndices_.InsertPostHook(node, tuple, deleted);
+
 	uint64_t nodeRef = node->Id | AfterTriggerNodeRef;
 	if (deleted) {
 		nodeRef |= DeleteTriggerNodeRef;
@@ -375,7 +379,7 @@ void OsirisCallbackManager::EventPostHook(Function* node, OsiArgumentDesc* args)
 
 OsirisBinding::OsirisBinding(ExtensionState& state)
 	: identityAdapters_(gExtender->GetServer().Osiris().GetGlobals()),
-	osirisCallbacks_(state)
+	osirisCallbacks_(state, databaseIndices_)
 {
 	identityAdapters_.UpdateAdapters();
 }
@@ -388,9 +392,25 @@ OsirisBinding::~OsirisBinding()
 	}
 }
 
+OsiFunctionStub const* OsirisBinding::GetFunctionStub(Function const* func)
+{
+	auto it = functionStubs_.find(func);
+	if (it != functionStubs_.end()) {
+		return it->second.get();
+	}
+
+	auto stub = std::make_unique<OsiFunctionStub>();
+	stub->Bind(func);
+	auto ptr = stub.get();
+	functionStubs_.insert(std::make_pair(func, std::move(stub)));
+	return ptr;
+}
+
 void OsirisBinding::StoryLoaded()
 {
 	generationId_++;
+	functionStubs_.clear();
+	databaseIndices_.Clear();
 	identityAdapters_.UpdateAdapters();
 	if (!identityAdapters_.HasAllAdapters()) {
 		OsiWarn("Not all identity adapters are available - some queries may not work!");
@@ -5,6 +5,7 @@
 #include <Osiris/Shared/CustomFunctions.h>
 #include <Extender/Shared/ExtensionHelpers.h>
 #include <Osiris/Shared/OsirisHelpers.h>
+#include <Lua/Server/OsirisDatabaseIndex.h>
 
 BEGIN_NS(esv)
 
@@ -52,13 +53,44 @@ BEGIN_NS(esv::lua)
 
 using namespace bg3se::lua;
 
+ValueType GetBaseType(ValueType type);
 void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, bool allowNil = false);
 TypedValue * LuaToOsi(lua_State * L, int i, ValueType osiType, bool allowNil = false);
 void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, bool allowNil = false, bool reuseStrings = false);
+void LuaToOsi(lua_State * L, int i, TypedValue & tv, ValueType osiType, ValueType baseType, bool allowNil);
+void LuaToOsi(lua_State * L, int i, OsiArgumentValue & arg, ValueType osiType, ValueType baseType, bool allowNil, bool reuseStrings);
 void OsiToLua(lua_State * L, OsiArgumentValue const & arg);
 void OsiToLua(lua_State * L, TypedValue const & tv);
 Function const* LookupOsiFunction(STDString const& name, uint32_t arity);
 
+// Call information of an Osiris function, resolved once per story generation when a Lua proxy is bound to the function.
+// Lets calls skip signature list walks and type alias lookups.
+struct OsiFunctionStub
+{
+	enum class Kind : uint8_t
+	{
+		Unsupported,
+		Call,
+		Insert,
+		Query,
+		UserQuery
+	};
+
+	struct Param
+	{
+		// Declared type of the parameter (may be an alias type)
+		ValueType Type;
+		ValueType BaseType;
+		bool Out;
+	};
+
+	Kind CallKind{ Kind::Unsupported };
+	uint32_t NumOutParams{ 0 };
+	Array<Param> Params;
+
+	void Bind(Function const* func);
+};
+
 class OsiFunction
 {
 public:
@@ -77,24 +109,69 @@ public:
 
 	int LuaCall(lua_State * L);
 	int LuaGet(lua_State * L);
+	int LuaIterate(lua_State * L);
+	int LuaFirst(lua_State * L);
+	int LuaCount(lua_State * L);
 	int LuaDelete(lua_State * L);
 	int LuaDeferredNotification(lua_State * L);
+	// Bulk insert/delete of the rows in the table at rowsIndex; returns the number of rows processed
+	int LuaInsertMany(lua_State * L, int rowsIndex);
+	int LuaDeleteMany(lua_State * L, int rowsIndex);
+	int LuaReplace(lua_State * L, int rowsIndex);
+
+	struct FactIterator;
 
 private:
+
 	Function const * function_{ nullptr };
+	OsiFunctionStub const * stub_{ nullptr };
 	AdapterRef adapter_;
 	ServerState * state_;
 
+	static int LuaIteratorNext(lua_State * L);
+	void CheckDatabaseAccess(lua_State * L, char const * operation);
+	void CheckWritableDatabase(lua_State * L, char const * operation);
+	template <class Fn>
+	void ForEachMatch(lua_State * L, Database * db, Fn fn);
+	int PushTupleValues(lua_State * L, TupleVec const & tuple);
+
 	void OsiCall(lua_State * L);
 	void OsiDeferredNotification(lua_State * L);
 	void OsiInsert(lua_State * L, bool deleteTuple);
+	void ValidateRows(lua_State * L, int rowsIndex, bool allowNil);
+	// Inserts (or deletes) every row; deleteAll: remove all facts before inserting. Returns the number of rows
+	uint32_t OsiInsertRows(lua_State * L, int rowsIndex, bool deleteTuple, bool deleteAll);
+	void OsiDeleteAll();
+	void OsiInsertTuple(TuplePtrLL & tuple, bool deleteTuple);
 	int OsiQuery(lua_State * L);
 	int OsiUserQuery(lua_State * L);
+	uint32_t GetStringArgumentSize(lua_State * L);
+	void LuaToStubArgument(lua_State * L, int i, OsiArgumentValue & arg, OsiFunctionStub::Param const & param, char *& strings);
 
 	bool MatchTuple(lua_State * L, int firstIndex, TupleVec const & tuple);
+	OsirisDatabaseIndex::Bucket const* ProbeIndex(lua_State * L, int firstIndex, OsirisDatabaseIndex & index);
 	void ConstructTuple(lua_State * L, TupleVec const & tuple);
 };
 
+// State of an Iterate() call; stored in the first upvalue of the iterator closure,
+// the query parameters are stored in the remaining upvalues
+struct OsiFunction::FactIterator : public Userdata<FactIterator>
+{
+	static char const * const MetatableName;
+
+	inline FactIterator(OsiFunction const & function, uint32_t generationId, uint32_t numParams)
+		: Function(function), GenerationId(generationId), NumParams(numParams)
+	{}
+
+	~FactIterator();
+
+	OsiFunction Function;
+	// Next fact to check (the current one may be deleted by the loop body); unpinned when the iteration ends
+	FactCursor Cursor;
+	uint32_t GenerationId;
+	uint32_t NumParams;
+};
+
 class OsiFunctionNameProxy : public Userdata<OsiFunctionNameProxy>, public Callable
 {
 public:
@@ -117,10 +194,19 @@ private:
 	uint32_t generationId_;
 
 	static int LuaGet(lua_State * L);
+	static int LuaIterate(lua_State * L);
+	static int LuaFirst(lua_State * L);
+	static int LuaCount(lua_State * L);
 	static int LuaDelete(lua_State * L);
 	static int LuaDeferredNotification(lua_State * L);
+	static int LuaInsertMany(lua_State * L);
+	static int LuaDeleteMany(lua_State * L);
+	static int LuaReplace(lua_State * L);
 	bool BeforeCall(lua_State * L);
 	OsiFunction * TryGetFunction(uint32_t arity);
+	static OsiFunction * CheckDatabase(lua_State * L);
+	static OsiFunction * CheckDatabase(lua_State * L, OsiFunctionNameProxy * self, uint32_t arity);
+	static OsiFunction * CheckBulkDatabase(lua_State * L);
 	OsiFunction * CreateFunctionMapping(uint32_t arity, Function const * func);
 };
 
@@ -162,25 +248,54 @@ inline void OsiReleaseArgument(OsiArgumentDesc & arg)
 inline void OsiReleaseArgument(TypedValue & arg) {}
 inline void OsiReleaseArgument(ListNode<TypedValue *> & arg) {}
 inline void OsiReleaseArgument(ListNode<TupleLL::Item> & arg) {}
+inline void OsiReleaseArgument(char & arg) {}
 
+// Stack allocator for temporary Osiris argument lists.
+// Lists must be released in reverse order of allocation; storage grows in blocks,
+// so lists that are still in use (eg. by an outer Lua -> Osiris call) are never moved.
 template <class T>
 class OsiArgumentPool
 {
 public:
+	// Number of arguments per block; longer lists are allocated in a dedicated block
+	static constexpr uint32_t BlockSize = 1024;
+
+	struct Allocation
+	{
+		// Top of the pool before the list was allocated
+		uint32_t PrevBlock;
+		uint32_t PrevUsed;
+		// Location of the list
+		uint32_t Block;
+		uint32_t Offset;
+	};
+
 	OsiArgumentPool()
 	{
-		argumentPool_.resize(1024);
-		usedArguments_ = 0;
+		AddBlock(BlockSize);
 	}
 
-	T * AllocateArguments(uint32_t num, uint32_t & tail)
+	T * AllocateArguments(uint32_t num, Allocation & alloc)
 	{
-		if (usedArguments_ + num > argumentPool_.size()) {
-			throw std::runtime_error("Ran out of argument descriptors");
+		alloc.PrevBlock = currentBlock_;
+		alloc.PrevUsed = usedArguments_;
+
+		if (usedArguments_ + num > blocks_[currentBlock_].Size) {
+			// Blocks after the current one are unused, so they can be replaced if too small
+			auto next = currentBlock_ + 1;
+			if (next == blocks_.size()) {
+				AddBlock(std::max(BlockSize, num));
+			} else if (blocks_[next].Size < num) {
+				blocks_[next] = Block{ std::make_unique<T[]>(num), num };
+			}
+
+			currentBlock_ = next;
+			usedArguments_ = 0;
 		}
 
-		tail = usedArguments_;
-		auto ptr = argumentPool_.data() + usedArguments_;
+		alloc.Block = currentBlock_;
+		alloc.Offset = usedArguments_;
+		auto ptr = blocks_[currentBlock_].Items.get() + usedArguments_;
 		for (uint32_t i = 0; i < num; i++) {
 			new (ptr + i) T();
 		}
@@ -189,22 +304,36 @@ public:
 		return ptr;
 	}
 
-	void ReleaseArguments(uint32_t tail, uint32_t num)
+	void ReleaseArguments(Allocation const & alloc, uint32_t num)
 	{
-		if (tail + num != usedArguments_) {
+		if (alloc.Block != currentBlock_ || alloc.Offset + num != usedArguments_) {
 			throw std::runtime_error("Attempted to release arguments out of order");
 		}
 
+		auto ptr = blocks_[currentBlock_].Items.get() + alloc.Offset;
 		for (uint32_t i = 0; i < num; i++) {
-			OsiReleaseArgument(argumentPool_[tail + i]);
+			OsiReleaseArgument(ptr[i]);
 		}
 
-		usedArguments_ -= num;
+		currentBlock_ = alloc.PrevBlock;
+		usedArguments_ = alloc.PrevUsed;
 	}
 
 private:
-	std::vector<T> argumentPool_;
-	uint32_t usedArguments_;
+	struct Block
+	{
+		std::unique_ptr<T[]> Items;
+		uint32_t Size;
+	};
+
+	std::vector<Block> blocks_;
+	uint32_t currentBlock_{ 0 };
+	uint32_t usedArguments_{ 0 };
+
+	void AddBlock(uint32_t size)
+	{
+		blocks_.push_back(Block{ std::make_unique<T[]>(size), size });
+	}
 };
 
 template <class T>
@@ -214,12 +343,12 @@ public:
 	inline OsiArgumentListPin(OsiArgumentPool<T> & pool, uint32_t numArgs)
 		: pool_(pool), numArgs_(numArgs)
 	{
-		args_ = pool.AllocateArguments(numArgs_, tail_);
+		args_ = pool.AllocateArguments(numArgs_, alloc_);
 	}
 
 	inline ~OsiArgumentListPin()
 	{
-		pool_.ReleaseArguments(tail_, numArgs_);
+		pool_.ReleaseArguments(alloc_, numArgs_);
 	}
 
 	inline T * Args() const
@@ -230,7 +359,7 @@ public:
 private:
 	OsiArgumentPool<T> & pool_;
 	uint32_t numArgs_;
-	uint32_t tail_;
+	typename OsiArgumentPool<T>::Allocation alloc_;
 	T * args_;
 };
 
@@ -257,9 +386,14 @@ class OsirisCallbackManager : Noncopyable<OsirisCallbackManager>
 public:
 	using SubscriptionId = uint32_t;
 
-	OsirisCallbackManager(ExtensionState& state);
+	OsirisCallbackManager(ExtensionState& state, OsirisDatabaseIndexManager& databaseIndices);
 	~OsirisCallbackManager();
 
+	inline bool IsHooked() const
+	{
+		return osirisHooked_;
+	}
+
 	SubscriptionId Subscribe(STDString const& name, uint32_t arity, OsirisHookSignature::HookType type, RegistryEntry handler);
 	bool Unsubscribe(SubscriptionId id);
 
@@ -289,6 +423,7 @@ private:
 	};
 
 	ExtensionState& state_;
+	OsirisDatabaseIndexManager& databaseIndices_;
 	SaltedPool<Subscription> subscriptions_;
 	std::unordered_multimap<OsirisHookSignature, SubscriptionId> nameSubscriberRefs_;
 	std::unordered_multimap<uint64_t, SubscriptionId> nodeSubscriberRefs_;
@@ -345,11 +480,24 @@ public:
 		return tupleNodePool_;
 	}
 
+	// Storage for string arguments of Lua -> Osiris calls and queries
+	inline OsiArgumentPool<char> & GetStringPool()
+	{
+		return stringPool_;
+	}
+
+	OsiFunctionStub const * GetFunctionStub(Function const * func);
+
 	inline OsirisCallbackManager& GetOsirisCallbacks()
 	{
 		return osirisCallbacks_;
 	}
 
+	inline OsirisDatabaseIndexManager& GetDatabaseIndices()
+	{
+		return databaseIndices_;
+	}
+
 	void StoryLoaded();
 	void StorySetMerging(bool isMerging);
 
@@ -358,10 +506,14 @@ private:
 	OsiArgumentPool<TypedValue> tvPool_;
 	OsiArgumentPool<ListNode<TypedValue *>> tvNodePool_;
 	OsiArgumentPool<ListNode<TupleLL::Item>> tupleNodePool_;
+	OsiArgumentPool<char> stringPool_;
+	// Call stubs of functions bound in the current story generation
+	std::unordered_map<Function const *, std::unique_ptr<OsiFunctionStub>> functionStubs_;
 	IdentityAdapterMap identityAdapters_;
 	// ID of current story instance.
 	// Used to invalidate function/node pointers in Lua userdata objects
 	uint32_t generationId_{ 0 };
+	OsirisDatabaseIndexManager databaseIndices_;
 	OsirisCallbackManager osirisCallbacks_;
 };
 
@@ -93,11 +93,103 @@ namespace bg3se::esv::lua
 		return 1;
 	}
 
+	int EnableOsirisDatabaseIndex(lua_State* L)
+	{
+		auto name = get<STDString>(L, 1);
+		auto arity = get<uint32_t>(L, 2);
+		auto enabled = lua_isnoneornil(L, 3) ? true : get<bool>(L, 3);
+
+		LuaServerPin lua(ExtensionState::Get());
+		lua->Osiris().GetDatabaseIndices().Enable(name, arity, enabled);
+		return 0;
+	}
+
+	int StartOsirisProfiling(lua_State* L)
+	{
+		auto captureTrace = lua_isnoneornil(L, 1) ? false : get<bool>(L, 1);
+		push(L, gExtender->GetServer().Osiris().StartProfiling(captureTrace));
+		return 1;
+	}
+
+	int StopOsirisProfiling(lua_State* L)
+	{
+		gExtender->GetServer().Osiris().StopProfiling();
+		return 0;
+	}
+
+	void PushOsirisProfileEntries(lua_State* L, OsirisNodeProfiler& profiler, std::vector<NodeProfileEntry> const& entries, bool nodes)
+	{
+		lua_createtable(L, (int)entries.size(), 0);
+		for (uint32_t i = 0; i < entries.size(); i++) {
+			auto const& entry = entries[i];
+			lua_createtable(L, 0, 8);
+			setfield(L, "Id", entry.Id);
+			if (nodes) {
+				setfield(L, "Name", profiler.GetNodeName(entry.Id));
+				setfield(L, "Type", OsirisNodeProfiler::GetNodeTypeName(entry.Type));
+			} else {
+				setfield(L, "Name", profiler.GetGoalName(entry.Id));
+			}
+
+			lua_createtable(L, 0, (int)NodeProfileOp::Max + 1);
+			for (unsigned op = 0; op <= (unsigned)NodeProfileOp::Max; op++) {
+				if (entry.Stats.Calls[op] > 0) {
+					setfield(L, OsirisNodeProfiler::GetOpName((NodeProfileOp)op), entry.Stats.Calls[op]);
+				}
+			}
+			lua_setfield(L, -2, "Calls");
+
+			setfield(L, "TotalCalls", entry.Stats.TotalCalls());
+			setfield(L, "Tuples", entry.Stats.Tuples);
+			setfield(L, "InclusiveTime", profiler.TicksToMicroseconds(entry.Stats.InclusiveTicks));
+			setfield(L, "ExclusiveTime", profiler.TicksToMicroseconds(entry.Stats.ExclusiveTicks));
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+
+	int GetOsirisProfile(lua_State* L)
+	{
+		auto& profiler = gExtender->GetServer().Osiris().GetProfiler();
+
+		lua_createtable(L, 0, 5);
+		setfield(L, "Running", profiler.IsRunning());
+		setfield(L, "Duration", profiler.GetProfiledMicroseconds());
+		setfield(L, "DroppedTraceEvents", profiler.GetDroppedTraceEvents());
+		PushOsirisProfileEntries(L, profiler, profiler.GetNodeStats(), true);
+		lua_setfield(L, -2, "Nodes");
+		PushOsirisProfileEntries(L, profiler, profiler.GetGoalStats(), false);
+		lua_setfield(L, -2, "Goals");
+		return 1;
+	}
+
+	int ExportOsirisProfile(lua_State* L)
+	{
+		auto format = get<char const*>(L, 1);
+		auto& profiler = gExtender->GetServer().Osiris().GetProfiler();
+
+		STDString out;
+		if (strcmp(format, "ChromeTrace") == 0) {
+			profiler.ExportChromeTrace(out);
+		} else if (strcmp(format, "FoldedStacks") == 0) {
+			profiler.ExportFoldedStacks(out);
+		} else {
+			luaL_error(L, "Export format must be 'ChromeTrace' or 'FoldedStacks'");
+		}
+
+		push(L, out);
+		return 1;
+	}
+
 	void RegisterOsirisLibrary(lua_State* L)
 	{
 		static const luaL_Reg extLib[] = {
 			{"RegisterListener", RegisterOsirisListener},
 			{"UnregisterListener", UnregisterOsirisListener},
+			{"EnableDatabaseIndex", EnableOsirisDatabaseIndex},
+			{"StartProfiling", StartOsirisProfiling},
+			{"StopProfiling", StopOsirisProfiling},
+			{"GetProfile", GetOsirisProfile},
+			{"ExportProfile", ExportOsirisProfile},
 			{0,0}
 		};
 
@@ -129,6 +221,7 @@ namespace bg3se::esv::lua
 	{
 		ExtensionLibrary::Register(L);
 		OsiFunctionNameProxy::RegisterMetatable(L);
+		OsiFunction::FactIterator::RegisterMetatable(L);
 		RegisterNameResolverMetatable(L);
 		CreateNameResolver(L);
 	}
@@ -0,0 +1,547 @@
+#include <stdafx.h>
+#include <Lua/Server/LuaOsirisBinding.h>
+#include <Extender/ScriptExtender.h>
+
+BEGIN_NS(esv::lua)
+
+uint64_t HashStringCaseInsensitive(char const* str, std::size_t len)
+{
+	// FNV-1a over the lowercase string; must match the _stricmp() comparison in OsiFunction::MatchTuple
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (std::size_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)tolower((uint8_t)str[i]);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+uint64_t GetStringIndexKey(char const* str, std::size_t len, bool guidSuffixOnly)
+{
+	// Strings that end with a GUID are keyed by the GUID, so GUID strings with and without a name prefix
+	// (or with a differently cased GUID) land in the same bucket
+	auto guid = Guid::ParseGuidString(StringView(str, len));
+	if (guid) {
+		return Hash(*guid);
+	}
+
+	if (guidSuffixOnly && len >= 36) {
+		return HashStringCaseInsensitive(str + len - 36, 36);
+	} else {
+		return HashStringCaseInsensitive(str, len);
+	}
+}
+
+std::optional<uint64_t> GetOsiIndexKey(TypedValue const& v)
+{
+	switch (GetBaseType((ValueType)v.TypeId)) {
+	case ValueType::Integer:
+		return (uint64_t)(int64_t)v.Value.Int32;
+
+	case ValueType::Integer64:
+		return (uint64_t)v.Value.Int64;
+
+	case ValueType::String:
+	case ValueType::GuidString:
+		if (v.Value.String == nullptr) return {};
+		return GetStringIndexKey(v.Value.String, strlen(v.Value.String), GetBaseType((ValueType)v.TypeId) == ValueType::GuidString);
+
+	default:
+		return {};
+	}
+}
+
+std::optional<uint64_t> GetLuaIndexKey(lua_State* L, int index, ValueType type)
+{
+	switch (GetBaseType(type)) {
+	case ValueType::Integer:
+		return (uint64_t)(int64_t)(int32_t)lua_tointeger(L, index);
+
+	case ValueType::Integer64:
+		return (uint64_t)(int64_t)lua_tointeger(L, index);
+
+	case ValueType::String:
+	case ValueType::GuidString:
+	{
+		std::size_t len;
+		auto str = lua_tolstring(L, index, &len);
+		if (str == nullptr) return {};
+		return GetStringIndexKey(str, len, GetBaseType(type) == ValueType::GuidString);
+	}
+
+	default:
+		return {};
+	}
+}
+
+bool OsiValueEquals(TypedValue const& v, TypedValue const& tv)
+{
+	// Index keys are lossy (GUID strings with different prefixes share a key and hashes may collide),
+	// so facts are compared using the actual values
+	switch (GetBaseType((ValueType)v.TypeId)) {
+	case ValueType::Integer:
+		return v.Value.Int32 == tv.Value.Int32;
+
+	case ValueType::Integer64:
+		return v.Value.Int64 == tv.Value.Int64;
+
+	case ValueType::Real:
+		return v.Value.Float == tv.Value.Float;
+
+	case ValueType::String:
+		if (v.Value.String == nullptr || tv.Value.String == nullptr) return v.Value.String == tv.Value.String;
+		return _stricmp(v.Value.String, tv.Value.String) == 0;
+
+	case ValueType::GuidString:
+	{
+		if (v.Value.String == nullptr || tv.Value.String == nullptr) return v.Value.String == tv.Value.String;
+
+		auto len = strlen(v.Value.String);
+		auto otherLen = strlen(tv.Value.String);
+		if (len >= 36 && otherLen >= 36) {
+			return _stricmp(v.Value.String + len - 36, tv.Value.String + otherLen - 36) == 0;
+		} else {
+			return _stricmp(v.Value.String, tv.Value.String) == 0;
+		}
+	}
+
+	default:
+		return false;
+	}
+}
+
+bool FactEquals(FactNode const* fact, TuplePtrLL const& tuple)
+{
+	auto const& values = fact->Item;
+	auto item = tuple.Items.Head->Next;
+	for (uint32_t i = 0; i < values.Size; i++) {
+		if (item == tuple.Items.Head) return false;
+		// Unbound (wildcard) columns of delete tuples don't identify a single fact
+		if ((ValueType)item->Item->TypeId == ValueType::None) return false;
+		if (!OsiValueEquals(values.Values[i], *item->Item)) return false;
+
+		item = item->Next;
+	}
+
+	return item == tuple.Items.Head;
+}
+
+// Checks whether deleting the tuple may delete the fact; unbound (None) columns match every value
+bool FactMatchesDelete(FactNode const* fact, TuplePtrLL const& tuple)
+{
+	auto const& values = fact->Item;
+	auto item = tuple.Items.Head->Next;
+	for (uint32_t i = 0; i < values.Size && item != tuple.Items.Head; i++, item = item->Next) {
+		if ((ValueType)item->Item->TypeId != ValueType::None && !OsiValueEquals(values.Values[i], *item->Item)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+OsirisDatabaseIndex::OsirisDatabaseIndex(Function const* function, Database* db)
+	: db_(db)
+{
+	auto const& params = function->Signature->Params->Params;
+	columns_.resize((uint32_t)params.Size);
+	auto param = params.Head->Next;
+	for (uint32_t i = 0; i < columns_.size(); i++) {
+		columns_[i].Type = GetBaseType((ValueType)param->Item.Type);
+		param = param->Next;
+	}
+
+	numFacts_ = db_->Facts.Size;
+}
+
+bool OsirisDatabaseIndex::IsIndexable(uint32_t column) const
+{
+	if (column >= columns_.size()) return false;
+
+	auto type = columns_[column].Type;
+	return type == ValueType::Integer
+		|| type == ValueType::Integer64
+		|| type == ValueType::String
+		|| type == ValueType::GuidString;
+}
+
+OsirisDatabaseIndex::Bucket const* OsirisDatabaseIndex::Probe(uint32_t column, uint64_t key)
+{
+	static const Bucket EmptyBucket;
+
+	if (!IsIndexable(column)) return nullptr;
+
+	Validate();
+	auto& col = columns_[column];
+	if (!col.Built) {
+		BuildColumn(column);
+	}
+
+	auto facts = col.Facts.try_get(key);
+	return facts ? facts : &EmptyBucket;
+}
+
+void OsirisDatabaseIndex::Validate()
+{
+	if (db_->Facts.Size != numFacts_) {
+		Invalidate();
+	}
+}
+
+void OsirisDatabaseIndex::Invalidate()
+{
+	for (auto& column : columns_) {
+		column.Facts.clear();
+		column.Built = false;
+	}
+
+	numFacts_ = db_->Facts.Size;
+	tail_ = nullptr;
+	version_++;
+}
+
+void OsirisDatabaseIndex::BuildColumn(uint32_t column)
+{
+	auto& col = columns_[column];
+	auto head = db_->Facts.Head;
+	auto current = head->Next;
+	while (current != head) {
+		auto key = GetOsiIndexKey(current->Item.Values[column]);
+		if (key) {
+			col.Facts.get_or_add(*key)->push_back(current);
+		}
+
+		tail_ = current;
+		current = current->Next;
+	}
+
+	col.Built = true;
+}
+
+FactNode* OsirisDatabaseIndex::GetTail()
+{
+	if (tail_ == nullptr) {
+		auto head = db_->Facts.Head;
+		auto current = head->Next;
+		while (current != head) {
+			tail_ = current;
+			current = current->Next;
+		}
+	}
+
+	return tail_;
+}
+
+bool OsirisDatabaseIndex::HasBuiltColumns() const
+{
+	for (auto const& column : columns_) {
+		if (column.Built) return true;
+	}
+
+	return false;
+}
+
+FactNode* OsirisDatabaseIndex::FindFact(TuplePtrLL const& tuple)
+{
+	Validate();
+
+	// Use the first built column to look for the fact
+	uint32_t column = 0;
+	auto item = tuple.Items.Head->Next;
+	while (column < columns_.size() && item != tuple.Items.Head) {
+		if (columns_[column].Built) {
+			auto key = GetOsiIndexKey(*item->Item);
+			if (!key) return nullptr;
+
+			auto facts = columns_[column].Facts.try_get(*key);
+			if (facts) {
+				for (auto fact : *facts) {
+					if (FactEquals(fact, tuple)) {
+						return fact;
+					}
+				}
+			}
+
+			return nullptr;
+		}
+
+		column++;
+		item = item->Next;
+	}
+
+	return nullptr;
+}
+
+void OsirisDatabaseIndex::AddToColumns(FactNode* fact, bool atFront)
+{
+	for (uint32_t i = 0; i < columns_.size(); i++) {
+		auto& column = columns_[i];
+		if (!column.Built) continue;
+
+		auto key = GetOsiIndexKey(fact->Item.Values[i]);
+		if (!key) continue;
+
+		auto facts = column.Facts.get_or_add(*key);
+		facts->push_back(fact);
+		if (atFront) {
+			// Keep bucket contents in the same order as the fact list
+			for (uint32_t j = facts->size() - 1; j > 0; j--) {
+				(*facts)[j] = (*facts)[j - 1];
+			}
+			(*facts)[0] = fact;
+		}
+	}
+}
+
+bool OsirisDatabaseIndex::TryAddFact(TuplePtrLL const& tuple, FactNode* tailBefore)
+{
+	// Osiris either prepends or appends new facts; anything else requires a rebuild
+	auto head = db_->Facts.Head;
+	FactNode* fact{ nullptr };
+	bool atFront{ false };
+	if (head->Next != head && FactEquals(head->Next, tuple)) {
+		fact = head->Next;
+		atFront = (fact->Next != head);
+	} else if (tailBefore != nullptr && tailBefore->Next != head && FactEquals(tailBefore->Next, tuple)) {
+		fact = tailBefore->Next;
+	}
+
+	if (fact == nullptr) {
+		return false;
+	}
+
+	AddToColumns(fact, atFront);
+	if (fact->Next == head) {
+		tail_ = fact;
+	}
+
+	numFacts_++;
+	version_++;
+	return true;
+}
+
+void OsirisDatabaseIndex::RemoveFact(FactNode* fact, TuplePtrLL const& tuple)
+{
+	// The fact node was already freed by Osiris; take the keys from the deleted tuple instead
+	auto item = tuple.Items.Head->Next;
+	for (uint32_t i = 0; i < columns_.size() && item != tuple.Items.Head; i++, item = item->Next) {
+		auto& column = columns_[i];
+		if (!column.Built) continue;
+
+		auto key = GetOsiIndexKey(*item->Item);
+		if (!key) continue;
+
+		auto facts = column.Facts.try_get(*key);
+		if (facts) {
+			for (uint32_t j = 0; j < facts->size(); j++) {
+				if ((*facts)[j] == fact) {
+					facts->remove_at(j);
+					break;
+				}
+			}
+
+			if (facts->empty()) {
+				column.Facts.remove(*key);
+			}
+		}
+	}
+
+	if (tail_ == fact) {
+		tail_ = nullptr;
+	}
+
+	numFacts_--;
+	version_++;
+}
+
+
+OsirisDatabaseIndexManager::~OsirisDatabaseIndexManager()
+{
+	// Iterators may outlive the manager, as the Lua state is closed after the Osiris binding is destroyed
+	DetachCursors();
+}
+
+void OsirisDatabaseIndexManager::Enable(STDString const& name, uint32_t arity, bool enabled)
+{
+	auto key = name + "/" + std::to_string(arity).c_str();
+	if (enabled) {
+		enabledDatabases_.insert(key);
+	} else {
+		enabledDatabases_.erase(key);
+	}
+
+	// Drop cached lookups; indices are recreated on the next query
+	indices_.clear();
+	generation_++;
+}
+
+OsirisDatabaseIndex* OsirisDatabaseIndexManager::GetIndex(Function const* function, Database* db)
+{
+	auto it = indices_.find(db->DatabaseId);
+	if (it != indices_.end()) {
+		return it->second.get();
+	}
+
+	auto const& params = function->Signature->Params->Params;
+	auto key = STDString(function->Signature->Name) + "/" + std::to_string(params.Size).c_str();
+	std::unique_ptr<OsirisDatabaseIndex> index;
+	if (enabledDatabases_.find(key) != enabledDatabases_.end()) {
+		index = std::make_unique<OsirisDatabaseIndex>(function, db);
+	}
+
+	auto indexPtr = index.get();
+	indices_.insert(std::make_pair(db->DatabaseId, std::move(index)));
+	return indexPtr;
+}
+
+void OsirisDatabaseIndexManager::Clear()
+{
+	indices_.clear();
+	generation_++;
+	// Fact nodes of the previous story are gone
+	DetachCursors();
+}
+
+void OsirisDatabaseIndexManager::PinCursor(FactCursor& cursor, Database* db, FactNode* next)
+{
+	cursor.Db = db;
+	cursor.Next = next;
+	if (cursor.Manager == nullptr) {
+		cursor.Manager = this;
+		cursors_.push_back(&cursor);
+	}
+}
+
+void OsirisDatabaseIndexManager::UnpinCursor(FactCursor& cursor)
+{
+	for (uint32_t i = 0; i < cursors_.size(); i++) {
+		if (cursors_[i] == &cursor) {
+			cursors_.remove_at(i);
+			break;
+		}
+	}
+
+	cursor.Db = nullptr;
+	cursor.Next = nullptr;
+	cursor.Manager = nullptr;
+}
+
+void OsirisDatabaseIndexManager::EndCursors(Database* db)
+{
+	for (auto cursor : cursors_) {
+		if (cursor->Db == db) {
+			cursor->Next = db->Facts.Head;
+		}
+	}
+}
+
+void OsirisDatabaseIndexManager::DetachCursors()
+{
+	for (auto cursor : cursors_) {
+		cursor->Db = nullptr;
+		cursor->Next = nullptr;
+		cursor->Manager = nullptr;
+	}
+
+	cursors_.clear();
+}
+
+void OsirisDatabaseIndexManager::AdvanceCursors(Node* node, TuplePtrLL const& tuple)
+{
+	if (node->Database.Id == 0) return;
+
+	auto db = node->Database.Get();
+	if (db == nullptr) return;
+
+	// Deleted fact nodes are freed by Osiris, so cursors must be moved while they are still linked.
+	// Wildcard deletes can remove any number of facts, so skip every fact that the tuple matches.
+	auto head = db->Facts.Head;
+	for (auto cursor : cursors_) {
+		if (cursor->Db != db) continue;
+
+		while (cursor->Next != head && FactMatchesDelete(cursor->Next, tuple)) {
+			cursor->Next = cursor->Next->Next;
+		}
+	}
+}
+
+OsirisDatabaseIndex* OsirisDatabaseIndexManager::FindIndex(Node* node)
+{
+	if (indices_.empty() || node->Database.Id == 0) {
+		return nullptr;
+	}
+
+	auto db = node->Database.Get();
+	if (db == nullptr) {
+		return nullptr;
+	}
+
+	auto it = indices_.find(db->DatabaseId);
+	if (it != indices_.end() && it->second && it->second->GetDatabase() == db) {
+		return it->second.get();
+	} else {
+		return nullptr;
+	}
+}
+
+void OsirisDatabaseIndexManager::InsertPreHook(Node* node, TuplePtrLL* tuple, bool deleted)
+{
+	if (deleted && !cursors_.empty()) {
+		AdvanceCursors(node, *tuple);
+	}
+
+	auto index = FindIndex(node);
+	PendingOperation op{ 0, generation_, 0, 0, nullptr };
+	if (index) {
+		op.DatabaseId = index->GetDatabase()->DatabaseId;
+		if (!index->HasBuiltColumns()) {
+			// Nothing to update; the fact count is enough to keep the index consistent
+		} else if (deleted) {
+			op.Fact = index->FindFact(*tuple);
+		} else {
+			op.Fact = index->GetTail();
+		}
+
+		op.Version = index->GetVersion();
+		op.NumFacts = index->GetDatabase()->Facts.Size;
+	}
+
+	// Pre/post hooks are always paired, but inserts may be nested
+	// (eg. a rule triggered by the insert writes into another database)
+	pending_.push_back(op);
+}
+
+void OsirisDatabaseIndexManager::InsertPostHook(Node* node, TuplePtrLL* tuple, bool deleted)
+{
+	if (pending_.empty()) return;
+
+	auto op = pending_[pending_.size() - 1];
+	pending_.remove_last();
+	// Indices may have been dropped by a Lua listener of the insert
+	if (op.DatabaseId == 0 || op.Generation != generation_) return;
+
+	auto it = indices_.find(op.DatabaseId);
+	if (it == indices_.end() || !it->second) return;
+
+	auto index = it->second.get();
+	auto numFacts = index->GetDatabase()->Facts.Size;
+	if (index->GetVersion() != op.Version) {
+		// The database was modified by a nested insert/delete; we can't tell what happened
+		index->Invalidate();
+	} else if (numFacts == op.NumFacts) {
+		// Duplicate insert or deletion of a missing fact
+	} else if (deleted && numFacts + 1 == op.NumFacts && (op.Fact != nullptr || !index->HasBuiltColumns())) {
+		if (op.Fact) {
+			index->RemoveFact(op.Fact, *tuple);
+		} else {
+			index->Invalidate();
+		}
+	} else if (!deleted && numFacts == op.NumFacts + 1 && index->TryAddFact(*tuple, op.Fact)) {
+		// Fact added incrementally
+	} else {
+		index->Invalidate();
+	}
+}
+
+END_NS()
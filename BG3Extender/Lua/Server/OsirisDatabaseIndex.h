@@ -0,0 +1,122 @@
+#pragma once
+
+#include <GameDefinitions/Osiris.h>
+
+BEGIN_NS(esv::lua)
+
+using FactNode = ListNode<TupleVec>;
+
+// Returns the index key of an Osiris value.
+// GUID strings are keyed by the parsed 128-bit GUID, strings by their case-insensitive hash.
+// Keys may collide, so facts found using an index probe must still be checked against the query.
+std::optional<uint64_t> GetOsiIndexKey(TypedValue const& v);
+std::optional<uint64_t> GetLuaIndexKey(lua_State* L, int index, ValueType type);
+
+class OsirisDatabaseIndexManager;
+
+// Position of an Iterate() loop in a database.
+// Pinned cursors are moved past facts that are deleted during iteration,
+// so the next fact of the loop stays valid without rescanning the fact list.
+struct FactCursor : Noncopyable<FactCursor>
+{
+	Database* Db{ nullptr };
+	FactNode* Next{ nullptr };
+	// Manager the cursor is pinned in; null if the cursor isn't pinned or was invalidated by a story reload
+	OsirisDatabaseIndexManager* Manager{ nullptr };
+};
+
+// Lazily built per-column hash index of the facts of an Osiris database.
+// Columns are only indexed after a query with a bound value in that column was made;
+// insertions and deletions are applied incrementally using the node insert/delete hooks.
+class OsirisDatabaseIndex : Noncopyable<OsirisDatabaseIndex>
+{
+public:
+	using Bucket = Array<FactNode*>;
+
+	OsirisDatabaseIndex(Function const* function, Database* db);
+
+	inline Database* GetDatabase() const
+	{
+		return db_;
+	}
+
+	inline uint64_t GetVersion() const
+	{
+		return version_;
+	}
+
+	// Returns the facts whose column value has the specified key;
+	// returns null if the column cannot be indexed (eg. Real columns)
+	Bucket const* Probe(uint32_t column, uint64_t key);
+	bool IsIndexable(uint32_t column) const;
+	bool HasBuiltColumns() const;
+
+	FactNode* FindFact(TuplePtrLL const& tuple);
+	bool TryAddFact(TuplePtrLL const& tuple, FactNode* tailBefore);
+	void RemoveFact(FactNode* fact, TuplePtrLL const& tuple);
+	FactNode* GetTail();
+	void Invalidate();
+
+private:
+	struct Column
+	{
+		FlatHashMap<uint64_t, Bucket> Facts;
+		ValueType Type{ ValueType::None };
+		bool Built{ false };
+	};
+
+	Database* db_;
+	Array<Column> columns_;
+	// Number of facts in the database when the index was last updated.
+	// Osiris might modify the database in ways that bypass the node hooks (eg. story merging);
+	// if the fact count doesn't match, the index is rebuilt.
+	uint64_t numFacts_{ 0 };
+	FactNode* tail_{ nullptr };
+	uint64_t version_{ 0 };
+
+	void Validate();
+	void BuildColumn(uint32_t column);
+	void AddToColumns(FactNode* fact, bool atFront);
+};
+
+class OsirisDatabaseIndexManager : Noncopyable<OsirisDatabaseIndexManager>
+{
+public:
+	~OsirisDatabaseIndexManager();
+
+	void Enable(STDString const& name, uint32_t arity, bool enabled);
+	// Returns the index of the database if indexing was enabled for it
+	OsirisDatabaseIndex* GetIndex(Function const* function, Database* db);
+	void Clear();
+
+	void PinCursor(FactCursor& cursor, Database* db, FactNode* next);
+	void UnpinCursor(FactCursor& cursor);
+	// Moves the cursors of the database to the end of the fact list (eg. before every fact is deleted)
+	void EndCursors(Database* db);
+
+	void InsertPreHook(Node* node, TuplePtrLL* tuple, bool deleted);
+	void InsertPostHook(Node* node, TuplePtrLL* tuple, bool deleted);
+
+private:
+	struct PendingOperation
+	{
+		uint32_t DatabaseId;
+		uint32_t Generation;
+		uint64_t Version;
+		uint64_t NumFacts;
+		FactNode* Fact;
+	};
+
+	std::unordered_set<STDString> enabledDatabases_;
+	// Indices by DatabaseId; databases without indexing are mapped to null
+	std::unordered_map<uint32_t, std::unique_ptr<OsirisDatabaseIndex>> indices_;
+	Array<PendingOperation> pending_;
+	uint32_t generation_{ 0 };
+	Array<FactCursor*> cursors_;
+
+	OsirisDatabaseIndex* FindIndex(Node* node);
+	void AdvanceCursors(Node* node, TuplePtrLL const& tuple);
+	void DetachCursors();
+};
+
+END_NS()
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+
+BEGIN_NS(lua)
+
+struct EventBase;
+
+struct EventDispatchStats
+{
+	uint64_t Dispatches{ 0 };
+	uint64_t HandlerCalls{ 0 };
+	uint64_t HandlerErrors{ 0 };
+	// Time spent dispatching the event, in microseconds
+	uint64_t TotalTime{ 0 };
+	uint64_t MaxTime{ 0 };
+};
+
+// Subscriber list of an Ext.Events.* event.
+// Handlers are called in descending priority order; handlers with equal priority are called in subscription order.
+class SubscribableEvent
+{
+public:
+	using SubscriptionIndex = uint32_t;
+
+	SubscribableEvent(FixedString const& name);
+
+	inline FixedString const& GetName() const
+	{
+		return name_;
+	}
+
+	inline bool HasSubscribers() const
+	{
+		return !subscribers_.empty() || !pendingSubscriptions_.empty();
+	}
+
+	inline uint32_t NumSubscribers() const
+	{
+		return (uint32_t)(subscribers_.size() + pendingSubscriptions_.size());
+	}
+
+	inline EventDispatchStats const& GetStats() const
+	{
+		return stats_;
+	}
+
+	inline void ResetStats()
+	{
+		stats_ = EventDispatchStats{};
+	}
+
+	SubscriptionIndex Subscribe(RegistryEntry&& handler, double priority, bool once);
+	bool Unsubscribe(SubscriptionIndex index);
+	// Calls the handlers with the event object on the top of the stack.
+	// If evt is null, the event is a Lua table and the Stopped flag is read from the table.
+	void Throw(lua_State* L, EventBase* evt);
+	void Clear();
+
+private:
+	struct Subscriber
+	{
+		RegistryEntry Handler;
+		SubscriptionIndex Index;
+		double Priority;
+		bool Once;
+		bool Removed{ false };
+	};
+
+	FixedString name_;
+	std::vector<Subscriber> subscribers_;
+	// Subscriptions and unsubscriptions made while the event is being dispatched are applied
+	// after the outermost dispatch finishes, so the subscriber list is never modified while iterating
+	std::vector<Subscriber> pendingSubscriptions_;
+	Array<SubscriptionIndex> pendingDeletions_;
+	SubscriptionIndex nextIndex_{ 1 };
+	uint32_t enterCount_{ 0 };
+	bool needsCompaction_{ false };
+	EventDispatchStats stats_;
+
+	void Insert(Subscriber&& sub);
+	bool DoUnsubscribe(SubscriptionIndex index);
+	void ProcessPendingChanges();
+	bool IsStopped(lua_State* L, EventBase* evt, int eventIdx) const;
+	void CallHandlers(lua_State* L, EventBase* evt, int eventIdx);
+};
+
+class EngineEventManager
+{
+public:
+	SubscribableEvent* RegisterEvent(FixedString const& name);
+	SubscribableEvent* GetEvent(FixedString const& name);
+	// Lookup using the address of the event name; used by C++ callers that throw events using string literals
+	// to avoid constructing a FixedString on each dispatch
+	SubscribableEvent* GetEvent(char const* name);
+	void Clear();
+
+	inline std::vector<std::unique_ptr<SubscribableEvent>> const& GetEvents() const
+	{
+		return events_;
+	}
+
+private:
+	std::vector<std::unique_ptr<SubscribableEvent>> events_;
+	FlatHashMap<FixedString, SubscribableEvent*> eventsByName_;
+	FlatHashMap<uint64_t, SubscribableEvent*> eventsByLiteral_;
+};
+
+END_NS()
@@ -0,0 +1,213 @@
+#include <Lua/Shared/EngineEvents.h>
+#include <chrono>
+
+BEGIN_NS(lua)
+
+SubscribableEvent::SubscribableEvent(FixedString const& name)
+	: name_(name)
+{}
+
+SubscribableEvent::SubscriptionIndex SubscribableEvent::Subscribe(RegistryEntry&& handler, double priority, bool once)
+{
+	auto index = nextIndex_++;
+	Subscriber sub{ std::move(handler), index, priority, once };
+	if (enterCount_ > 0) {
+		pendingSubscriptions_.push_back(std::move(sub));
+	} else {
+		Insert(std::move(sub));
+	}
+
+	return index;
+}
+
+void SubscribableEvent::Insert(Subscriber&& sub)
+{
+	// Insert before the first subscriber with a lower priority
+	auto it = std::find_if(subscribers_.begin(), subscribers_.end(), [&sub](Subscriber const& cur) {
+		return sub.Priority > cur.Priority;
+	});
+	subscribers_.insert(it, std::move(sub));
+}
+
+bool SubscribableEvent::Unsubscribe(SubscriptionIndex index)
+{
+	if (enterCount_ == 0) {
+		return DoUnsubscribe(index);
+	}
+
+	for (auto const& sub : subscribers_) {
+		if (sub.Index == index && !sub.Removed) {
+			pendingDeletions_.push_back(index);
+			return true;
+		}
+	}
+
+	for (auto const& sub : pendingSubscriptions_) {
+		if (sub.Index == index) {
+			pendingDeletions_.push_back(index);
+			return true;
+		}
+	}
+
+	WARN("Attempted to remove subscriber ID %d for event '%s', but no such subscriber exists (maybe it was removed already?)", index, name_.GetString());
+	return false;
+}
+
+bool SubscribableEvent::DoUnsubscribe(SubscriptionIndex index)
+{
+	for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it) {
+		if (it->Index == index && !it->Removed) {
+			subscribers_.erase(it);
+			return true;
+		}
+	}
+
+	for (auto it = pendingSubscriptions_.begin(); it != pendingSubscriptions_.end(); ++it) {
+		if (it->Index == index) {
+			pendingSubscriptions_.erase(it);
+			return true;
+		}
+	}
+
+	WARN("Attempted to remove subscriber ID %d for event '%s', but no such subscriber exists (maybe it was removed already?)", index, name_.GetString());
+	return false;
+}
+
+void SubscribableEvent::ProcessPendingChanges()
+{
+	if (needsCompaction_) {
+		subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(), [](Subscriber const& sub) {
+			return sub.Removed;
+		}), subscribers_.end());
+		needsCompaction_ = false;
+	}
+
+	for (auto index : pendingDeletions_) {
+		DoUnsubscribe(index);
+	}
+	pendingDeletions_.clear();
+
+	for (auto& sub : pendingSubscriptions_) {
+		Insert(std::move(sub));
+	}
+	pendingSubscriptions_.clear();
+}
+
+bool SubscribableEvent::IsStopped(lua_State* L, EventBase* evt, int eventIdx) const
+{
+	if (evt != nullptr) {
+		return evt->Stopped;
+	}
+
+	if (lua_type(L, eventIdx) != LUA_TTABLE) {
+		return false;
+	}
+
+	lua_getfield(L, eventIdx, "Stopped");
+	auto stopped = lua_toboolean(L, -1) != 0;
+	lua_pop(L, 1);
+	return stopped;
+}
+
+void SubscribableEvent::CallHandlers(lua_State* L, EventBase* evt, int eventIdx)
+{
+	// The list can't be reallocated during dispatch (see pendingSubscriptions_),
+	// so it's safe to hold on to subscriber references while calling handlers
+	for (std::size_t i = 0; i < subscribers_.size(); i++) {
+		if (IsStopped(L, evt, eventIdx)) {
+			break;
+		}
+
+		auto& sub = subscribers_[i];
+		if (sub.Removed) continue;
+
+		if (sub.Once) {
+			sub.Removed = true;
+			needsCompaction_ = true;
+		}
+
+		stats_.HandlerCalls++;
+		sub.Handler.Push();
+		lua_pushvalue(L, eventIdx);
+		if (CallWithTraceback(L, 1, 0) != 0) {
+			stats_.HandlerErrors++;
+			LuaError("Error while dispatching event " << name_.GetString() << ": " << lua_tostring(L, -1));
+			lua_pop(L, 1);
+		}
+	}
+}
+
+void SubscribableEvent::Throw(lua_State* L, EventBase* evt)
+{
+	using namespace std::chrono;
+	auto startTime = high_resolution_clock::now();
+	auto eventIdx = lua_absindex(L, -1);
+
+	enterCount_++;
+	stats_.Dispatches++;
+
+	try {
+		CallHandlers(L, evt, eventIdx);
+	} catch (...) {
+		enterCount_--;
+		throw;
+	}
+
+	enterCount_--;
+	if (enterCount_ == 0) {
+		ProcessPendingChanges();
+	}
+
+	auto time = (uint64_t)duration_cast<microseconds>(high_resolution_clock::now() - startTime).count();
+	stats_.TotalTime += time;
+	stats_.MaxTime = std::max(stats_.MaxTime, time);
+}
+
+void SubscribableEvent::Clear()
+{
+	subscribers_.clear();
+	pendingSubscriptions_.clear();
+	pendingDeletions_.clear();
+}
+
+
+SubscribableEvent* EngineEventManager::RegisterEvent(FixedString const& name)
+{
+	auto event = GetEvent(name);
+	if (event == nullptr) {
+		events_.push_back(std::make_unique<SubscribableEvent>(name));
+		event = events_.back().get();
+		eventsByName_.set(name, event);
+		// Literal lookups may have cached a miss for this event
+		eventsByLiteral_.clear();
+	}
+
+	return event;
+}
+
+SubscribableEvent* EngineEventManager::GetEvent(FixedString const& name)
+{
+	auto event = eventsByName_.try_get(name);
+	return event ? *event : nullptr;
+}
+
+SubscribableEvent* EngineEventManager::GetEvent(char const* name)
+{
+	auto event = eventsByLiteral_.try_get((uint64_t)name);
+	if (event) {
+		return *event;
+	}
+
+	auto found = GetEvent(FixedString(name));
+	eventsByLiteral_.set((uint64_t)name, found);
+	return found;
+}
+
+void EngineEventManager::Clear()
+{
+	for (auto& event : events_) {
+		event->Clear();
+	}
+}
+
+END_NS()
@@ -0,0 +1,202 @@
+#include <stdafx.h>
+#include <Lua/Shared/LuaBytecodeCache.h>
+#include <Extender/Shared/Console.h>
+#include <Extender/Version.h>
+#include <lauxlib.h>
+#include <filesystem>
+
+BEGIN_NS(lua)
+
+void LuaBytecodeCache::SetCacheDirectory(std::wstring const& path)
+{
+	std::lock_guard _(mutex_);
+	cacheDirectory_ = path;
+	buildFingerprint_ = ComputeBuildFingerprint();
+	entries_.clear();
+
+	if (!cacheDirectory_.empty()) {
+		RemoveStaleEntries();
+	}
+}
+
+int LuaBytecodeCache::Load(lua_State* L, StringView script, char const* name)
+{
+	if (cacheDirectory_.empty()) {
+		return luaL_loadbufferx(L, script.data(), script.size(), name, "t");
+	}
+
+	auto key = MakeKey(script, name);
+	{
+		std::lock_guard _(mutex_);
+		auto entry = GetEntry(key, script, name);
+		if (entry != nullptr) {
+			auto status = luaL_loadbufferx(L, entry->Bytecode.data(), entry->Bytecode.size(), name, "b");
+			if (status == LUA_OK) {
+				return status;
+			}
+
+			// Shouldn't happen, as cache entries are validated when loading them; recompile the script instead
+			WARN("LuaBytecodeCache::Load(): Failed to load cached bytecode of '%s': %s", name, lua_tostring(L, -1));
+			lua_pop(L, 1);
+			entries_.erase(name);
+		}
+	}
+
+	// Client and server states can compile scripts in parallel, the lock is only needed for updating the cache
+	auto status = luaL_loadbufferx(L, script.data(), script.size(), name, "t");
+	if (status != LUA_OK) {
+		return status;
+	}
+
+	Entry compiled{ key, (uint32_t)script.size() };
+	auto writer = [](lua_State* L, void const* p, size_t sz, void* ud) {
+		reinterpret_cast<std::string*>(ud)->append(reinterpret_cast<char const*>(p), sz);
+		return 0;
+	};
+
+	if (lua_dump(L, writer, &compiled.Bytecode, 0) == 0) {
+		std::lock_guard _(mutex_);
+		SaveEntry(compiled, name);
+		entries_[name] = std::move(compiled);
+	}
+
+	return status;
+}
+
+LuaBytecodeCache::CacheKey LuaBytecodeCache::MakeKey(StringView script, StringView name)
+{
+	CacheKey key;
+	uint64_t nameHash[2];
+	MurmurHash3_x64_128(name.data(), (int)name.size(), 0, nameHash);
+	MurmurHash3_x64_128(script.data(), (int)script.size(), (uint32_t)nameHash[0], key.Hash);
+	key.Hash[1] ^= nameHash[1];
+	return key;
+}
+
+uint64_t LuaBytecodeCache::ComputeBuildFingerprint()
+{
+	// Custom VM changes don't necessarily change the Lua version, so the bytecode is tied to the extender build too
+	uint64_t releaseHash[2], buildHash[2];
+	MurmurHash3_x64_128(LUA_RELEASE, (int)strlen(LUA_RELEASE), 0, releaseHash);
+	MurmurHash3_x64_128(BuildDate, (int)strlen(BuildDate), 0, buildHash);
+
+	auto fingerprint = HashMix(Version, LUA_VERSION_NUM);
+	fingerprint = HashMix(fingerprint, releaseHash[0]);
+	fingerprint = HashMix(fingerprint, CurrentVersion);
+	fingerprint = HashMix(fingerprint, buildHash[0]);
+	return HashMix(fingerprint, (sizeof(lua_Integer) << 16) | (sizeof(lua_Number) << 8) | sizeof(void*));
+}
+
+std::wstring LuaBytecodeCache::GetEntryPath(CacheKey const& key) const
+{
+	wchar_t fileName[64];
+	swprintf_s(fileName, L"\\%016llx%016llx.luac", key.Hash[0], key.Hash[1]);
+	return cacheDirectory_ + fileName;
+}
+
+LuaBytecodeCache::Entry const* LuaBytecodeCache::GetEntry(CacheKey const& key, StringView script, StringView name)
+{
+	auto it = entries_.find(std::string(name));
+	if (it != entries_.end() && it->second.Key == key && it->second.SourceSize == script.size()) {
+		return &it->second;
+	}
+
+	Entry entry;
+	if (!LoadEntry(key, script, name, entry)) {
+		return nullptr;
+	}
+
+	// Keep entries that are in use from expiring
+	std::error_code ec;
+	std::filesystem::last_write_time(GetEntryPath(key), std::filesystem::file_time_type::clock::now(), ec);
+
+	auto& stored = entries_[std::string(name)];
+	stored = std::move(entry);
+	return &stored;
+}
+
+bool LuaBytecodeCache::LoadEntry(CacheKey const& key, StringView script, StringView name, Entry& entry) const
+{
+	std::string body;
+	if (!LoadFile(GetEntryPath(key), body) || body.size() < sizeof(FileHeader)) {
+		return false;
+	}
+
+	FileHeader header;
+	memcpy(&header, body.data(), sizeof(header));
+	if (header.Magic != Magic
+		|| header.Version != Version
+		|| header.BuildFingerprint != buildFingerprint_
+		|| !(header.Key == key)
+		|| header.SourceSize != script.size()
+		|| header.NameSize != name.size()
+		|| (uint64_t)sizeof(header) + header.NameSize + header.BytecodeSize != body.size()
+		|| StringView(body.data() + sizeof(header), header.NameSize) != name) {
+		return false;
+	}
+
+	auto bytecode = StringView(body.data() + sizeof(header) + header.NameSize, header.BytecodeSize);
+	uint64_t bytecodeHash[2];
+	MurmurHash3_x64_128(bytecode.data(), (int)bytecode.size(), 0, bytecodeHash);
+	// Don't feed truncated or otherwise damaged files to the undumper
+	if (bytecodeHash[0] != header.BytecodeHash) {
+		WARN("LuaBytecodeCache::LoadEntry(): Cached bytecode of '%s' is corrupted", name.data());
+		return false;
+	}
+
+	entry.Key = key;
+	entry.SourceSize = header.SourceSize;
+	entry.Bytecode = bytecode;
+	return true;
+}
+
+void LuaBytecodeCache::SaveEntry(Entry const& entry, StringView name) const
+{
+	uint64_t bytecodeHash[2];
+	MurmurHash3_x64_128(entry.Bytecode.data(), (int)entry.Bytecode.size(), 0, bytecodeHash);
+
+	FileHeader header{
+		.Magic = Magic,
+		.Version = Version,
+		.BuildFingerprint = buildFingerprint_,
+		.Key = entry.Key,
+		.SourceSize = entry.SourceSize,
+		.NameSize = (uint32_t)name.size(),
+		.BytecodeSize = (uint32_t)entry.Bytecode.size(),
+		.Reserved = 0,
+		.BytecodeHash = bytecodeHash[0]
+	};
+
+	std::string body;
+	body.reserve(sizeof(header) + name.size() + entry.Bytecode.size());
+	body.append(reinterpret_cast<char const*>(&header), sizeof(header));
+	body.append(name);
+	body.append(entry.Bytecode);
+
+	// Write to a temporary file first, so other game instances never see partially written entries
+	auto path = GetEntryPath(entry.Key);
+	auto tempPath = path + L".tmp";
+	if (!SaveFile(tempPath, body) || !MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFileW(tempPath.c_str());
+		WARN("LuaBytecodeCache::SaveEntry(): Failed to write bytecode cache entry for '%s'", name.data());
+	}
+}
+
+void LuaBytecodeCache::RemoveStaleEntries() const
+{
+	std::error_code ec;
+	auto now = std::filesystem::file_time_type::clock::now();
+	auto maxAge = std::chrono::hours(24 * MaxEntryAgeDays);
+
+	for (auto const& file : std::filesystem::directory_iterator(cacheDirectory_, ec)) {
+		auto ext = file.path().extension();
+		if (ext != L".luac" && ext != L".tmp") continue;
+
+		auto lastWrite = file.last_write_time(ec);
+		if (!ec && now - lastWrite > maxAge) {
+			std::filesystem::remove(file.path(), ec);
+		}
+	}
+}
+
+END_NS()
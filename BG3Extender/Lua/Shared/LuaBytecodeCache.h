@@ -0,0 +1,77 @@
+#pragma once
+
+#include <GameDefinitions/Base/Base.h>
+#include <lua.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+BEGIN_NS(lua)
+
+// Caches the compiled bytecode of Lua scripts, so scripts that didn't change since they were last loaded
+// (e.g. when the Lua state is reset) are loaded from bytecode instead of being parsed again.
+// Entries are keyed by the hash of the source text and chunk name, and are saved to the cache directory
+// so later game sessions can reuse them. Bytecode is dumped with debug info, so the chunk name
+// and line info of the original script are preserved for error messages and the debugger.
+class LuaBytecodeCache
+{
+public:
+	static constexpr uint32_t Magic = 0x43424C53; // "SLBC"
+	static constexpr uint32_t Version = 1;
+	// Cache files that weren't updated for this long are removed on startup
+	static constexpr uint32_t MaxEntryAgeDays = 30;
+
+	// Enables the cache; bytecode is saved to and loaded from the specified directory
+	void SetCacheDirectory(std::wstring const& path);
+
+	// Loads the script as a Lua function to the top of the stack; same semantics as luaL_loadbufferx()
+	int Load(lua_State* L, StringView script, char const* name);
+
+private:
+	struct CacheKey
+	{
+		uint64_t Hash[2];
+
+		inline bool operator ==(CacheKey const& o) const
+		{
+			return Hash[0] == o.Hash[0] && Hash[1] == o.Hash[1];
+		}
+	};
+
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		// Lua and extender build the bytecode was generated by
+		uint64_t BuildFingerprint;
+		CacheKey Key;
+		uint32_t SourceSize;
+		uint32_t NameSize;
+		uint32_t BytecodeSize;
+		uint32_t Reserved;
+		uint64_t BytecodeHash;
+	};
+
+	struct Entry
+	{
+		CacheKey Key;
+		uint32_t SourceSize;
+		std::string Bytecode;
+	};
+
+	std::mutex mutex_;
+	std::wstring cacheDirectory_;
+	uint64_t buildFingerprint_{ 0 };
+	// Last loaded version of each chunk; older versions of a chunk are only kept on disk
+	std::unordered_map<std::string, Entry> entries_;
+
+	static CacheKey MakeKey(StringView script, StringView name);
+	static uint64_t ComputeBuildFingerprint();
+	std::wstring GetEntryPath(CacheKey const& key) const;
+	Entry const* GetEntry(CacheKey const& key, StringView script, StringView name);
+	bool LoadEntry(CacheKey const& key, StringView script, StringView name, Entry& entry) const;
+	void SaveEntry(Entry const& entry, StringView name) const;
+	void RemoveStaleEntries() const;
+};
+
+END_NS()
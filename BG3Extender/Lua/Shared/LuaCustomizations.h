@@ -14,9 +14,27 @@ enum class MetatableTag : uint8_t
 	Max = Entity
 };
 
+struct LuaStringCacheStats
+{
+	// Short strings created by scripts that were not interned in the GST when created
+	// (strings pushed from an existing FixedString are not counted)
+	uint64_t DeferredStrings{ 0 };
+	// Strings that were given an already existing FixedString when pushed to Lua
+	uint64_t AttachedStrings{ 0 };
+	// GST entries created from Lua strings on first use as a FixedString
+	uint64_t LazyInterns{ 0 };
+	// Existing GST entries found for Lua strings on first use as a FixedString
+	uint64_t LazyLookups{ 0 };
+	// GST lookups for strings that cannot be cached (long strings, non-string values)
+	uint64_t UncachedInterns{ 0 };
+	// FixedString reads served from the Lua string cache
+	uint64_t CacheHits{ 0 };
+};
+
 struct LuaInternalState;
 LuaInternalState* lua_new_internal_state();
 void lua_release_internal_state(LuaInternalState* state);
+LuaStringCacheStats& lua_get_string_cache_stats(lua_State* L);
 
 // Object API for storing pointer-like data in a Lua TValue.
 void lua_push_cppobject(lua_State* L, MetatableTag metatableTag, int propertyMapIndex, void* object, LifetimeHandle const& lifetime);
@@ -40,6 +58,7 @@ void* LuaCppCanonicalize(lua_State* L, void* val);
 class GenericPropertyMap& LuaGetPropertyMap(int propertyMapIndex);
 
 void LuaCacheString(lua_State* L, TString* s);
+void LuaAttachFixedString(lua_State* L, TString* s, FixedString const& str);
 void LuaReleaseString(lua_State* L, TString* s);
 
 END_NS()
@@ -3,6 +3,7 @@ BEGIN_NS(lua)
 struct LuaInternalState
 {
 	TValue canonicalizationCache;
+	LuaStringCacheStats stringCache;
 };
 
 struct CppObjectUdata
@@ -17,6 +18,10 @@ struct CachedFixedString
 	bool IsCached;
 };
 
+// Only short strings get a FixedString attached; longer ones are usually one-off text
+// (chat messages, JSON blobs) that would needlessly pin a GST entry
+static constexpr std::size_t MaxCachedFixedStringLength = 0x40;
+
 // Lua C++ objects store an additional lifetime in the Lua value; however, for optimization purposes
 // only the lower 48 bits of the pointer are stored.
 // (Even though pointers in x64 are 64-bit, it only actually uses 48 bits; upper 16 bits are reserved.)
@@ -400,6 +405,11 @@ LuaInternalState* lua_new_internal_state()
 	return st;
 }
 
+LuaStringCacheStats& lua_get_string_cache_stats(lua_State* L)
+{
+	return State::FromLua(L)->GetInternalState()->stringCache;
+}
+
 void lua_release_internal_state(LuaInternalState* state)
 {
 	GameDelete(state);
@@ -428,6 +438,31 @@ void* LuaCppCanonicalize(lua_State* L, void* val)
 	return &state->canonicalizationCache;
 }
 
+// Interns a Lua string in the GST the first time it is used as a FixedString
+// and attaches the resulting FixedString to the Lua string object.
+FixedString LuaInternString(lua_State* L, TString* s)
+{
+	auto& stats = lua_get_string_cache_stats(L);
+	auto& fs = *reinterpret_cast<CachedFixedString*>(&s->cache);
+	FixedString str(StringView(getstr(s), tsslen(s)));
+	if (str && tsslen(s) <= MaxCachedFixedStringLength) {
+		// If our reference is the only one, the lookup had to create the GST entry
+		// (or revive an unreferenced entry that would have been collected)
+		if (str.GetMetadata()->RefCount == 1) {
+			stats.LazyInterns++;
+		} else {
+			stats.LazyLookups++;
+		}
+
+		new (&fs.Str) FixedString(str);
+		fs.IsCached = true;
+	} else {
+		stats.UncachedInterns++;
+	}
+
+	return str;
+}
+
 FixedString do_get(lua_State* L, int index, Overload<FixedString>)
 {
 	StkId o = index2addr(L, index);
@@ -435,15 +470,17 @@ FixedString do_get(lua_State* L, int index, Overload<FixedString>)
 		auto s = tsvalue(o);
 		auto& fs = *reinterpret_cast<CachedFixedString *>(&s->cache);
 		if (fs.IsCached) {
+			lua_get_string_cache_stats(L).CacheHits++;
 			return fs.Str;
 		} else {
-			return FixedString(StringView(getstr(s), tsslen(s)));
+			return LuaInternString(L, s);
 		}
 	}
 
 	size_t len;
 	auto str = luaL_tolstring(L, index, &len);
 	auto fs = FixedString(StringView(str, len));
+	lua_get_string_cache_stats(L).UncachedInterns++;
 	lua_pop(L, 1);
 	return fs;
 }
@@ -453,8 +490,12 @@ void push(lua_State* L, FixedString const& v)
 	lua_lock(L);
 	TString* ts;
 	if (v) {
+		// Strings created here get their FixedString right away, so they're not counted as deferred
+		auto& stats = lua_get_string_cache_stats(L);
+		auto deferredStrings = stats.DeferredStrings;
 		ts = luaS_new(L, v.GetString());
-		LuaCacheString(L, ts);
+		stats.DeferredStrings = deferredStrings;
+		LuaAttachFixedString(L, ts, v);
 	} else {
 		ts = luaS_new(L, "");
 	}
@@ -468,12 +509,23 @@ void push(lua_State* L, FixedString const& v)
 void LuaCacheString(lua_State* L, TString* s)
 {
 	static_assert(sizeof(LUA_STRING_EXTRATYPE) == sizeof(CachedFixedString));
+	// Lookup-only: strings created by scripts are not interned in the GST here, as that would
+	// insert every temporary string into the global string table (and take its lock) for the
+	// rest of the session. A FixedString is attached either when the string is pushed from an
+	// existing FixedString, or lazily when it is first used as a FixedString (see do_get()).
+	auto fs = reinterpret_cast<CachedFixedString*>(&s->cache);
+	if (!fs->IsCached && tsslen(s) <= MaxCachedFixedStringLength) {
+		lua_get_string_cache_stats(L).DeferredStrings++;
+	}
+}
+
+void LuaAttachFixedString(lua_State* L, TString* s, FixedString const& str)
+{
 	auto fs = reinterpret_cast<CachedFixedString*>(&s->cache);
-	if (!fs->IsCached && tsslen(s) <= 0x40) {
-		// FIXME: Don't create GFS entries if the string doesn't already exist in GFS!
-		// was previously: FixedString::DontCreate{}
-		new (&fs->Str) FixedString(StringView(getstr(s), tsslen(s)));
+	if (!fs->IsCached && tsslen(s) <= MaxCachedFixedStringLength) {
+		new (&fs->Str) FixedString(str);
 		fs->IsCached = true;
+		lua_get_string_cache_stats(L).AttachedStrings++;
 	}
 }
 
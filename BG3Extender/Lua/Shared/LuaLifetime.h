@@ -1,70 +1,82 @@
 #pragma once
 
+#include <bit>
+
 #define DEBUG_LIFETIMES
 #undef TRACE_LIFETIMES
 
 BEGIN_NS(lua)
 
+// Three-level bitmap pool allocator.
+// Each bit in L3 marks a free object, each bit in L2/L1 marks an L3/L2 word that has at least one free bit.
+// Objects are committed lazily in blocks of 4096 (one L2 word), so construction doesn't touch the whole pool.
+// Not thread-safe; each Lua state owns its own pool.
 template <class T, std::size_t Size>
-class HierarchicalPoolAllocator
+class HierarchicalPoolAllocator : Noncopyable<HierarchicalPoolAllocator<T, Size>>
 {
 public:
 	static constexpr unsigned PageBits = 64;
 	static constexpr unsigned PageShift = 6;
+	static constexpr unsigned BlockShift = 2 * PageShift;
+	static constexpr std::size_t BlockSize = 1 << BlockShift;
+	static constexpr std::size_t NumBlocks = Size / BlockSize;
 
 	HierarchicalPoolAllocator()
 	{
-		pool_ = new T[Size];
-		memset(pool_, 0, sizeof(T) * Size);
 		memset(l1_, 0xff, sizeof(l1_));
 		memset(l2_, 0xff, sizeof(l2_));
 		memset(l3_, 0xff, sizeof(l3_));
 
 		auto l1buckets = Size / (PageBits * PageBits);
 		if (l1buckets % PageBits) {
-			l1_[std::size(l1_) - 1] = 0xffffffffffffffffull << (PageBits - (l1buckets & (PageBits - 1)));
-		}
-
-		for (std::size_t i = 0; i < Size; i++) {
-			pool_[i].SetIndex(i);
+			l1_[std::size(l1_) - 1] = 0xffffffffffffffffull >> (PageBits - (l1buckets & (PageBits - 1)));
 		}
 	}
 
 	~HierarchicalPoolAllocator()
 	{
-		delete [] pool_;
+		for (auto& block : blocks_) {
+			delete [] block;
+		}
 	}
 
 	T* Allocate()
 	{
-		for (auto i = 0; i < std::size(l1_); i++) {
-			unsigned long l1;
-			if (_BitScanForward64(&l1, l1_[i])) {
-				auto l2off = (i << PageShift) + l1;
-				unsigned long l2;
-				_BitScanForward64(&l2, l2_[l2off]);
-				assert(l2 < PageBits);
-				auto l3off = (i << (2 * PageShift)) + (l1 << PageShift) + l2;
-				unsigned long l3;
-				_BitScanForward64(&l3, l3_[l3off]);
-				assert(l3 < PageBits);
-				l3_[l3off] &= ~(1ull << l3);
-				if (l3_[l3off] == 0) {
-					l2_[l2off] &= ~(1ull << l2);
-					if (l2_[l2off] == 0) {
-						l1_[i] &= ~(1ull << l1);
-					}
+		// All L1 words below the cursor are known to be full
+		for (auto i = firstFreeL1_; i < std::size(l1_); i++) {
+			if (l1_[i] == 0) {
+				firstFreeL1_ = i + 1;
+				continue;
+			}
+
+			auto l1 = (std::size_t)std::countr_zero(l1_[i]);
+			auto l2off = (i << PageShift) + l1;
+			auto l2 = (std::size_t)std::countr_zero(l2_[l2off]);
+			assert(l2 < PageBits);
+			auto l3off = (i << (2 * PageShift)) + (l1 << PageShift) + l2;
+			auto l3 = (std::size_t)std::countr_zero(l3_[l3off]);
+			assert(l3 < PageBits);
+			l3_[l3off] &= ~(1ull << l3);
+			if (l3_[l3off] == 0) {
+				l2_[l2off] &= ~(1ull << l2);
+				if (l2_[l2off] == 0) {
+					l1_[i] &= ~(1ull << l1);
 				}
+			}
 
-				auto off = (i << (3 * PageShift)) + (l1 << (2 * PageShift)) + (l2 << PageShift) + l3;
+			auto off = (i << (3 * PageShift)) + (l1 << (2 * PageShift)) + (l2 << PageShift) + l3;
 #if defined(TRACE_LIFETIMES)
-				INFO("ACQ: off=%d, root=%d, l1=%d, l2=%d, l3=%d, l2off=%d, l3off=%d", off, i, l1, l2, l3, l2off, l3off);
+			INFO("ACQ: off=%d, root=%d, l1=%d, l2=%d, l3=%d, l2off=%d, l3off=%d", off, i, l1, l2, l3, l2off, l3off);
 #endif
 
-				auto lifetime = pool_ + off;
-				lifetime->Acquire();
-				return lifetime;
+			auto block = blocks_[l2off];
+			if (block == nullptr) {
+				block = CommitBlock(l2off);
 			}
+
+			auto lifetime = block + (off & (BlockSize - 1));
+			lifetime->Acquire();
+			return lifetime;
 		}
 
 		OsiErrorS("Couldn't allocate Lua lifetime - pool is full! This is very, very bad.");
@@ -73,9 +85,10 @@ public:
 
 	void Free(T* ptr)
 	{
-		assert(ptr >= pool_ && ptr < pool_ + Size);
-		auto index = ptr - pool_;
-		auto off = index;
+		auto index = (std::size_t)ptr->Index();
+		assert(index < Size && Get(index) == ptr);
+		ptr->Release();
+
 		auto l3 = index & (PageBits - 1);
 		index >>= PageShift;
 		auto l3off = index;
@@ -93,16 +106,41 @@ public:
 			l2_[l2off] |= 1ull << l2;
 			if (l2set) {
 				l1_[l1off] |= 1ull << l1;
+				if (l1off < firstFreeL1_) {
+					firstFreeL1_ = l1off;
+				}
 			}
 		}
-
-		ptr->Release();
 	}
 
+	// Returns nullptr if the block containing the object was not committed yet
 	T* Get(std::size_t index) const
 	{
 		assert(index < Size);
-		return pool_ + index;
+		auto block = blocks_[index >> BlockShift];
+		return block ? (block + (index & (BlockSize - 1))) : nullptr;
+	}
+
+	uint32_t NumCommittedBlocks() const
+	{
+		uint32_t committed{ 0 };
+		for (auto block : blocks_) {
+			if (block != nullptr) committed++;
+		}
+
+		return committed;
+	}
+
+private:
+	T* CommitBlock(std::size_t blockIndex)
+	{
+		auto block = new T[BlockSize];
+		for (std::size_t i = 0; i < BlockSize; i++) {
+			block[i].SetIndex((blockIndex << BlockShift) + i);
+		}
+
+		blocks_[blockIndex] = block;
+		return block;
 	}
 
 public:
@@ -111,7 +149,10 @@ public:
 	uint64_t l1_[Size / 262144 + ((Size % 262144) ? 1 : 0)];
 	uint64_t l2_[Size / 4096];
 	uint64_t l3_[Size / 64];
-	T* pool_;
+
+private:
+	T* blocks_[NumBlocks]{};
+	std::size_t firstFreeL1_{ 0 };
 };
 
 class LifetimePool;
@@ -14,6 +14,11 @@ class CppPropertyMapManager
 public:
 	int RegisterPropertyMap(GenericPropertyMap* mt);
 	GenericPropertyMap* GetPropertyMap(int index);
+	inline Array<GenericPropertyMap*> const& GetPropertyMaps() const
+	{
+		return propertyMaps_;
+	}
+
 	void UpdateInheritance();
 	void RegisterComponents(ecs::EntitySystemHelpersBase& helpers);
 	
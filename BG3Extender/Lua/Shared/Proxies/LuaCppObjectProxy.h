@@ -4,6 +4,59 @@
 
 BEGIN_NS(lua)
 
+// Direct-mapped cache of (property map, property name) -> accessor resolutions.
+// Each entry acts as a monomorphic inline cache for one type/field pair, so repeated
+// accesses to the same field of the same type skip the property map lookup entirely.
+class PropertyAccessCache
+{
+public:
+	static constexpr unsigned CacheBits = 10;
+	static constexpr unsigned NumEntries = 1 << CacheBits;
+
+	inline RawPropertyAccessors const* Find(uint16_t propertyMapTag, FixedString const& prop)
+	{
+		auto const& entry = entries_[Slot(propertyMapTag, prop)];
+		if (entry.Key == prop.Index && entry.PropertyMapTag == propertyMapTag && entry.Accessor != nullptr) {
+			Hits++;
+			return entry.Accessor;
+		} else {
+			Misses++;
+			return nullptr;
+		}
+	}
+
+	inline void Insert(uint16_t propertyMapTag, FixedString const& prop, RawPropertyAccessors const* accessor)
+	{
+		auto& entry = entries_[Slot(propertyMapTag, prop)];
+		if (entry.Accessor != nullptr) {
+			Evictions++;
+		}
+
+		entry.Key = prop.Index;
+		entry.PropertyMapTag = propertyMapTag;
+		entry.Accessor = accessor;
+	}
+
+	uint64_t Hits{ 0 };
+	uint64_t Misses{ 0 };
+	uint64_t Evictions{ 0 };
+
+private:
+	struct Entry
+	{
+		uint32_t Key{ FixedString::NullIndex };
+		uint16_t PropertyMapTag{ 0 };
+		RawPropertyAccessors const* Accessor{ nullptr };
+	};
+
+	static inline uint32_t Slot(uint16_t propertyMapTag, FixedString const& prop)
+	{
+		return ((prop.Index * 0x9e3779b1u) ^ (propertyMapTag * 0x85ebca77u)) >> (32 - CacheBits);
+	}
+
+	std::array<Entry, NumEntries> entries_;
+};
+
 class LightObjectProxyByRefMetatable : public LightCppObjectMetatable<LightObjectProxyByRefMetatable>,
 	public Indexable, public NewIndexable, public Iterable, public Stringifiable, public EqualityComparable
 {
@@ -42,6 +95,9 @@ public:
 	static bool IsEqual(lua_State* L, CppObjectMetadata& self, CppObjectMetadata& other);
 	static int Next(lua_State* L, CppObjectMetadata& self);
 	static char const* GetTypeName(lua_State* L, CppObjectMetadata& self);
+
+private:
+	static RawPropertyAccessors const* FindCachedProperty(lua_State* L, CppObjectMetadata& self, FixedString const& prop);
 };
 
 
@@ -126,11 +126,35 @@ void* LightObjectProxyByRefMetatable::GetGeneric(lua_State* L, int index, int pr
 	}
 }
 
+RawPropertyAccessors const* LightObjectProxyByRefMetatable::FindCachedProperty(lua_State* L, CppObjectMetadata& self, FixedString const& prop)
+{
+	auto& cache = State::FromLua(L)->GetPropertyAccessCache();
+	auto accessor = cache.Find(self.PropertyMapTag, prop);
+	if (accessor == nullptr) {
+		accessor = LuaGetPropertyMap(self.PropertyMapTag).FindProperty(prop);
+		if (accessor != nullptr) {
+			cache.Insert(self.PropertyMapTag, prop, accessor);
+		}
+	}
+
+	return accessor;
+}
+
 int LightObjectProxyByRefMetatable::Index(lua_State* L, CppObjectMetadata& self)
 {
-	auto pm = gExtender->GetPropertyMapManager().GetPropertyMap(self.PropertyMapTag);
 	auto prop = get<FixedString>(L, 2);
-	auto result = pm->GetRawProperty(L, self.Lifetime, self.Ptr, prop);
+	auto accessor = FindCachedProperty(L, self, prop);
+
+	PropertyOperationResult result;
+	if (accessor != nullptr) {
+		result = accessor->Get(L, self.Lifetime, self.Ptr, *accessor);
+	} else {
+		auto& pm = LuaGetPropertyMap(self.PropertyMapTag);
+		result = pm.FallbackGetter
+			? pm.FallbackGetter(L, self.Lifetime, self.Ptr, prop)
+			: PropertyOperationResult::NoSuchProperty;
+	}
+
 	switch (result) {
 	case PropertyOperationResult::Success:
 		break;
@@ -152,9 +176,19 @@ int LightObjectProxyByRefMetatable::Index(lua_State* L, CppObjectMetadata& self)
 
 int LightObjectProxyByRefMetatable::NewIndex(lua_State* L, CppObjectMetadata& self)
 {
-	auto pm = gExtender->GetPropertyMapManager().GetPropertyMap(self.PropertyMapTag);
 	auto prop = get<FixedString>(L, 2);
-	auto result = pm->SetRawProperty(L, self.Ptr, prop, 3);
+	auto accessor = FindCachedProperty(L, self, prop);
+
+	PropertyOperationResult result;
+	if (accessor != nullptr) {
+		result = accessor->Set(L, self.Ptr, 3, *accessor);
+	} else {
+		auto& pm = LuaGetPropertyMap(self.PropertyMapTag);
+		result = pm.FallbackSetter
+			? pm.FallbackSetter(L, self.Ptr, prop, 3)
+			: PropertyOperationResult::NoSuchProperty;
+	}
+
 	switch (result) {
 	case PropertyOperationResult::Success:
 		break;
@@ -50,6 +50,7 @@ void InheritProperties(GenericPropertyMap const& base, GenericPropertyMap& child
 
 	child.IsInitializing = false;
 	child.InheritanceUpdated = true;
+	child.BuildLookupTable();
 }
 
 template <class T>
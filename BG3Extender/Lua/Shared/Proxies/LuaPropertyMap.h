@@ -30,6 +30,74 @@ struct RawPropertyAccessors
 	bool Iterable{ true };
 };
 
+// Minimal perfect hash table over the property names of a property map.
+// Built once the property set of a type is final; a lookup is a bucket pilot read
+// and a single slot probe, without walking hash chains.
+class PropertyLookupTable : Noncopyable<PropertyLookupTable>
+{
+public:
+	~PropertyLookupTable();
+
+	bool Build(MultiHashMap<FixedString, RawPropertyAccessors> const& properties);
+	void Clear();
+
+	inline bool IsBuilt() const
+	{
+		return built_;
+	}
+
+	// Returns the index of the property in GenericPropertyMap::Properties, or -1 if not found
+	inline int Find(FixedString const& key) const
+	{
+		if (numSlots_ == 0) return -1;
+
+		auto hash = HashKey(key.Index);
+		auto pilot = pilots_[Reduce((uint32_t)(hash >> 32), numBuckets_)];
+		auto const& slot = slots_[Reduce(SlotHash(hash, pilot), numSlots_)];
+		return slot.Key == key.Index ? (int)slot.PropertyIndex : -1;
+	}
+
+private:
+	struct Slot
+	{
+		uint32_t Key;
+		uint32_t PropertyIndex;
+	};
+
+	static constexpr uint32_t MaxPilot = 0xffff;
+
+	static inline uint64_t HashKey(uint32_t index)
+	{
+		uint64_t h = index;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	static inline uint32_t SlotHash(uint64_t hash, uint16_t pilot)
+	{
+		auto h = (hash ^ (pilot * 0x9e3779b97f4a7c15ull)) * 0xff51afd7ed558ccdull;
+		return (uint32_t)(h >> 32);
+	}
+
+	// Maps a 32-bit hash to [0, n) without a division
+	static inline uint32_t Reduce(uint32_t hash, uint32_t n)
+	{
+		return (uint32_t)(((uint64_t)hash * n) >> 32);
+	}
+
+	// Slots and pilots are stored in a single allocation; slots first
+	void* buf_{ nullptr };
+	Slot* slots_{ nullptr };
+	uint16_t* pilots_{ nullptr };
+	uint32_t numSlots_{ 0 };
+	uint32_t numBuckets_{ 0 };
+	bool built_{ false };
+};
+
 class GenericPropertyMap : Noncopyable<GenericPropertyMap>
 {
 public:
@@ -61,6 +129,8 @@ public:
 	void Init(int registryIndex);
 	void Finish();
 	bool HasProperty(FixedString const& prop) const;
+	RawPropertyAccessors const* FindProperty(FixedString const& prop) const;
+	void BuildLookupTable();
 	PropertyOperationResult GetRawProperty(lua_State* L, LifetimeHandle const& lifetime, void* object, FixedString const& prop) const;
 	PropertyOperationResult GetRawProperty(lua_State* L, LifetimeHandle const& lifetime, void* object, RawPropertyAccessors const& prop) const;
 	PropertyOperationResult SetRawProperty(lua_State* L, void* object, FixedString const& prop, int index) const;
@@ -79,6 +149,7 @@ public:
 	FixedString Name;
 	MultiHashMap<FixedString, RawPropertyAccessors> Properties;
 	MultiHashMap<FixedString, uint32_t> IterableProperties;
+	PropertyLookupTable PropertyLookup;
 	Array<RawPropertyValidators> Validators;
 	Array<FixedString> Parents;
 	Array<int> ParentRegistryIndices;
@@ -2,6 +2,106 @@
 
 BEGIN_NS(lua)
 
+PropertyLookupTable::~PropertyLookupTable()
+{
+	Clear();
+}
+
+void PropertyLookupTable::Clear()
+{
+	if (buf_ != nullptr) {
+		GameFree(buf_);
+		buf_ = nullptr;
+	}
+
+	slots_ = nullptr;
+	pilots_ = nullptr;
+	numSlots_ = 0;
+	numBuckets_ = 0;
+	built_ = false;
+}
+
+// Builds the table using hash-and-displace: keys are distributed into buckets, and for each bucket
+// (largest first) we search for a pilot value that maps all keys of the bucket to free slots.
+bool PropertyLookupTable::Build(MultiHashMap<FixedString, RawPropertyAccessors> const& properties)
+{
+	Clear();
+
+	auto const& keys = properties.keys();
+	auto numKeys = keys.size();
+	if (numKeys == 0) {
+		built_ = true;
+		return true;
+	}
+
+	auto numBuckets = std::max(1u, numKeys / 2);
+	std::vector<std::vector<uint32_t>> buckets(numBuckets);
+	std::vector<uint64_t> hashes(numKeys);
+	for (uint32_t i = 0; i < numKeys; i++) {
+		hashes[i] = HashKey(keys[i].Index);
+		buckets[Reduce((uint32_t)(hashes[i] >> 32), numBuckets)].push_back(i);
+	}
+
+	std::vector<uint32_t> bucketOrder(numBuckets);
+	for (uint32_t i = 0; i < numBuckets; i++) {
+		bucketOrder[i] = i;
+	}
+
+	std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&buckets](uint32_t a, uint32_t b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	std::vector<uint16_t> pilots(numBuckets, 0);
+	std::vector<uint32_t> slotKeys(numKeys, 0xffffffffu);
+	std::vector<uint32_t> positions;
+	for (auto bucketIdx : bucketOrder) {
+		auto const& bucket = buckets[bucketIdx];
+		if (bucket.empty()) break;
+
+		bool placed{ false };
+		for (uint32_t pilot = 0; pilot <= MaxPilot && !placed; pilot++) {
+			positions.clear();
+			placed = true;
+			for (auto keyIdx : bucket) {
+				auto pos = Reduce(SlotHash(hashes[keyIdx], (uint16_t)pilot), numKeys);
+				if (slotKeys[pos] != 0xffffffffu 
+					|| std::find(positions.begin(), positions.end(), pos) != positions.end()) {
+					placed = false;
+					break;
+				}
+
+				positions.push_back(pos);
+			}
+
+			if (placed) {
+				pilots[bucketIdx] = (uint16_t)pilot;
+				for (uint32_t i = 0; i < bucket.size(); i++) {
+					slotKeys[positions[i]] = bucket[i];
+				}
+			}
+		}
+
+		if (!placed) {
+			return false;
+		}
+	}
+
+	buf_ = GameAllocRaw(sizeof(Slot) * numKeys + sizeof(uint16_t) * numBuckets);
+	slots_ = reinterpret_cast<Slot*>(buf_);
+	pilots_ = reinterpret_cast<uint16_t*>(slots_ + numKeys);
+	numSlots_ = numKeys;
+	numBuckets_ = numBuckets;
+
+	for (uint32_t i = 0; i < numKeys; i++) {
+		slots_[i].Key = keys[slotKeys[i]].Index;
+		slots_[i].PropertyIndex = slotKeys[i];
+	}
+
+	std::copy(pilots.begin(), pilots.end(), pilots_);
+	built_ = true;
+	return true;
+}
+
 void GenericPropertyMap::Init(int registryIndex)
 {
 	assert(!IsInitializing && !Initialized);
@@ -14,16 +114,34 @@ void GenericPropertyMap::Finish()
 	assert(!Initialized && IsInitializing);
 	IsInitializing = false;
 	Initialized = true;
+	BuildLookupTable();
+}
+
+void GenericPropertyMap::BuildLookupTable()
+{
+	if (!PropertyLookup.Build(Properties)) {
+		WARN("Failed to build property lookup table for %s; using hash map lookups", Name.GetString());
+	}
 }
 
 bool GenericPropertyMap::HasProperty(FixedString const& prop) const
 {
-	return Properties.find(prop) != Properties.end();
+	return FindProperty(prop) != nullptr;
+}
+
+RawPropertyAccessors const* GenericPropertyMap::FindProperty(FixedString const& prop) const
+{
+	if (PropertyLookup.IsBuilt()) {
+		auto index = PropertyLookup.Find(prop);
+		return index >= 0 ? &Properties.values()[index] : nullptr;
+	} else {
+		return Properties.try_get(prop);
+	}
 }
 
 PropertyOperationResult GenericPropertyMap::GetRawProperty(lua_State* L, LifetimeHandle const& lifetime, void* object, FixedString const& prop) const
 {
-	auto it = Properties.try_get(prop);
+	auto it = FindProperty(prop);
 	if (it == nullptr) {
 		if (FallbackGetter) {
 			return FallbackGetter(L, lifetime, object, prop);
@@ -42,7 +160,7 @@ PropertyOperationResult GenericPropertyMap::GetRawProperty(lua_State* L, Lifetim
 
 PropertyOperationResult GenericPropertyMap::SetRawProperty(lua_State* L, void* object, FixedString const& prop, int index) const
 {
-	auto it = Properties.try_get(prop);
+	auto it = FindProperty(prop);
 	if (it == nullptr) {
 		if (FallbackSetter) {
 			return FallbackSetter(L, object, prop, index);
@@ -62,6 +180,7 @@ void GenericPropertyMap::AddRawProperty(char const* prop, typename RawPropertyAc
 	FixedString key{ prop };
 	FixedString newNameKey{ newName ? newName : "" };
 	assert(Properties.find(key) == Properties.end());
+	PropertyLookup.Clear();
 	Properties.set(key, RawPropertyAccessors{ key, offset, flag, getter, setter, serialize, notification, this, newNameKey, iterable });
 
 	if (iterable) {
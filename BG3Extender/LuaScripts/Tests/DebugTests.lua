@@ -0,0 +1,7 @@
+function TestPatternScanner()
+    AssertEquals(Ext.Debug.TestPatternScanner(), true)
+end
+
+RegisterTests("Debug", {
+    "TestPatternScanner"
+})
@@ -51,9 +51,39 @@ function TestECSFunctions()
     -- GetSalt and GetIndex have no deterministic outputs
 end
 
+function TestECSIterateEntitiesWithComponent()
+    local entities = Ext.Entity.GetAllEntitiesWithComponent("Health")
+    local count = 0
+    for _, entity in Ext.Entity.IterateEntitiesWithComponent("Health") do
+        count = count + 1
+        AssertEquals(entity, entities[count])
+    end
+    AssertEquals(count, #entities)
+end
+
+function TestECSComponentColumns()
+    local columns = Ext.Entity.GetComponentColumns("Health", {"Hp", "MaxHp"})
+    AssertType(columns.Count, "number")
+    AssertEquals(#columns.Entity, columns.Count)
+    AssertEquals(#columns.Hp, columns.Count)
+
+    local ent = Ext.Entity.Get(GUID_LAEZEL)
+    for i=1,columns.Count do
+        if columns.Entity[i] == ent then
+            AssertEquals(columns.Hp[i], ent.Health.Hp)
+            AssertEquals(columns.MaxHp[i], ent.Health.MaxHp)
+        end
+    end
+
+    local transforms = Ext.Entity.GetComponentColumns("Transform", {"Transform.Translate"})
+    AssertType(transforms["Transform.Translate"][1], "table")
+end
+
 RegisterTests("ECS", {
     "TestECSFetch",
     "TestECSComponents",
     "TestECSFunctions",
+    "TestECSIterateEntitiesWithComponent",
+    "TestECSComponentColumns",
     "TestECSReplication"
 })
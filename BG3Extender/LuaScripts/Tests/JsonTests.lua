@@ -0,0 +1,137 @@
+local function Compact(value, options)
+    options = options or {}
+    options.Beautify = false
+    return Ext.Json.Stringify(value, options)
+end
+
+function TestJsonEscapes()
+    local str = "quote\" backslash\\ slash/ \b\f\n\r\t ctl\1\31 \u{e9}\u{20ac}\u{1f600}"
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(str)), str)
+
+    AssertEquals(Ext.Json.Stringify("\"\\\b\f\n\r\t"), "\"\\\"\\\\\\b\\f\\n\\r\\t\"")
+    AssertEquals(Ext.Json.Stringify("\1\31"), "\"\\u0001\\u001f\"")
+    -- Non-ASCII characters are written as UTF-8 without escaping
+    AssertEquals(Ext.Json.Stringify("\u{e9}"), "\"\u{e9}\"")
+
+    AssertEquals(Ext.Json.Parse("\"\\/\\u0041\\u00e9\\u20AC\""), "/A\u{e9}\u{20ac}")
+    -- Surrogate pair
+    AssertEquals(Ext.Json.Parse("\"\\ud83d\\ude00\""), "\u{1f600}")
+    Assert(not pcall(Ext.Json.Parse, "\"\\ud83d\""))
+    Assert(not pcall(Ext.Json.Parse, "\"\\ud83d\\u0041\""))
+    Assert(not pcall(Ext.Json.Parse, "\"\\x\""))
+end
+
+function TestJsonEmbeddedNul()
+    local str = "a\0b\0"
+    AssertEquals(Ext.Json.Stringify(str), "\"a\\u0000b\\u0000\"")
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(str)), str)
+    AssertEquals(Ext.Json.Parse("\"a\0b\""), "a\0b")
+
+    local tab = Ext.Json.Parse(Compact({ ["k\0ey"] = "v\0al" }))
+    AssertEquals(tab["k\0ey"], "v\0al")
+end
+
+function TestJsonExtensions()
+    local json = "\xEF\xBB\xBF// Line comment\n{ /* Block\ncomment */ \"a\" : [1, 2,], \"b\" : { \"c\" : true, }, }"
+    local tab = Ext.Json.Parse(json)
+    AssertEquals(#tab.a, 2)
+    AssertEquals(tab.a[2], 2)
+    AssertEquals(tab.b.c, true)
+
+    Assert(not pcall(Ext.Json.Parse, "{ /* Unterminated comment }"))
+    Assert(not pcall(Ext.Json.Parse, "[1 2]"))
+end
+
+function TestJsonIntegers()
+    local values = { 0, -1, 2147483647, -2147483648, 4294967296, math.maxinteger, math.mininteger }
+    for _,value in ipairs(values) do
+        local parsed = Ext.Json.Parse(Ext.Json.Stringify(value))
+        AssertEquals(math.type(parsed), "integer")
+        AssertEquals(parsed, value)
+    end
+
+    AssertEquals(Ext.Json.Stringify(math.maxinteger), "9223372036854775807")
+    AssertEquals(Ext.Json.Stringify(math.mininteger), "-9223372036854775808")
+
+    -- Values that only fit into an uint64 wrap around, same as the previous jsoncpp reader
+    AssertEquals(Ext.Json.Parse("9223372036854775808"), math.mininteger)
+    AssertEquals(Ext.Json.Parse("18446744073709551615"), -1)
+    -- Values out of the uint64 range are parsed as floats
+    AssertEquals(math.type(Ext.Json.Parse("18446744073709551616")), "float")
+    AssertEquals(math.type(Ext.Json.Parse("-9223372036854775809")), "float")
+end
+
+function TestJsonFloats()
+    AssertEquals(Ext.Json.Stringify(0.5), "0.5")
+    -- Integral floats stay floats after a round trip
+    AssertEquals(Ext.Json.Stringify(1.0), "1.0")
+    AssertEquals(math.type(Ext.Json.Parse("1.0")), "float")
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(0.1)), 0.1)
+    AssertEquals(Ext.Json.Parse(Ext.Json.Stringify(-1.5e300)), -1.5e300)
+
+    AssertEquals(Ext.Json.Stringify(math.huge), "1e+9999")
+    AssertEquals(Ext.Json.Stringify(-math.huge), "-1e+9999")
+    AssertEquals(Ext.Json.Parse("1e+9999"), math.huge)
+    AssertEquals(Ext.Json.Parse("-1e+9999"), -math.huge)
+    AssertEquals(Ext.Json.Stringify(0/0), "null")
+    AssertEquals(Ext.Json.Parse(Compact({ 1, 0/0 }))[2], nil)
+end
+
+function TestJsonMarkers()
+    local nested = { a = { b = { c = 1 } } }
+    AssertEquals(Compact(nested, { LimitDepth = 1 }), "{\"a\":{\"b\":\"*DEPTH LIMIT EXCEEDED*\"}}")
+    AssertEquals(Compact(nested, { LimitDepth = 2 }), "{\"a\":{\"b\":{\"c\":1}}}")
+
+    local recursive = { name = "root" }
+    recursive.self = recursive
+    AssertEquals(Compact(recursive, { AvoidRecursion = true }), "{\"name\":\"root\",\"self\":\"*RECURSION*\"}")
+    Assert(not pcall(Ext.Json.Stringify, recursive))
+end
+
+function TestJsonBeautifiedLayout()
+    local tab = { a = 1, b = { 1, 2 }, c = {}, d = { x = true }, e = "str" }
+    local expected = "{\n"
+        .. "\t\"a\" : 1,\n"
+        .. "\t\"b\" : \n"
+        .. "\t[\n"
+        .. "\t\t1,\n"
+        .. "\t\t2\n"
+        .. "\t],\n"
+        .. "\t\"c\" : [],\n"
+        .. "\t\"d\" : \n"
+        .. "\t{\n"
+        .. "\t\t\"x\" : true\n"
+        .. "\t},\n"
+        .. "\t\"e\" : \"str\"\n"
+        .. "}"
+    AssertEquals(Ext.Json.Stringify(tab), expected)
+    AssertEquals(Compact(tab), "{\"a\":1,\"b\":[1,2],\"c\":[],\"d\":{\"x\":true},\"e\":\"str\"}")
+    AssertEquals(Ext.Json.Stringify({ { 1 }, {} }), "[\n\t[\n\t\t1\n\t],\n\t[]\n]")
+end
+
+function TestJsonSparseTables()
+    local sparse = { [1] = "a", [3] = "c" }
+    AssertEquals(Compact(sparse), "{\"1\":\"a\",\"3\":\"c\"}")
+
+    -- Object member names are always parsed as strings
+    local parsed = Ext.Json.Parse(Compact(sparse))
+    AssertEquals(parsed["1"], "a")
+    AssertEquals(parsed["3"], "c")
+    AssertEquals(parsed[1], nil)
+
+    AssertEquals(Compact({ [0] = "zero", [1] = "one" }), "{\"0\":\"zero\",\"1\":\"one\"}")
+    AssertEquals(Compact({ [1.5] = "x" }), "{\"1.5\":\"x\"}")
+    -- Number and string keys with the same name are merged; the string key wins
+    AssertEquals(Compact({ [1] = "number", ["1"] = "string", [2] = "two" }), "{\"1\":\"string\",\"2\":\"two\"}")
+end
+
+RegisterTests("Json", {
+    "TestJsonEscapes",
+    "TestJsonEmbeddedNul",
+    "TestJsonExtensions",
+    "TestJsonIntegers",
+    "TestJsonFloats",
+    "TestJsonMarkers",
+    "TestJsonBeautifiedLayout",
+    "TestJsonSparseTables"
+})
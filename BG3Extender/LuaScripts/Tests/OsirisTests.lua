@@ -55,8 +55,99 @@ function TestOsirisUserQuerySubscribers()
     AssertEquals(regOk2, true)
 end
 
+function TestOsirisBulkInsert()
+    local host = Osi.GetHostCharacter()
+    Osi.DB_Players:DeleteMany({{host}})
+    AssertEquals(Osi.DB_Players:Count(host), 0)
+
+    AssertEquals(Osi.DB_Players:InsertMany({{host}}), 1)
+    AssertEquals(Osi.DB_Players:Count(host), 1)
+
+    AssertEquals(Osi.DB_Players:InsertMany({}, 1), 0)
+    AssertEquals(pcall(Osi.DB_Players.InsertMany, Osi.DB_Players, {{host}, {1}}), false)
+
+    AssertEquals(pcall(Osi.DB_Players.DeleteMany, Osi.DB_Players, {{host, host}}), false)
+    AssertEquals(Osi.DB_Players:DeleteMany({{host}}), 1)
+    AssertEquals(Osi.DB_Players:Count(host), 0)
+    Osi.DB_Players(host)
+end
+
+local IterateTestNpc = "S_IterateTest_00000000-0000-0000-0000-000000000001"
+
+local function MakeIterateTestRows()
+    local rows = {}
+    for i = 1, 4 do
+        rows[i] = {string.format("IterateTest%d_00000000-0000-0000-0000-%012d", i, i), IterateTestNpc, "IterateTest_00000000-0000-0000-0000-000000000002"}
+    end
+    return rows
+end
+
+function TestOsirisIterateDelete()
+    local db = Osi.DB_GiveTemplateFromNpcToPlayerDialogEvent
+    local rows = MakeIterateTestRows()
+    db:Delete(nil, IterateTestNpc, nil)
+
+    -- Wildcard delete of every test row, including the rows after the current one
+    db:InsertMany(rows)
+    local visited = 0
+    for template in db:Iterate(nil, IterateTestNpc, nil) do
+        visited = visited + 1
+        db:Delete(nil, IterateTestNpc, nil)
+    end
+    AssertEquals(visited, 1)
+    AssertEquals(db:Count(nil, IterateTestNpc, nil), 0)
+
+    -- Deleting specific rows, including the current one
+    db:InsertMany(rows)
+    visited = 0
+    for template in db:Iterate(nil, IterateTestNpc, nil) do
+        visited = visited + 1
+        local others = {}
+        for _,row in ipairs(rows) do
+            if row[1] ~= template then
+                table.insert(others, row)
+            end
+        end
+        db:DeleteMany(others)
+        db:Delete(template, IterateTestNpc, nil)
+    end
+    AssertEquals(visited, 1)
+    AssertEquals(db:Count(nil, IterateTestNpc, nil), 0)
+
+    -- Inserts during iteration don't invalidate the iterator
+    db:InsertMany({rows[1]})
+    visited = 0
+    for template in db:Iterate(nil, IterateTestNpc, nil) do
+        visited = visited + 1
+        if visited == 1 then
+            db:InsertMany({rows[2], rows[3]})
+        end
+    end
+    Assert(visited >= 1)
+    db:Delete(nil, IterateTestNpc, nil)
+end
+
+function TestOsirisReplaceDuringIterate()
+    local db = Osi.DB_GiveTemplateFromNpcToPlayerDialogEvent
+    db:Delete(nil, IterateTestNpc, nil)
+    local original = db:Get(nil, nil, nil)
+    db:InsertMany(MakeIterateTestRows())
+
+    local visited = 0
+    for template in db:Iterate(nil, IterateTestNpc, nil) do
+        visited = visited + 1
+        AssertEquals(db:Replace(original, 3), #original)
+    end
+    AssertEquals(visited, 1)
+    AssertEquals(db:Count(nil, IterateTestNpc, nil), 0)
+    AssertEquals(db:Count(nil, nil, nil), #original)
+end
+
 RegisterTests("Stats", {
     "TestOsirisCallSubscribers",
     "TestOsirisDBSubscribers",
+    "TestOsirisBulkInsert",
+    "TestOsirisIterateDelete",
+    "TestOsirisReplaceDuringIterate",
     "TestOsirisUserQuerySubscribers"
 })
@@ -1,5 +1,7 @@
 Ext.Utils.Include(nil, "builtin://Tests/TestHelpers.lua")
 Ext.Utils.Include(nil, "builtin://Tests/ModTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/DebugTests.lua")
+Ext.Utils.Include(nil, "builtin://Tests/JsonTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StaticDataTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/StatTests.lua")
 Ext.Utils.Include(nil, "builtin://Tests/ECSTests.lua")
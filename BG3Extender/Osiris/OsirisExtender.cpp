@@ -17,7 +17,8 @@ void OsirisDebugThreadRunner(OsirisDebugInterface & intf)
 OsirisExtender::OsirisExtender(ExtenderConfig & config)
 	: config_(config), 
 	injector_(wrappers_, customFunctions_),
-	functionLibrary_(*this)
+	functionLibrary_(*this),
+	profiler_(wrappers_.Globals)
 {
 	functionLibrary_.Startup();
 }
@@ -82,6 +83,9 @@ void OsirisExtender::HookNodeVMTs()
 	if (wrappers_.ResolveNodeVMTs()) {
 		nodeVmtWrappers_.reset();
 		nodeVmtWrappers_ = std::make_unique<NodeVMTWrappers>(wrappers_.VMTs);
+		if (profiler_.IsRunning()) {
+			nodeVmtWrappers_->ProfilerAttachment = &profiler_;
+		}
 	}
 }
 
@@ -399,4 +403,30 @@ void OsirisExtender::BindCallbackManager(esv::lua::OsirisCallbackManager* mgr)
 	}
 }
 
+bool OsirisExtender::StartProfiling(bool captureTrace)
+{
+	if (!nodeVmtWrappers_) {
+		HookNodeVMTs();
+		if (!nodeVmtWrappers_) {
+			ERR("OsirisExtender::StartProfiling(): Unable to hook Osiris nodes");
+			return false;
+		}
+
+		nodeVmtWrappers_->OsirisCallbacksAttachment = osirisCallbacksAttachment_;
+	}
+
+	profiler_.Start(captureTrace);
+	nodeVmtWrappers_->ProfilerAttachment = &profiler_;
+	return true;
+}
+
+void OsirisExtender::StopProfiling()
+{
+	if (nodeVmtWrappers_) {
+		nodeVmtWrappers_->ProfilerAttachment = nullptr;
+	}
+
+	profiler_.Stop();
+}
+
 }
@@ -33,6 +33,8 @@ public:
 	void InitRuntimeLogging();
 
 	void BindCallbackManager(esv::lua::OsirisCallbackManager* mgr);
+	bool StartProfiling(bool captureTrace);
+	void StopProfiling();
 
 	void LogError(std::string_view msg);
 	void LogWarning(std::string_view msg);
@@ -73,6 +75,11 @@ public:
 		return nodeVmtWrappers_.get();
 	}
 
+	inline OsirisNodeProfiler & GetProfiler()
+	{
+		return profiler_;
+	}
+
 	inline OsirisWrappers & GetWrappers()
 	{
 		return wrappers_;
@@ -96,6 +103,7 @@ private:
 	CustomFunctionManager customFunctions_;
 	CustomFunctionInjector injector_;
 	esv::CustomFunctionLibrary functionLibrary_;
+	OsirisNodeProfiler profiler_;
 	esv::lua::OsirisCallbackManager* osirisCallbacksAttachment_{ nullptr };
 	bool initialized_{ false };
 
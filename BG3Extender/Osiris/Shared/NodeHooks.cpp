@@ -166,21 +166,35 @@ namespace bg3se
 
 	NodeVMTWrapper & NodeVMTWrappers::GetWrapper(Node * node)
 	{
-		NodeType type = GetType(node);
+		return GetWrapper(GetType(node));
+	}
+
+	NodeVMTWrapper & NodeVMTWrappers::GetWrapper(NodeType type)
+	{
 		assert(type >= NodeType::Database && type <= NodeType::Max);
 		return *wrappers_[(unsigned)type].get();
 	}
 
 	bool NodeVMTWrappers::WrappedIsValid(Node * node, VirtTupleLL * tuple, uint32_t adapter)
 	{
-		auto & wrapper = GetWrapper(node);
+		auto type = GetType(node);
+		auto & wrapper = GetWrapper(type);
+		auto profiler = ProfilerAttachment;
 
 		if (DebuggerAttachment) {
 			DebuggerAttachment->IsValidPreHook(node, tuple, adapter);
 		}
 
+		if (profiler) {
+			profiler->Enter(node, type, NodeProfileOp::IsValid);
+		}
+
 		bool succeeded = wrapper.WrappedIsValid(node, tuple, adapter);
 
+		if (profiler) {
+			profiler->Exit();
+		}
+
 		if (DebuggerAttachment) {
 			DebuggerAttachment->IsValidPostHook(node, tuple, adapter, succeeded);
 		}
@@ -190,14 +204,24 @@ namespace bg3se
 
 	void NodeVMTWrappers::WrappedPushDownTuple(Node * node, VirtTupleLL * tuple, uint32_t adapter, EntryPoint which)
 	{
-		auto & wrapper = GetWrapper(node);
+		auto type = GetType(node);
+		auto & wrapper = GetWrapper(type);
+		auto profiler = ProfilerAttachment;
 
 		if (DebuggerAttachment) {
 			DebuggerAttachment->PushDownPreHook(node, tuple, adapter, which, false);
 		}
 
+		if (profiler) {
+			profiler->Enter(node, type, NodeProfileOp::PushDown);
+		}
+
 		wrapper.WrappedPushDownTuple(node, tuple, adapter, which);
 
+		if (profiler) {
+			profiler->Exit();
+		}
+
 		if (DebuggerAttachment) {
 			DebuggerAttachment->PushDownPostHook(node, tuple, adapter, which, false);
 		}
@@ -205,14 +229,24 @@ namespace bg3se
 
 	void NodeVMTWrappers::WrappedPushDownTupleDelete(Node * node, VirtTupleLL * tuple, uint32_t adapter, EntryPoint which)
 	{
-		auto & wrapper = GetWrapper(node);
+		auto type = GetType(node);
+		auto & wrapper = GetWrapper(type);
+		auto profiler = ProfilerAttachment;
 
 		if (DebuggerAttachment) {
 			DebuggerAttachment->PushDownPreHook(node, tuple, adapter, which, true);
 		}
 
+		if (profiler) {
+			profiler->Enter(node, type, NodeProfileOp::PushDownDelete);
+		}
+
 		wrapper.WrappedPushDownTupleDelete(node, tuple, adapter, which);
 
+		if (profiler) {
+			profiler->Exit();
+		}
+
 		if (DebuggerAttachment) {
 			DebuggerAttachment->PushDownPostHook(node, tuple, adapter, which, true);
 		}
@@ -220,7 +254,9 @@ namespace bg3se
 
 	void NodeVMTWrappers::WrappedInsertTuple(Node * node, TuplePtrLL * tuple)
 	{
-		auto & wrapper = GetWrapper(node);
+		auto type = GetType(node);
+		auto & wrapper = GetWrapper(type);
+		auto profiler = ProfilerAttachment;
 
 		if (DebuggerAttachment) {
 			DebuggerAttachment->InsertPreHook(node, tuple, false);
@@ -230,8 +266,16 @@ namespace bg3se
 			OsirisCallbacksAttachment->InsertPreHook(node, tuple, false);
 		}
 
+		if (profiler) {
+			profiler->Enter(node, type, NodeProfileOp::Insert);
+		}
+
 		wrapper.WrappedInsertTuple(node, tuple);
 
+		if (profiler) {
+			profiler->Exit();
+		}
+
 		if (DebuggerAttachment) {
 			DebuggerAttachment->InsertPostHook(node, tuple, false);
 		}
@@ -243,7 +287,9 @@ namespace bg3se
 
 	void NodeVMTWrappers::WrappedDeleteTuple(Node * node, TuplePtrLL * tuple)
 	{
-		auto & wrapper = GetWrapper(node);
+		auto type = GetType(node);
+		auto & wrapper = GetWrapper(type);
+		auto profiler = ProfilerAttachment;
 
 		if (DebuggerAttachment) {
 			DebuggerAttachment->InsertPreHook(node, tuple, true);
@@ -253,8 +299,16 @@ namespace bg3se
 			OsirisCallbacksAttachment->InsertPreHook(node, tuple, true);
 		}
 
+		if (profiler) {
+			profiler->Enter(node, type, NodeProfileOp::Delete);
+		}
+
 		wrapper.WrappedDeleteTuple(node, tuple);
 
+		if (profiler) {
+			profiler->Exit();
+		}
+
 		if (DebuggerAttachment) {
 			DebuggerAttachment->InsertPostHook(node, tuple, true);
 		}
@@ -266,7 +320,9 @@ namespace bg3se
 
 	bool NodeVMTWrappers::WrappedCallQuery(Node * node, OsiArgumentDesc * args)
 	{
-		auto & wrapper = GetWrapper(node);
+		auto type = GetType(node);
+		auto & wrapper = GetWrapper(type);
+		auto profiler = ProfilerAttachment;
 
 		if (DebuggerAttachment) {
 			DebuggerAttachment->CallQueryPreHook(node, args);
@@ -276,8 +332,16 @@ namespace bg3se
 			OsirisCallbacksAttachment->CallQueryPreHook(node, args);
 		}
 
+		if (profiler) {
+			profiler->Enter(node, type, NodeProfileOp::CallQuery);
+		}
+
 		bool succeeded = wrapper.WrappedCallQuery(node, args);
 
+		if (profiler) {
+			profiler->Exit();
+		}
+
 		if (DebuggerAttachment) {
 			DebuggerAttachment->CallQueryPostHook(node, args, succeeded);
 		}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GameDefinitions/Osiris.h>
+#include <Osiris/Shared/NodeProfiler.h>
 #include <unordered_map>
 #include <functional>
 
@@ -57,9 +58,11 @@ namespace bg3se
 
 		osidbg::Debugger* DebuggerAttachment{ nullptr };
 		esv::lua::OsirisCallbackManager* OsirisCallbacksAttachment{ nullptr };
+		OsirisNodeProfiler* ProfilerAttachment{ nullptr };
 
 		NodeType GetType(Node * node);
 		NodeVMTWrapper & GetWrapper(Node * node);
+		NodeVMTWrapper & GetWrapper(NodeType type);
 
 	private:
 		NodeVMT ** vmts_;
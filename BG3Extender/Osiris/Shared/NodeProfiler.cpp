@@ -0,0 +1,459 @@
+#include "stdafx.h"
+#include <Osiris/Shared/NodeProfiler.h>
+#include <intrin.h>
+#include <map>
+
+namespace bg3se
+{
+	static char const* NodeProfileOpNames[(unsigned)NodeProfileOp::Max + 1] = {
+		"IsValid",
+		"PushDown",
+		"PushDownDelete",
+		"Insert",
+		"Delete",
+		"CallQuery"
+	};
+
+	static char const* NodeTypeNames[(unsigned)NodeType::Max + 1] = {
+		"None",
+		"Database",
+		"Proc",
+		"DivQuery",
+		"And",
+		"NotAnd",
+		"RelOp",
+		"Rule",
+		"InternalQuery",
+		"UserQuery"
+	};
+
+	uint64_t NodeProfileStats::TotalCalls() const
+	{
+		uint64_t calls{ 0 };
+		for (auto count : Calls) {
+			calls += count;
+		}
+
+		return calls;
+	}
+
+	void NodeProfileStats::Merge(NodeProfileStats const& other)
+	{
+		for (unsigned i = 0; i <= (unsigned)NodeProfileOp::Max; i++) {
+			Calls[i] += other.Calls[i];
+		}
+
+		Tuples += other.Tuples;
+		InclusiveTicks += other.InclusiveTicks;
+		ExclusiveTicks += other.ExclusiveTicks;
+	}
+
+	OsirisNodeProfiler::OsirisNodeProfiler(OsirisStaticGlobals const& globals)
+		: globals_(globals)
+	{}
+
+	OsirisNodeProfiler::~OsirisNodeProfiler()
+	{}
+
+	void OsirisNodeProfiler::Start(bool captureTrace)
+	{
+		Reset();
+		captureTrace_ = captureTrace;
+		startTime_ = std::chrono::steady_clock::now();
+		startTsc_ = __rdtsc();
+		running_ = true;
+		DEBUG("OsirisNodeProfiler::Start(): Profiling started (trace capture %s)", captureTrace ? "on" : "off");
+	}
+
+	void OsirisNodeProfiler::Stop()
+	{
+		if (!running_) return;
+
+		stopTsc_ = __rdtsc();
+		stopTime_ = std::chrono::steady_clock::now();
+		running_ = false;
+		DEBUG("OsirisNodeProfiler::Stop(): Profiling stopped after %.3f ms", GetProfiledMicroseconds() / 1000.0);
+	}
+
+	void OsirisNodeProfiler::Reset()
+	{
+		std::lock_guard _(bufferLock_);
+		buffers_.clear();
+		session_++;
+	}
+
+	OsirisNodeProfiler::ThreadBuffer* OsirisNodeProfiler::GetThreadBuffer()
+	{
+		static thread_local ThreadBuffer* buffer{ nullptr };
+		static thread_local uint32_t bufferSession{ 0 };
+
+		if (bufferSession != session_) {
+			buffer = MakeThreadBuffer();
+			bufferSession = session_;
+		}
+
+		return buffer;
+	}
+
+	OsirisNodeProfiler::ThreadBuffer* OsirisNodeProfiler::MakeThreadBuffer()
+	{
+		auto buffer = std::make_unique<ThreadBuffer>();
+		buffer->ThreadId = GetCurrentThreadId();
+		buffer->CallTree.push_back(CallTreeNode{ 0, 0, 0, 0 });
+
+		std::lock_guard _(bufferLock_);
+		auto buf = buffer.get();
+		buffers_.push_back(std::move(buffer));
+		return buf;
+	}
+
+	uint32_t OsirisNodeProfiler::GetNodeGoal(Node* node, NodeType type) const
+	{
+		switch (type) {
+		case NodeType::And:
+		case NodeType::NotAnd:
+		case NodeType::RelOp:
+		case NodeType::Rule:
+			return static_cast<TreeNode*>(node)->Next.GoalId;
+
+		default:
+			return 0;
+		}
+	}
+
+	void OsirisNodeProfiler::Enter(Node* node, NodeType type, NodeProfileOp op)
+	{
+		auto buf = GetThreadBuffer();
+		auto parent = buf->Stack.empty() ? nullptr : &buf->Stack[buf->Stack.size() - 1];
+
+		Frame frame;
+		frame.ChildTicks = 0;
+		frame.NodeId = node->Id;
+		frame.Op = op;
+		// Data nodes aren't owned by a goal; they're accounted to the goal of the rule that called them
+		frame.GoalId = GetNodeGoal(node, type);
+		if (frame.GoalId == 0 && parent != nullptr) {
+			frame.GoalId = parent->GoalId;
+		}
+
+		auto counters = buf->Nodes.try_get(frame.NodeId);
+		if (counters == nullptr) {
+			counters = buf->Nodes.set(frame.NodeId, Counters{});
+			counters->Type = type;
+		}
+
+		counters->Stats.Calls[(unsigned)op]++;
+		if (op != NodeProfileOp::IsValid && op != NodeProfileOp::CallQuery) {
+			counters->Stats.Tuples++;
+		}
+
+		frame.OutermostNode = (counters->ActiveDepth++ == 0);
+
+		if (frame.GoalId != 0) {
+			auto goal = buf->Goals.try_get(frame.GoalId);
+			if (goal == nullptr) {
+				goal = buf->Goals.set(frame.GoalId, Counters{});
+			}
+
+			goal->Stats.Calls[(unsigned)op]++;
+			if (op != NodeProfileOp::IsValid && op != NodeProfileOp::CallQuery) {
+				goal->Stats.Tuples++;
+			}
+
+			frame.OutermostGoal = (goal->ActiveDepth++ == 0);
+		} else {
+			frame.OutermostGoal = false;
+		}
+
+		uint32_t parentIndex = parent ? parent->TreeIndex : 0;
+		uint64_t childKey = ((uint64_t)parentIndex << 32) | frame.NodeId;
+		auto child = buf->CallTreeChildren.try_get(childKey);
+		if (child != nullptr) {
+			frame.TreeIndex = *child;
+		} else if (buf->CallTree.size() < MaxCallTreeNodes) {
+			frame.TreeIndex = buf->CallTree.size();
+			buf->CallTree.push_back(CallTreeNode{ frame.NodeId, parentIndex, 0, 0 });
+			buf->CallTreeChildren.set(childKey, frame.TreeIndex);
+		} else {
+			frame.TreeIndex = parentIndex;
+		}
+
+		buf->CallTree[frame.TreeIndex].Calls++;
+
+		// Taken last so the bookkeeping above is not accounted to the node
+		frame.StartTsc = __rdtsc();
+		buf->Stack.push_back(frame);
+	}
+
+	void OsirisNodeProfiler::Exit()
+	{
+		auto endTsc = __rdtsc();
+		auto buf = GetThreadBuffer();
+		// The profile may have been reset while the node was running
+		if (buf->Stack.empty()) return;
+
+		auto frame = buf->Stack.pop_last();
+		auto elapsed = endTsc - frame.StartTsc;
+		auto exclusive = elapsed > frame.ChildTicks ? elapsed - frame.ChildTicks : 0;
+
+		if (!buf->Stack.empty()) {
+			buf->Stack[buf->Stack.size() - 1].ChildTicks += elapsed;
+		}
+
+		auto counters = buf->Nodes.try_get(frame.NodeId);
+		counters->ActiveDepth--;
+		counters->Stats.ExclusiveTicks += exclusive;
+		if (frame.OutermostNode) {
+			counters->Stats.InclusiveTicks += elapsed;
+		}
+
+		if (frame.GoalId != 0) {
+			auto goal = buf->Goals.try_get(frame.GoalId);
+			goal->ActiveDepth--;
+			goal->Stats.ExclusiveTicks += exclusive;
+			if (frame.OutermostGoal) {
+				goal->Stats.InclusiveTicks += elapsed;
+			}
+		}
+
+		buf->CallTree[frame.TreeIndex].ExclusiveTicks += exclusive;
+
+		if (captureTrace_) {
+			if (buf->Trace.size() < MaxTraceEvents) {
+				buf->Trace.push_back(TraceEvent{ frame.StartTsc, endTsc, frame.NodeId, frame.Op });
+			} else {
+				buf->DroppedTraceEvents++;
+			}
+		}
+	}
+
+	std::vector<NodeProfileEntry> OsirisNodeProfiler::MergeCounters(FlatHashMap<uint32_t, Counters> ThreadBuffer::* counters)
+	{
+		std::lock_guard _(bufferLock_);
+		std::unordered_map<uint32_t, NodeProfileEntry> merged;
+		for (auto const& buf : buffers_) {
+			auto const& ids = ((*buf).*counters).keys();
+			auto const& values = ((*buf).*counters).values();
+			for (uint32_t i = 0; i < ids.size(); i++) {
+				auto& entry = merged[ids[i]];
+				entry.Id = ids[i];
+				entry.Type = values[i].Type;
+				entry.Stats.Merge(values[i].Stats);
+			}
+		}
+
+		std::vector<NodeProfileEntry> entries;
+		entries.reserve(merged.size());
+		for (auto const& it : merged) {
+			entries.push_back(it.second);
+		}
+
+		std::sort(entries.begin(), entries.end(), [](NodeProfileEntry const& a, NodeProfileEntry const& b) {
+			return a.Stats.ExclusiveTicks > b.Stats.ExclusiveTicks;
+		});
+		return entries;
+	}
+
+	std::vector<NodeProfileEntry> OsirisNodeProfiler::GetNodeStats()
+	{
+		return MergeCounters(&ThreadBuffer::Nodes);
+	}
+
+	std::vector<NodeProfileEntry> OsirisNodeProfiler::GetGoalStats()
+	{
+		return MergeCounters(&ThreadBuffer::Goals);
+	}
+
+	uint64_t OsirisNodeProfiler::GetDroppedTraceEvents()
+	{
+		std::lock_guard _(bufferLock_);
+		uint64_t dropped{ 0 };
+		for (auto const& buf : buffers_) {
+			dropped += buf->DroppedTraceEvents;
+		}
+
+		return dropped;
+	}
+
+	double OsirisNodeProfiler::GetProfiledMicroseconds() const
+	{
+		auto end = running_ ? std::chrono::steady_clock::now() : stopTime_;
+		return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - startTime_).count() / 1000.0;
+	}
+
+	double OsirisNodeProfiler::GetTicksPerMicrosecond() const
+	{
+		// The TSC rate is calibrated against the steady clock over the whole profiling session
+		auto endTsc = running_ ? __rdtsc() : stopTsc_;
+		auto elapsedUs = GetProfiledMicroseconds();
+		if (elapsedUs <= 0.0 || endTsc <= startTsc_) {
+			return 1.0;
+		}
+
+		return (double)(endTsc - startTsc_) / elapsedUs;
+	}
+
+	double OsirisNodeProfiler::TicksToMicroseconds(uint64_t ticks) const
+	{
+		return (double)ticks / GetTicksPerMicrosecond();
+	}
+
+	char const* OsirisNodeProfiler::GetNodeTypeName(NodeType type)
+	{
+		return NodeTypeNames[(unsigned)type];
+	}
+
+	char const* OsirisNodeProfiler::GetOpName(NodeProfileOp op)
+	{
+		return NodeProfileOpNames[(unsigned)op];
+	}
+
+	STDString OsirisNodeProfiler::GetNodeName(uint32_t nodeId) const
+	{
+		if (globals_.Nodes == nullptr || *globals_.Nodes == nullptr
+			|| nodeId == 0 || nodeId > (*globals_.Nodes)->Db.Size) {
+			return STDString("Node #") + std::to_string(nodeId).c_str();
+		}
+
+		auto node = (*globals_.Nodes)->Db.Elements[nodeId - 1];
+		auto type = NodeType::None;
+		for (auto const& buf : buffers_) {
+			auto counters = buf->Nodes.try_get(nodeId);
+			if (counters != nullptr) {
+				type = counters->Type;
+				break;
+			}
+		}
+
+		switch (type) {
+		case NodeType::Rule:
+		{
+			auto rule = static_cast<RuleNode*>(node);
+			return GetGoalName(rule->Next.GoalId) + ":" + std::to_string(rule->Line).c_str();
+		}
+
+		case NodeType::And:
+		case NodeType::NotAnd:
+		case NodeType::RelOp:
+			return STDString(GetNodeTypeName(type)) + " #" + std::to_string(nodeId).c_str();
+
+		default:
+			if (node->Function != nullptr) {
+				auto const& params = node->Function->Signature->Params->Params;
+				return STDString(node->Function->Signature->Name) + "/" + std::to_string(params.Size).c_str();
+			} else {
+				return STDString(GetNodeTypeName(type)) + " #" + std::to_string(nodeId).c_str();
+			}
+		}
+	}
+
+	STDString OsirisNodeProfiler::GetGoalName(uint32_t goalId) const
+	{
+		auto goal = (globals_.Goals != nullptr && *globals_.Goals != nullptr) ? (*globals_.Goals)->Goals.Find(goalId) : nullptr;
+		if (goal != nullptr && *goal != nullptr) {
+			return (*goal)->Name;
+		} else {
+			return STDString("Goal #") + std::to_string(goalId).c_str();
+		}
+	}
+
+	static void AppendJsonString(STDString& out, STDString const& s)
+	{
+		out += '"';
+		for (auto c : s) {
+			switch (c) {
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if ((unsigned char)c >= 0x20) {
+					out += c;
+				}
+				break;
+			}
+		}
+		out += '"';
+	}
+
+	void OsirisNodeProfiler::ExportChromeTrace(STDString& out)
+	{
+		std::lock_guard _(bufferLock_);
+		auto ticksPerUs = GetTicksPerMicrosecond();
+		std::unordered_map<uint32_t, STDString> names;
+		char buf[256];
+
+		out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		for (auto const& thread : buffers_) {
+			for (auto const& ev : thread->Trace) {
+				auto nameIt = names.find(ev.NodeId);
+				if (nameIt == names.end()) {
+					nameIt = names.insert(std::make_pair(ev.NodeId, GetNodeName(ev.NodeId))).first;
+				}
+
+				if (!first) out += ",";
+				first = false;
+
+				out += "{\"name\":";
+				AppendJsonString(out, nameIt->second);
+				sprintf_s(buf, "%.3f", (double)(ev.StartTsc - startTsc_) / ticksPerUs);
+				out += ",\"cat\":\"Osiris\",\"ph\":\"X\",\"ts\":";
+				out += buf;
+				sprintf_s(buf, ",\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"node\":%u,\"op\":\"%s\"}}",
+					(double)(ev.EndTsc - ev.StartTsc) / ticksPerUs, thread->ThreadId, ev.NodeId, GetOpName(ev.Op));
+				out += buf;
+			}
+		}
+
+		out += "]}";
+	}
+
+	void OsirisNodeProfiler::ExportFoldedStacks(STDString& out)
+	{
+		std::lock_guard _(bufferLock_);
+		auto ticksPerUs = GetTicksPerMicrosecond();
+		std::unordered_map<uint32_t, STDString> names;
+		// Identical call paths from different threads are merged
+		std::map<STDString, uint64_t> stacks;
+		Array<uint32_t> path;
+
+		for (auto const& thread : buffers_) {
+			auto const& tree = thread->CallTree;
+			for (uint32_t i = 1; i < tree.size(); i++) {
+				if (tree[i].ExclusiveTicks == 0) continue;
+
+				path.clear();
+				for (auto index = i; index != 0; index = tree[index].Parent) {
+					path.push_back(tree[index].NodeId);
+				}
+
+				STDString stack;
+				for (auto it = path.size(); it > 0; it--) {
+					auto nodeId = path[it - 1];
+					auto nameIt = names.find(nodeId);
+					if (nameIt == names.end()) {
+						nameIt = names.insert(std::make_pair(nodeId, GetNodeName(nodeId))).first;
+					}
+
+					if (!stack.empty()) stack += ';';
+					stack += nameIt->second;
+				}
+
+				stacks[stack] += tree[i].ExclusiveTicks;
+			}
+		}
+
+		out.clear();
+		for (auto const& stack : stacks) {
+			auto us = (uint64_t)((double)stack.second / ticksPerUs + 0.5);
+			if (us == 0) continue;
+
+			out += stack.first;
+			out += ' ';
+			out += std::to_string(us).c_str();
+			out += '\n';
+		}
+	}
+}
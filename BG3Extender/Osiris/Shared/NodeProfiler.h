@@ -0,0 +1,153 @@
+#pragma once
+
+#include <GameDefinitions/Osiris.h>
+#include <mutex>
+#include <chrono>
+
+namespace bg3se
+{
+	enum class NodeProfileOp : uint8_t
+	{
+		IsValid = 0,
+		PushDown = 1,
+		PushDownDelete = 2,
+		Insert = 3,
+		Delete = 4,
+		CallQuery = 5,
+		Max = CallQuery
+	};
+
+	struct NodeProfileStats
+	{
+		uint64_t Calls[(unsigned)NodeProfileOp::Max + 1]{ 0 };
+		// Number of tuples pushed down, inserted into or deleted from the node
+		uint64_t Tuples{ 0 };
+		// Inclusive time only counts the outermost activation of recursive nodes/goals
+		uint64_t InclusiveTicks{ 0 };
+		uint64_t ExclusiveTicks{ 0 };
+
+		uint64_t TotalCalls() const;
+		void Merge(NodeProfileStats const& other);
+	};
+
+	struct NodeProfileEntry
+	{
+		uint32_t Id{ 0 };
+		NodeType Type{ NodeType::None };
+		NodeProfileStats Stats;
+	};
+
+	// Instrumenting profiler for Osiris story execution.
+	// Attached to the node VMT wrappers; every wrapped node call is timed using TSC timestamps
+	// and accumulated into per-node, per-goal and call tree statistics of the calling thread.
+	// Thread buffers are only merged when the profile is queried or exported.
+	class OsirisNodeProfiler : Noncopyable<OsirisNodeProfiler>
+	{
+	public:
+		// Max number of distinct call paths tracked per thread; deeper paths are merged into their parent
+		static constexpr uint32_t MaxCallTreeNodes = 0x100000;
+		// Max number of individual node calls recorded per thread when trace capture is enabled
+		static constexpr uint32_t MaxTraceEvents = 0x200000;
+
+		OsirisNodeProfiler(OsirisStaticGlobals const& globals);
+		~OsirisNodeProfiler();
+
+		void Start(bool captureTrace);
+		void Stop();
+		void Reset();
+
+		inline bool IsRunning() const
+		{
+			return running_;
+		}
+
+		void Enter(Node* node, NodeType type, NodeProfileOp op);
+		void Exit();
+
+		std::vector<NodeProfileEntry> GetNodeStats();
+		std::vector<NodeProfileEntry> GetGoalStats();
+		uint64_t GetDroppedTraceEvents();
+		double GetProfiledMicroseconds() const;
+		double TicksToMicroseconds(uint64_t ticks) const;
+
+		static char const* GetNodeTypeName(NodeType type);
+		static char const* GetOpName(NodeProfileOp op);
+		STDString GetNodeName(uint32_t nodeId) const;
+		STDString GetGoalName(uint32_t goalId) const;
+
+		// Exports the recorded trace events in Chrome trace event format (chrome://tracing, Perfetto)
+		void ExportChromeTrace(STDString& out);
+		// Exports the call tree in collapsed stack format ("a;b;c <microseconds>") for flame graph tools
+		void ExportFoldedStacks(STDString& out);
+
+	private:
+		struct Frame
+		{
+			uint64_t StartTsc;
+			uint64_t ChildTicks;
+			uint32_t NodeId;
+			uint32_t GoalId;
+			uint32_t TreeIndex;
+			NodeProfileOp Op;
+			bool OutermostNode;
+			bool OutermostGoal;
+		};
+
+		struct Counters
+		{
+			NodeProfileStats Stats;
+			// Number of activations of the node/goal currently on the stack
+			uint32_t ActiveDepth{ 0 };
+			NodeType Type{ NodeType::None };
+		};
+
+		struct CallTreeNode
+		{
+			uint32_t NodeId;
+			uint32_t Parent;
+			uint64_t Calls;
+			uint64_t ExclusiveTicks;
+		};
+
+		struct TraceEvent
+		{
+			uint64_t StartTsc;
+			uint64_t EndTsc;
+			uint32_t NodeId;
+			NodeProfileOp Op;
+		};
+
+		struct ThreadBuffer
+		{
+			uint32_t ThreadId;
+			Array<Frame> Stack;
+			FlatHashMap<uint32_t, Counters> Nodes;
+			FlatHashMap<uint32_t, Counters> Goals;
+			// Index 0 is the root of the call tree
+			Array<CallTreeNode> CallTree;
+			// (parent index << 32 | node id) -> call tree index
+			FlatHashMap<uint64_t, uint32_t> CallTreeChildren;
+			Array<TraceEvent> Trace;
+			uint64_t DroppedTraceEvents{ 0 };
+		};
+
+		OsirisStaticGlobals const& globals_;
+		std::mutex bufferLock_;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+		// Incremented whenever the recorded data is discarded, invalidating the cached thread buffer pointers
+		uint32_t session_{ 1 };
+		bool running_{ false };
+		bool captureTrace_{ false };
+
+		uint64_t startTsc_{ 0 };
+		uint64_t stopTsc_{ 0 };
+		std::chrono::steady_clock::time_point startTime_;
+		std::chrono::steady_clock::time_point stopTime_;
+
+		ThreadBuffer* GetThreadBuffer();
+		ThreadBuffer* MakeThreadBuffer();
+		uint32_t GetNodeGoal(Node* node, NodeType type) const;
+		double GetTicksPerMicrosecond() const;
+		std::vector<NodeProfileEntry> MergeCounters(FlatHashMap<uint32_t, Counters> ThreadBuffer::* counters);
+	};
+}
@@ -5,5 +5,6 @@
 #include <CoreLib/Base/BaseString.h>
 #include <CoreLib/Base/BaseArray.h>
 #include <CoreLib/Base/BaseMap.h>
+#include <CoreLib/Base/BaseFlatMap.h>
 #include <CoreLib/Base/BaseTypes.h>
 #include <CoreLib/Base/BaseInterface.h>
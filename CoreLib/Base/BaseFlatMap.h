@@ -0,0 +1,599 @@
+#pragma once
+
+#include <cstdint>
+#include <emmintrin.h>
+
+BEGIN_SE()
+
+// Hash used by the flat hash containers.
+// Most extender hash functions (FixedString index, Guid XOR) have poor low-bit entropy,
+// so the value is remixed before being split into the group index (H1) and control tag (H2).
+template <class T>
+inline uint64_t FlatHashMapHash(T const& v)
+{
+	uint64_t h = Hash(v);
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// Open-addressing hash set with SSE2-probed control byte groups (Swiss table layout).
+//
+// Keys are stored densely in insertion order (like MultiHashSet), and the hash table only
+// stores 32-bit key indices, so the iteration and index-based API is the same as MultiHashSet.
+// A lookup touches one 16-byte control group (usually), one index slot and one key.
+//
+// NOTE: This container is not layout-compatible with game containers;
+// only use it for memory that is owned by the extender!
+template <class T, class Allocator = GameMemoryAllocator>
+class FlatHashSet
+{
+public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = T const&;
+	using iterator = ContiguousIterator<T>;
+	using const_iterator = ContiguousConstIterator<T>;
+	using difference_type = int32_t;
+	using size_type = uint32_t;
+
+	static constexpr uint32_t GroupSize = 16;
+	static constexpr uint32_t MinCapacity = GroupSize;
+
+	// Control byte values; full slots store the 7-bit H2 tag (high bit clear)
+	static constexpr int8_t CtrlEmpty = (int8_t)0x80;
+	static constexpr int8_t CtrlDeleted = (int8_t)0xFE;
+
+	FlatHashSet() noexcept
+	{}
+
+	FlatHashSet(FlatHashSet const& other)
+		: Keys(other.Keys)
+	{
+		Rehash(other.capacity_);
+	}
+
+	FlatHashSet(FlatHashSet&& other) noexcept
+		: Keys(std::move(other.Keys)), ctrlAlloc_(other.ctrlAlloc_), ctrl_(other.ctrl_), slots_(other.slots_),
+		capacity_(other.capacity_), growthLeft_(other.growthLeft_)
+	{
+		other.ctrlAlloc_ = nullptr;
+		other.ctrl_ = nullptr;
+		other.slots_ = nullptr;
+		other.capacity_ = 0;
+		other.growthLeft_ = 0;
+	}
+
+	~FlatHashSet()
+	{
+		FreeTable();
+	}
+
+	FlatHashSet& operator =(FlatHashSet const& other)
+	{
+		if (this != &other) {
+			Keys = other.Keys;
+			Rehash(other.capacity_);
+		}
+
+		return *this;
+	}
+
+	FlatHashSet& operator =(FlatHashSet&& other) noexcept
+	{
+		if (this != &other) {
+			FreeTable();
+			Keys = std::move(other.Keys);
+			ctrlAlloc_ = other.ctrlAlloc_;
+			ctrl_ = other.ctrl_;
+			slots_ = other.slots_;
+			capacity_ = other.capacity_;
+			growthLeft_ = other.growthLeft_;
+			other.ctrlAlloc_ = nullptr;
+			other.ctrl_ = nullptr;
+			other.slots_ = nullptr;
+			other.capacity_ = 0;
+			other.growthLeft_ = 0;
+		}
+
+		return *this;
+	}
+
+	inline uint32_t size() const
+	{
+		return Keys.size();
+	}
+
+	inline bool empty() const
+	{
+		return Keys.empty();
+	}
+
+	inline uint32_t capacity() const
+	{
+		return capacity_;
+	}
+
+	Array<T> const& keys() const
+	{
+		return Keys;
+	}
+
+	void clear()
+	{
+		Keys.clear();
+		if (ctrl_ != nullptr) {
+			memset(ctrl_, (uint8_t)CtrlEmpty, capacity_);
+			growthLeft_ = MaxLoad(capacity_);
+		}
+	}
+
+	void reserve(uint32_t count)
+	{
+		auto cap = CapacityForSize(count);
+		if (cap > capacity_) {
+			Rehash(cap);
+		}
+	}
+
+	int find_index(T const& key) const
+	{
+		auto slot = FindSlot(key);
+		return slot != -1 ? (int)slots_[slot] : -1;
+	}
+
+	int insert(T const& key)
+	{
+		auto index = find_index(key);
+		if (index != -1) {
+			return index;
+		}
+
+		if (growthLeft_ == 0) {
+			Grow();
+		}
+
+		int keyIdx = (int)Keys.size();
+		Keys.push_back(key);
+		InsertToTable(FlatHashMapHash(key), keyIdx);
+		return keyIdx;
+	}
+
+	ContiguousIterator<T> begin()
+	{
+		return Keys.begin();
+	}
+
+	ContiguousConstIterator<T> begin() const
+	{
+		return Keys.begin();
+	}
+
+	ContiguousIterator<T> end()
+	{
+		return Keys.end();
+	}
+
+	ContiguousConstIterator<T> end() const
+	{
+		return Keys.end();
+	}
+
+	ContiguousIterator<T> find(T const& key)
+	{
+		auto idx = find_index(key);
+		return idx != -1 ? (Keys.begin() + idx) : Keys.end();
+	}
+
+	ContiguousConstIterator<T> find(T const& key) const
+	{
+		auto idx = find_index(key);
+		return idx != -1 ? (Keys.begin() + idx) : Keys.end();
+	}
+
+	bool remove(T const& key)
+	{
+		return removeKeyInternal(key) >= 0;
+	}
+
+	bool contains(T const& key) const
+	{
+		return find_index(key) != -1;
+	}
+
+protected:
+	Array<T> Keys;
+
+	// Removes the key and moves the last key into its place to keep keys dense.
+	// Returns the index the key was removed from, or -1 if the key was not found.
+	int removeKeyInternal(T const& key)
+	{
+		auto slot = FindSlot(key);
+		if (slot == -1) return -1;
+
+		auto keyIndex = (int32_t)slots_[slot];
+		ctrl_[slot] = CtrlDeleted;
+
+		auto lastIndex = (int32_t)Keys.size() - 1;
+		if (keyIndex != lastIndex) {
+			auto lastSlot = FindSlot(Keys[lastIndex]);
+			assert(lastSlot != -1);
+			slots_[lastSlot] = (uint32_t)keyIndex;
+			Keys[keyIndex] = std::move(Keys[lastIndex]);
+		}
+
+		Keys.remove_last();
+		return keyIndex;
+	}
+
+private:
+	void* ctrlAlloc_{ nullptr };
+	int8_t* ctrl_{ nullptr };
+	uint32_t* slots_{ nullptr };
+	uint32_t capacity_{ 0 };
+	uint32_t growthLeft_{ 0 };
+
+	static inline uint32_t H1(uint64_t hash)
+	{
+		return (uint32_t)(hash >> 7);
+	}
+
+	static inline int8_t H2(uint64_t hash)
+	{
+		return (int8_t)(hash & 0x7f);
+	}
+
+	// Max. 7/8 load factor
+	static constexpr uint32_t MaxLoad(uint32_t capacity)
+	{
+		return capacity - capacity / 8;
+	}
+
+	static uint32_t CapacityForSize(uint32_t size)
+	{
+		uint32_t cap = MinCapacity;
+		while (MaxLoad(cap) < size) {
+			cap *= 2;
+		}
+
+		return cap;
+	}
+
+	int FindSlot(T const& key) const
+	{
+		if (capacity_ == 0) return -1;
+
+		auto hash = FlatHashMapHash(key);
+		auto h2 = _mm_set1_epi8(H2(hash));
+		auto const empty = _mm_set1_epi8(CtrlEmpty);
+		auto groupMask = (capacity_ / GroupSize) - 1;
+		auto group = H1(hash) & groupMask;
+
+		for (uint32_t probe = 1;; probe++) {
+			auto ctrl = _mm_load_si128(reinterpret_cast<__m128i const*>(ctrl_ + group * GroupSize));
+			uint32_t matches = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, h2));
+			while (matches) {
+				unsigned long bit;
+				_BitScanForward(&bit, matches);
+				auto slot = group * GroupSize + bit;
+				if (Keys[slots_[slot]] == key) return (int)slot;
+				matches &= matches - 1;
+			}
+
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, empty)) != 0) {
+				return -1;
+			}
+
+			if (probe > groupMask) return -1;
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	void InsertToTable(uint64_t hash, int keyIdx)
+	{
+		auto groupMask = (capacity_ / GroupSize) - 1;
+		auto group = H1(hash) & groupMask;
+
+		for (uint32_t probe = 1;; probe++) {
+			auto ctrl = _mm_load_si128(reinterpret_cast<__m128i const*>(ctrl_ + group * GroupSize));
+			// Empty and deleted control bytes both have their high bit set
+			uint32_t available = (uint32_t)_mm_movemask_epi8(ctrl);
+			if (available) {
+				unsigned long bit;
+				_BitScanForward(&bit, available);
+				auto slot = group * GroupSize + bit;
+				if (ctrl_[slot] == CtrlEmpty) {
+					growthLeft_--;
+				}
+
+				ctrl_[slot] = H2(hash);
+				slots_[slot] = (uint32_t)keyIdx;
+				return;
+			}
+
+			assert(probe <= groupMask);
+			group = (group + probe) & groupMask;
+		}
+	}
+
+	void Grow()
+	{
+		// Tombstones count against the load factor; if at most half of the usable slots
+		// are live, rehash in place to drop tombstones instead of doubling the table
+		if (capacity_ > 0 && Keys.size() < MaxLoad(capacity_) / 2) {
+			Rehash(capacity_);
+		} else {
+			Rehash(capacity_ > 0 ? capacity_ * 2 : MinCapacity);
+		}
+	}
+
+	void Rehash(uint32_t newCapacity)
+	{
+		FreeTable();
+		if (newCapacity == 0) return;
+
+		capacity_ = newCapacity;
+		// Control groups are loaded with aligned SSE loads
+		ctrlAlloc_ = Allocator::Alloc(capacity_ + GroupSize - 1);
+		ctrl_ = reinterpret_cast<int8_t*>(((uintptr_t)ctrlAlloc_ + GroupSize - 1) & ~(uintptr_t)(GroupSize - 1));
+		slots_ = Allocator::template NewRaw<uint32_t>(capacity_);
+		memset(ctrl_, (uint8_t)CtrlEmpty, capacity_);
+		growthLeft_ = MaxLoad(capacity_);
+
+		for (uint32_t i = 0; i < Keys.size(); i++) {
+			InsertToTable(FlatHashMapHash(Keys[i]), (int)i);
+		}
+	}
+
+	void FreeTable()
+	{
+		if (ctrlAlloc_ != nullptr) {
+			Allocator::Free(ctrlAlloc_);
+			Allocator::Free(slots_);
+			ctrlAlloc_ = nullptr;
+			ctrl_ = nullptr;
+			slots_ = nullptr;
+		}
+
+		capacity_ = 0;
+		growthLeft_ = 0;
+	}
+};
+
+// Open-addressing hash map built on FlatHashSet; API mirrors MultiHashMap.
+// Values are stored densely in key order, so values()[find_index(key)] is valid.
+template <class TKey, class TValue, class Allocator = GameMemoryAllocator>
+class FlatHashMap : private FlatHashSet<TKey, Allocator>
+{
+public:
+	template <class TMap, class TValueRef>
+	class IteratorBase
+	{
+	public:
+		IteratorBase(TMap* map, int32_t index)
+			: Map(map), Index(index)
+		{}
+
+		IteratorBase operator ++ ()
+		{
+			IteratorBase it(Map, Index);
+			Index++;
+			return it;
+		}
+
+		IteratorBase& operator ++ (int)
+		{
+			++Index;
+			return *this;
+		}
+
+		bool operator == (IteratorBase const& it) const
+		{
+			return it.Map == Map && it.Index == Index;
+		}
+
+		bool operator != (IteratorBase const& it) const
+		{
+			return it.Map != Map || it.Index != Index;
+		}
+
+		TKey const& Key() const
+		{
+			return Map->keys()[Index];
+		}
+
+		TValueRef Value() const
+		{
+			return Map->values()[Index];
+		}
+
+		IteratorBase& operator * ()
+		{
+			return *this;
+		}
+
+		IteratorBase* operator -> ()
+		{
+			return this;
+		}
+
+		inline operator bool() const
+		{
+			return Index != (int32_t)Map->size();
+		}
+
+		inline bool operator !() const
+		{
+			return Index == (int32_t)Map->size();
+		}
+
+	private:
+		TMap* Map;
+		int32_t Index;
+	};
+
+	using Iterator = IteratorBase<FlatHashMap, TValue&>;
+	using ConstIterator = IteratorBase<FlatHashMap const, TValue const&>;
+
+	FlatHashMap() noexcept
+	{}
+
+	FlatHashMap(FlatHashMap const& other) = default;
+	FlatHashMap(FlatHashMap&& other) noexcept = default;
+	FlatHashMap& operator =(FlatHashMap const& other) = default;
+	FlatHashMap& operator =(FlatHashMap&& other) noexcept = default;
+
+	inline uint32_t size() const
+	{
+		return this->Keys.size();
+	}
+
+	inline bool empty() const
+	{
+		return this->Keys.empty();
+	}
+
+	Array<TKey> const& keys() const
+	{
+		return this->Keys;
+	}
+
+	Array<TValue>& values()
+	{
+		return Values;
+	}
+
+	Array<TValue> const& values() const
+	{
+		return Values;
+	}
+
+	void clear()
+	{
+		Values.clear();
+		FlatHashSet<TKey, Allocator>::clear();
+	}
+
+	void reserve(uint32_t count)
+	{
+		FlatHashSet<TKey, Allocator>::reserve(count);
+	}
+
+	TValue* set(TKey const& key, TValue&& value)
+	{
+		auto index = (uint32_t)this->insert(key);
+		if (index == Values.size()) {
+			Values.push_back(std::move(value));
+		} else {
+			Values[index] = std::move(value);
+		}
+
+		return &Values[index];
+	}
+
+	TValue* set(TKey const& key, TValue const& value)
+	{
+		auto index = (uint32_t)this->insert(key);
+		if (index == Values.size()) {
+			Values.push_back(value);
+		} else {
+			Values[index] = value;
+		}
+
+		return &Values[index];
+	}
+
+	TValue* get_or_add(TKey const& key)
+	{
+		auto index = (uint32_t)this->insert(key);
+		if (index == Values.size()) {
+			Values.push_back(TValue{});
+		}
+
+		return &Values[index];
+	}
+
+	bool remove(TKey const& key)
+	{
+		auto index = this->removeKeyInternal(key);
+		if (index >= 0) {
+			auto lastIndex = Values.size() - 1;
+			if ((uint32_t)index != lastIndex) {
+				Values[index] = std::move(Values[lastIndex]);
+			}
+
+			Values.remove_last();
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	Iterator begin()
+	{
+		return Iterator(this, 0);
+	}
+
+	ConstIterator begin() const
+	{
+		return ConstIterator(this, 0);
+	}
+
+	Iterator end()
+	{
+		return Iterator(this, (int32_t)this->Keys.size());
+	}
+
+	ConstIterator end() const
+	{
+		return ConstIterator(this, (int32_t)this->Keys.size());
+	}
+
+	Iterator find(TKey const& key)
+	{
+		auto idx = this->find_index(key);
+		return Iterator(this, idx != -1 ? idx : (int32_t)this->Keys.size());
+	}
+
+	ConstIterator find(TKey const& key) const
+	{
+		auto idx = this->find_index(key);
+		return ConstIterator(this, idx != -1 ? idx : (int32_t)this->Keys.size());
+	}
+
+	TValue const* try_get(TKey const& key) const
+	{
+		auto index = this->find_index(key);
+		return index != -1 ? &Values[index] : nullptr;
+	}
+
+	TValue* try_get(TKey const& key)
+	{
+		auto index = this->find_index(key);
+		return index != -1 ? &Values[index] : nullptr;
+	}
+
+	TValue get_or_default(TKey const& key, TValue const& defaultv = TValue{}) const
+	{
+		auto index = this->find_index(key);
+		return index != -1 ? Values[index] : defaultv;
+	}
+
+	inline int find_index(TKey const& key) const
+	{
+		return FlatHashSet<TKey, Allocator>::find_index(key);
+	}
+
+	inline bool contains(TKey const& key) const
+	{
+		return FlatHashSet<TKey, Allocator>::contains(key);
+	}
+
+private:
+	Array<TValue> Values;
+};
+
+END_SE()
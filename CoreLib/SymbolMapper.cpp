@@ -4,10 +4,10 @@
 #include <functional>
 #include <psapi.h>
 #include <DbgHelp.h>
+#include <chrono>
+#include <atomic>
 #include <CoreLib/tinyxml2.h>
 
-#undef DEBUG_MAPPINGS
-
 BEGIN_SE()
 
 void** StaticSymbolRef::Get() const
@@ -212,6 +212,224 @@ std::optional<uint32_t> Pattern::GetAnchor(char const* anchor) const
 	}
 }
 
+MultiPatternScanner::PatternId MultiPatternScanner::Add(Pattern const& pattern)
+{
+	patterns_.push_back(&pattern);
+	return (PatternId)(patterns_.size() - 1);
+}
+
+void MultiPatternScanner::BuildPrefixTable()
+{
+	// Count the number of patterns per prefix first, then fill the flattened table
+	std::vector<uint32_t> counts(NumPrefixes, 0);
+	auto forEachPrefix = [this](Pattern const& pattern, auto fn) {
+		auto const& bytes = pattern.pattern_;
+		uint32_t first = bytes[0].pattern;
+		if (bytes.size() >= 2 && bytes[1].mask == 0xff) {
+			fn(first | ((uint32_t)bytes[1].pattern << 8));
+		} else {
+			for (uint32_t second = 0; second < 0x100; second++) {
+				fn(first | (second << 8));
+			}
+		}
+	};
+
+	for (auto pattern : patterns_) {
+		forEachPrefix(*pattern, [&](uint32_t prefix) { counts[prefix]++; });
+	}
+
+	prefixOffsets_.resize(NumPrefixes + 1);
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < NumPrefixes; i++) {
+		prefixOffsets_[i] = offset;
+		offset += counts[i];
+	}
+	prefixOffsets_[NumPrefixes] = offset;
+
+	prefixPatterns_.resize(offset);
+	for (PatternId id = 0; id < patterns_.size(); id++) {
+		forEachPrefix(*patterns_[id], [&](uint32_t prefix) {
+			auto slot = prefixOffsets_[prefix + 1] - counts[prefix]--;
+			prefixPatterns_[slot] = id;
+		});
+	}
+}
+
+void MultiPatternScanner::ScanChunk(uint8_t const* chunkStart, uint8_t const* chunkEnd, uint8_t const* regionEnd, 
+	MatchList& matches, std::vector<uint64_t>& candidates) const
+{
+	candidates.resize(patterns_.size(), 0);
+	// Matches may start anywhere in the chunk, but the pattern can extend past the end of the chunk
+	// (up to the end of the scanned region), so matches crossing chunk boundaries aren't lost.
+	auto end = std::min(chunkEnd, regionEnd - 1);
+	for (auto p = chunkStart; p < end; p++) {
+		auto prefix = *reinterpret_cast<uint16_t const*>(p);
+		auto from = prefixOffsets_[prefix];
+		auto to = prefixOffsets_[prefix + 1];
+		for (auto i = from; i < to; i++) {
+			auto id = prefixPatterns_[i];
+			auto pattern = patterns_[id];
+			candidates[id]++;
+			// Same end condition as Pattern::Scan()
+			if (p + pattern->Size() < regionEnd && pattern->MatchPattern(p)) {
+				matches.push_back(std::make_pair(id, p));
+			}
+		}
+	}
+}
+
+void MultiPatternScanner::Scan(uint8_t const* start, std::size_t length, uint32_t numThreads)
+{
+	matches_.clear();
+	matches_.resize(patterns_.size());
+	candidates_.clear();
+	candidates_.resize(patterns_.size(), 0);
+	if (patterns_.empty() || length < 2) return;
+
+	BuildPrefixTable();
+
+	if (numThreads == 0) {
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	auto numChunks = (uint32_t)std::min<std::size_t>(numThreads, std::max<std::size_t>(length / MinChunkSize, 1));
+	auto chunkSize = (length + numChunks - 1) / numChunks;
+	auto regionEnd = start + length;
+
+	std::vector<MatchList> chunkMatches(numChunks);
+	std::vector<std::vector<uint64_t>> chunkCandidates(numChunks);
+	if (numChunks == 1) {
+		ScanChunk(start, regionEnd, regionEnd, chunkMatches[0], chunkCandidates[0]);
+	} else {
+		std::vector<std::thread> threads;
+		for (uint32_t i = 0; i < numChunks; i++) {
+			auto chunkStart = start + i * chunkSize;
+			auto chunkEnd = std::min(chunkStart + chunkSize, regionEnd);
+			threads.emplace_back([this, chunkStart, chunkEnd, regionEnd, &chunkMatches, &chunkCandidates, i]() {
+				ScanChunk(chunkStart, chunkEnd, regionEnd, chunkMatches[i], chunkCandidates[i]);
+			});
+		}
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	// Chunks are merged in address order, so the matches of each pattern stay sorted
+	for (auto const& chunk : chunkMatches) {
+		for (auto const& match : chunk) {
+			matches_[match.first].push_back(match.second);
+		}
+	}
+
+	for (auto const& chunk : chunkCandidates) {
+		for (PatternId id = 0; id < chunk.size(); id++) {
+			candidates_[id] += chunk[id];
+		}
+	}
+}
+
+uint64_t HashBytes(void const* data, std::size_t size)
+{
+	uint64_t hash[2];
+	MurmurHash3_x64_128(data, (int)size, 0, hash);
+	return hash[0];
+}
+
+void SymbolMappingCache::Reset(uint64_t fingerprint)
+{
+	fingerprint_ = fingerprint;
+	matches_.clear();
+}
+
+SymbolMappingCache::MatchOffsets const* SymbolMappingCache::Get(std::string const& mapping) const
+{
+	auto it = matches_.find(mapping);
+	return (it != matches_.end()) ? &it->second : nullptr;
+}
+
+void SymbolMappingCache::Set(std::string const& mapping, MatchOffsets&& offsets)
+{
+	matches_[mapping] = std::move(offsets);
+}
+
+bool SymbolMappingCache::Load(std::wstring const& path)
+{
+	std::vector<uint8_t> body;
+	if (!LoadFile(path, body)) {
+		return false;
+	}
+
+	std::size_t pos{ 0 };
+	auto read = [&body, &pos](void* dest, std::size_t size) {
+		if (size > body.size() - pos) {
+			return false;
+		}
+
+		memcpy(dest, body.data() + pos, size);
+		pos += size;
+		return true;
+	};
+
+	uint32_t magic, version, numMappings;
+	uint64_t fingerprint;
+	if (!read(&magic, sizeof(magic)) || !read(&version, sizeof(version))
+		|| magic != Magic || version != Version
+		|| !read(&fingerprint, sizeof(fingerprint)) || !read(&numMappings, sizeof(numMappings))) {
+		return false;
+	}
+
+	std::unordered_map<std::string, MatchOffsets> matches;
+	for (uint32_t i = 0; i < numMappings; i++) {
+		uint32_t nameLength, numMatches;
+		if (!read(&nameLength, sizeof(nameLength)) || nameLength > body.size()) {
+			return false;
+		}
+
+		std::string name(nameLength, '\0');
+		if (!read(name.data(), nameLength) || !read(&numMatches, sizeof(numMatches)) || numMatches > body.size()) {
+			return false;
+		}
+
+		MatchOffsets offsets(numMatches);
+		if (!read(offsets.data(), numMatches * sizeof(uint32_t))) {
+			return false;
+		}
+
+		matches.insert(std::make_pair(std::move(name), std::move(offsets)));
+	}
+
+	fingerprint_ = fingerprint;
+	matches_ = std::move(matches);
+	return true;
+}
+
+bool SymbolMappingCache::Save(std::wstring const& path) const
+{
+	std::vector<uint8_t> body;
+	auto write = [&body](void const* src, std::size_t size) {
+		auto bytes = reinterpret_cast<uint8_t const*>(src);
+		body.insert(body.end(), bytes, bytes + size);
+	};
+
+	auto numMappings = (uint32_t)matches_.size();
+	write(&Magic, sizeof(Magic));
+	write(&Version, sizeof(Version));
+	write(&fingerprint_, sizeof(fingerprint_));
+	write(&numMappings, sizeof(numMappings));
+
+	for (auto const& mapping : matches_) {
+		auto nameLength = (uint32_t)mapping.first.size();
+		auto numMatches = (uint32_t)mapping.second.size();
+		write(&nameLength, sizeof(nameLength));
+		write(mapping.first.data(), nameLength);
+		write(&numMatches, sizeof(numMatches));
+		write(mapping.second.data(), numMatches * sizeof(uint32_t));
+	}
+
+	return SaveFile(path, body);
+}
+
 std::optional<int> GetIntAttribute(tinyxml2::XMLElement* ele, char const* name)
 {
 	char const* value{ nullptr };
@@ -291,6 +509,8 @@ bool SymbolMappingLoader::LoadBuiltinMappings(int resourceId)
 		return false;
 	}
 
+	mappings_.Digest = HashBytes(xml->data(), xml->size());
+
 	return LoadMappings(&doc);
 }
 
@@ -822,6 +1042,250 @@ bool SymbolMapper::UpdatePatchReference(SymbolMappings::Patch& patch, uint8_t co
 	return true;
 }
 
+bool SymbolMapper::GetScanRange(SymbolMappings::Mapping const& mapping, uint8_t const*& start, std::size_t& size) const
+{
+	if (mapping.Scope != SymbolMappings::MatchScope::kBinary && mapping.Scope != SymbolMappings::MatchScope::kText) {
+		ERR("Unknown mapping scope!");
+		return false;
+	}
+
+	auto modIt = modules_.find(mapping.Module);
+	if (modIt == modules_.end()) {
+		ERR("Missing module data for module '%s'", mapping.Module.c_str());
+		return false;
+	}
+
+	if (mapping.Scope == SymbolMappings::MatchScope::kBinary) {
+		start = modIt->second.ModuleStart;
+		size = modIt->second.ModuleSize;
+	} else {
+		start = modIt->second.ModuleTextStart;
+		size = modIt->second.ModuleTextSize;
+	}
+
+	return true;
+}
+
+void SymbolMapper::PrescanMappings(std::vector<SymbolMappings::Mapping*> const& mappings)
+{
+	// Group mappings by the region they're scanning
+	std::map<std::pair<uint8_t const*, std::size_t>, std::vector<SymbolMappings::Mapping*>> regions;
+	for (auto mapping : mappings) {
+		uint8_t const* start;
+		std::size_t size;
+		if (mapping->Scope != SymbolMappings::MatchScope::kCustom && GetScanRange(*mapping, start, size)) {
+			regions[std::make_pair(start, size)].push_back(mapping);
+		}
+	}
+
+	for (auto const& region : regions) {
+		auto start = region.first.first;
+		auto size = region.first.second;
+		MultiPatternScanner scanner;
+		for (auto mapping : region.second) {
+			scanner.Add(mapping->Pattern);
+		}
+
+		auto scanStart = std::chrono::high_resolution_clock::now();
+		scanner.Scan(start, size);
+		auto scanTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - scanStart).count();
+		DEBUG("SymbolMapper::PrescanMappings(): Scanned %d patterns in %d KB region in %d us", 
+			(int)region.second.size(), (int)(size / 1024), (int)scanTime);
+
+		for (uint32_t i = 0; i < region.second.size(); i++) {
+			prescannedMatches_[region.second[i]] = PrescannedMatches{ scanner.GetMatches(i), false, false };
+			auto stats = GetStats(*region.second[i]);
+			if (stats != nullptr) {
+				stats->Candidates = scanner.GetCandidateCount(i);
+			}
+		}
+	}
+}
+
+uint64_t SymbolMapper::ComputeFingerprint() const
+{
+	// Modules are hashed in name order, so the fingerprint doesn't depend on hash map ordering
+	std::map<std::string, uint64_t> modules;
+	for (auto const& mod : modules_) {
+		modules.insert(std::make_pair(mod.first, mod.second.Fingerprint));
+	}
+
+	auto fingerprint = HashMix(SymbolMappingCache::Version, mappings_.Digest);
+	for (auto const& mod : modules) {
+		fingerprint = HashMulti(fingerprint, HashBytes(mod.first.data(), mod.first.size()), mod.second);
+	}
+
+	return fingerprint;
+}
+
+bool SymbolMapper::LoadCachedMatches(std::vector<SymbolMappings::Mapping*> const& mappings)
+{
+	if (cachePath_.empty() || mappings_.Digest == 0) {
+		return false;
+	}
+
+	auto fingerprint = ComputeFingerprint();
+	if (!cacheLoaded_) {
+		cacheLoaded_ = true;
+		if (!cache_.Load(cachePath_)) {
+			DEBUG("SymbolMapper::LoadCachedMatches(): No usable symbol cache found");
+			cache_.Reset(fingerprint);
+			return false;
+		}
+	}
+
+	if (cache_.GetFingerprint() != fingerprint) {
+		DEBUG("SymbolMapper::LoadCachedMatches(): Game executable or mappings changed; discarding symbol cache");
+		cache_.Reset(fingerprint);
+		return false;
+	}
+
+	// Validate every cached location before using any of them, so we can still fall back
+	// to a full scan without having executed mapping actions
+	std::unordered_map<SymbolMappings::Mapping const*, std::vector<uint8_t const*>> matches;
+	for (auto mapping : mappings) {
+		auto offsets = cache_.Get(mapping->Name);
+		if (offsets == nullptr) {
+			DEBUG("SymbolMapper::LoadCachedMatches(): No cache entry for mapping '%s'", mapping->Name.c_str());
+			return false;
+		}
+
+		uint8_t const* start;
+		std::size_t size;
+		if (!GetScanRange(*mapping, start, size)) {
+			return false;
+		}
+
+		auto moduleStart = modules_.find(mapping->Module)->second.ModuleStart;
+		auto& mappingMatches = matches[mapping];
+		for (auto offset : *offsets) {
+			auto match = moduleStart + offset;
+			if (match < start || match + mapping->Pattern.Size() >= start + size || !mapping->Pattern.MatchPattern(match)) {
+				WARN("SymbolMapper::LoadCachedMatches(): Cached location of mapping '%s' doesn't match; discarding symbol cache", mapping->Name.c_str());
+				cache_.Reset(fingerprint);
+				return false;
+			}
+
+			mappingMatches.push_back(match);
+		}
+	}
+
+	for (auto& mapping : matches) {
+		prescannedMatches_[mapping.first] = PrescannedMatches{ std::move(mapping.second), true, false };
+	}
+
+	return true;
+}
+
+void SymbolMapper::UpdateCache(std::vector<SymbolMappings::Mapping*> const& mappings)
+{
+	if (cachePath_.empty() || mappings_.Digest == 0) {
+		return;
+	}
+
+	bool changed{ false };
+	for (auto mapping : mappings) {
+		auto moduleIt = modules_.find(mapping->Module);
+		if (moduleIt == modules_.end()) continue;
+
+		SymbolMappingCache::MatchOffsets offsets;
+		auto accepted = acceptedMatches_.find(mapping);
+		if (accepted != acceptedMatches_.end()) {
+			for (auto match : accepted->second) {
+				offsets.push_back((uint32_t)(match - moduleIt->second.ModuleStart));
+			}
+		}
+
+		auto cached = cache_.Get(mapping->Name);
+		if (cached == nullptr || *cached != offsets) {
+			cache_.Set(mapping->Name, std::move(offsets));
+			changed = true;
+		}
+	}
+
+	if (changed) {
+		if (cache_.Save(cachePath_)) {
+			DEBUG("SymbolMapper::UpdateCache(): Symbol cache updated");
+		} else {
+			WARN("SymbolMapper::UpdateCache(): Failed to write symbol cache");
+		}
+	}
+}
+
+void SymbolMapper::SetCachePath(std::wstring const& path)
+{
+	cachePath_ = path;
+	cacheLoaded_ = false;
+}
+
+SymbolMapper::MappingStats* SymbolMapper::GetStats(SymbolMappings::Mapping const& mapping)
+{
+	auto it = mappingStatsIndex_.find(&mapping);
+	return (it != mappingStatsIndex_.end()) ? &mappingStats_[it->second] : nullptr;
+}
+
+bool SymbolMapper::MatchesConditions(SymbolMappings::Mapping const& mapping, uint8_t const* match)
+{
+	for (auto const& condition : mapping.Conditions) {
+		if (!EvaluateSymbolCondition(condition, match)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void SymbolMapper::ResolveConditions(std::vector<SymbolMappings::Mapping*> const& mappings)
+{
+	// Condition evaluation only reads game memory, so it can be done for independent mappings in parallel.
+	// Mapping actions (symbol writes, engine callbacks, chained NextSymbol mappings) are executed afterwards
+	// on the calling thread in mapping order, as they depend on the results of earlier mappings.
+	std::vector<std::pair<SymbolMappings::Mapping const*, PrescannedMatches*>> work;
+	for (auto mapping : mappings) {
+		auto prescanned = prescannedMatches_.find(mapping);
+		if (prescanned != prescannedMatches_.end() && !mapping->Conditions.empty()) {
+			work.push_back(std::make_pair(mapping, &prescanned->second));
+		}
+	}
+
+	std::atomic<std::size_t> nextItem{ 0 };
+	auto worker = [this, &work, &nextItem]() {
+		for (;;) {
+			auto index = nextItem++;
+			if (index >= work.size()) break;
+
+			auto startTime = std::chrono::high_resolution_clock::now();
+			auto mapping = work[index].first;
+			auto& matches = work[index].second->Matches;
+			matches.erase(std::remove_if(matches.begin(), matches.end(), [this, mapping](uint8_t const* match) {
+				return !MatchesConditions(*mapping, match);
+			}), matches.end());
+			work[index].second->ConditionsChecked = true;
+
+			// Stats entries are preallocated, each worker only writes the entries of its own mappings
+			auto stats = GetStats(*mapping);
+			if (stats != nullptr) {
+				stats->ResolveTime = std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::high_resolution_clock::now() - startTime).count();
+			}
+		}
+	};
+
+	auto numThreads = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), work.size());
+	if (numThreads <= 1) {
+		worker();
+	} else {
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < numThreads; i++) {
+			threads.emplace_back(worker);
+		}
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+}
+
 bool SymbolMapper::MapSymbol(std::string const& mappingName, uint8_t const* customStart, std::size_t customSize)
 {
 	auto mapping = mappings_.Mappings.find(mappingName);
@@ -852,21 +1316,7 @@ bool SymbolMapper::MapSymbol(SymbolMappings::Mapping & mapping, uint8_t const *
 	uint8_t const * memStart;
 	std::size_t memSize;
 
-	if (mapping.Scope == SymbolMappings::MatchScope::kBinary || mapping.Scope == SymbolMappings::MatchScope::kText) {
-		auto modIt = modules_.find(mapping.Module);
-		if (modIt == modules_.end()) {
-			ERR("Missing module data for module '%s'", mapping.Module.c_str());
-			return false;
-		}
-
-		if (mapping.Scope == SymbolMappings::MatchScope::kBinary) {
-			memStart = modIt->second.ModuleStart;
-			memSize = modIt->second.ModuleSize;
-		} else {
-			memStart = modIt->second.ModuleTextStart;
-			memSize = modIt->second.ModuleTextSize;
-		}
-	} else if (mapping.Scope == SymbolMappings::MatchScope::kCustom) {
+	if (mapping.Scope == SymbolMappings::MatchScope::kCustom) {
 		if (customStart == nullptr) {
 			ERR("Tried to apply custom mapping '%s' with a null custom range!", mapping.Name.c_str());
 			return false;
@@ -874,41 +1324,26 @@ bool SymbolMapper::MapSymbol(SymbolMappings::Mapping & mapping, uint8_t const *
 
 		memStart = customStart;
 		memSize = customSize;
-	} else {
-		ERR("Unknown mapping scope!");
+	} else if (!GetScanRange(mapping, memStart, memSize)) {
 		return false;
 	}
 
-#if defined(DEBUG_MAPPINGS)
-	DEBUG("Try mapping: %s [%p -> %p]", mapping.Name.c_str(), memStart, memStart + memSize);
-#endif
-
 	bool mapped = false,
 		hasMatches = false,
 		hasCallbacks = false;
-	mapping.Pattern.Scan(memStart, memSize, [this, &mapping, &mapped, &hasMatches, &hasCallbacks](const uint8_t * match) -> Pattern::ScanAction {
-		bool matching{ true };
-		for (auto const& condition : mapping.Conditions) {
-			if (!EvaluateSymbolCondition(condition, match)) {
-				matching = false;
-				break;
-			}
-		}
+	auto prescanned = prescannedMatches_.find(&mapping);
+	bool conditionsChecked = prescanned != prescannedMatches_.end() && prescanned->second.ConditionsChecked;
 
-		if (matching) {
-#if defined(DEBUG_MAPPINGS)
-			DEBUG("\tMatch: [%p]", match);
-#endif
+	auto onMatch = [this, &mapping, &mapped, &hasMatches, &hasCallbacks, &conditionsChecked](const uint8_t * match) -> Pattern::ScanAction {
+		if (conditionsChecked || MatchesConditions(mapping, match)) {
+			if (mapping.Scope != SymbolMappings::MatchScope::kCustom) {
+				acceptedMatches_[&mapping].push_back(match);
+			}
 
 			hasMatches = true;
 			auto patternAction{ Pattern::ScanAction::Finish };
 			for (auto const& target : mapping.Targets) {
 				auto action = ExecSymbolMappingAction(target, match);
-#if defined(DEBUG_MAPPINGS)
-				DEBUG("\tAction: %s", (action == MappingResult::Success) ? "Success"
-					: ((action == MappingResult::TryNext) ? "TryNext" : "Fail"));
-#endif
-
 				hasCallbacks = hasCallbacks || (action == MappingResult::Success) || (action == MappingResult::TryNext);
 				if (!mapped) {
 					mapped = (action == MappingResult::Success);
@@ -928,7 +1363,28 @@ bool SymbolMapper::MapSymbol(SymbolMappings::Mapping & mapping, uint8_t const *
 		} else {
 			return {};
 		}
-	});
+	};
+
+	if (prescanned != prescannedMatches_.end()) {
+		auto const& matches = prescanned->second.Matches;
+		for (auto match : matches) {
+			if (onMatch(match) == Pattern::ScanAction::Finish) break;
+		}
+
+		if (!mapped && prescanned->second.FromCache) {
+			WARN("Cached matches of mapping '%s' were not accepted; scanning for new matches", mapping.Name.c_str());
+			conditionsChecked = false;
+			mapping.Pattern.Scan(memStart, memSize, [&onMatch, &matches](const uint8_t* match) {
+				if (std::find(matches.begin(), matches.end(), match) != matches.end()) {
+					return Pattern::ScanAction::Continue;
+				}
+
+				return onMatch(match);
+			});
+		}
+	} else {
+		mapping.Pattern.Scan(memStart, memSize, onMatch);
+	}
 
 	if (!mapped) {
 		if (!hasMatches) {
@@ -1078,6 +1534,19 @@ bool SymbolMapper::AddModule(std::string const& name, std::wstring const& modNam
 		}
 	}
 
+	// The PE headers contain the link timestamp, checksum and section layout of the image
+	uint64_t fileSize{ 0 }, writeTime{ 0 };
+	wchar_t modulePath[MAX_PATH];
+	WIN32_FILE_ATTRIBUTE_DATA fileInfo;
+	if (GetModuleFileNameW(hLib, modulePath, MAX_PATH) > 0
+		&& GetFileAttributesExW(modulePath, GetFileExInfoStandard, &fileInfo)) {
+		fileSize = ((uint64_t)fileInfo.nFileSizeHigh << 32) | fileInfo.nFileSizeLow;
+		writeTime = ((uint64_t)fileInfo.ftLastWriteTime.dwHighDateTime << 32) | fileInfo.ftLastWriteTime.dwLowDateTime;
+	}
+
+	modInfo.Fingerprint = HashMulti(fileSize, writeTime, 
+		HashBytes(modInfo.ModuleStart, pNtHdr->OptionalHeader.SizeOfHeaders));
+
 	modules_.insert(std::make_pair(name, modInfo));
 	return true;
 }
@@ -1089,13 +1558,61 @@ void SymbolMapper::AddEngineCallback(std::string const& name, std::function<Mapp
 
 void SymbolMapper::MapAllSymbols(bool deferred)
 {
+	std::vector<SymbolMappings::Mapping*> mappings;
 	for (auto mapping : mappings_.OrderedMappings) {
 		if (mapping->Scope != SymbolMappings::MatchScope::kCustom
 			&& deferred == ((mapping->Flag & SymbolMappings::Mapping::kDeferred) != 0)) {
-			MapSymbol(*mapping, nullptr, 0);
+			mappings.push_back(mapping);
 		}
 	}
 
+	auto statsOffset = mappingStats_.size();
+	for (auto mapping : mappings) {
+		mappingStatsIndex_[mapping] = mappingStats_.size();
+		mappingStats_.push_back(MappingStats{ mapping });
+	}
+
+	auto scanStart = std::chrono::high_resolution_clock::now();
+	bool cached = LoadCachedMatches(mappings);
+	if (!cached) {
+		PrescanMappings(mappings);
+	}
+
+	ResolveConditions(mappings);
+
+	for (auto mapping : mappings) {
+		auto applyStart = std::chrono::high_resolution_clock::now();
+		MapSymbol(*mapping, nullptr, 0);
+		auto stats = GetStats(*mapping);
+		stats->ApplyTime = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::high_resolution_clock::now() - applyStart).count();
+		auto accepted = acceptedMatches_.find(mapping);
+		stats->Matches = (accepted != acceptedMatches_.end()) ? (uint32_t)accepted->second.size() : 0;
+	}
+
+	auto scanTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - scanStart).count();
+	DEBUG("SymbolMapper::MapAllSymbols(): Mapped %d symbols in %d ms (%s)", (int)mappings.size(), (int)scanTime,
+		cached ? "cached" : "full scan");
+
+	// Report the mappings that dominate mapping time
+	std::vector<MappingStats const*> slowest;
+	for (auto i = statsOffset; i < mappingStats_.size(); i++) {
+		slowest.push_back(&mappingStats_[i]);
+	}
+
+	std::sort(slowest.begin(), slowest.end(), [](MappingStats const* a, MappingStats const* b) {
+		return (a->ResolveTime + a->ApplyTime) > (b->ResolveTime + b->ApplyTime);
+	});
+
+	for (std::size_t i = 0; i < std::min<std::size_t>(slowest.size(), 5); i++) {
+		DEBUG("\t%s: %d candidates, %d matches, resolve %d us, apply %d us", slowest[i]->Mapping->Name.c_str(),
+			(int)slowest[i]->Candidates, (int)slowest[i]->Matches, (int)slowest[i]->ResolveTime, (int)slowest[i]->ApplyTime);
+	}
+
+	UpdateCache(mappings);
+	prescannedMatches_.clear();
+	acceptedMatches_.clear();
+
 	if (!deferred) {
 		for (auto const& imp : mappings_.DllImports) {
 			MapDllImport(imp.second);
@@ -52,7 +52,16 @@ struct Pattern
 	void Scan(uint8_t const * start, size_t length, std::function<ScanAction (uint8_t const *)> callback) const;
 	std::optional<uint32_t> GetAnchor(char const* anchor) const;
 
+	inline std::size_t Size() const
+	{
+		return pattern_.size();
+	}
+
+	bool MatchPattern(uint8_t const * start) const;
+
 private:
+	friend class MultiPatternScanner;
+
 	struct PatternByte
 	{
 		uint8_t pattern;
@@ -62,12 +71,54 @@ private:
 	std::vector<PatternByte> pattern_;
 	std::unordered_map<std::string, uint32_t> anchors_;
 
-	bool MatchPattern(uint8_t const * start) const;
 	void ScanPrefix1(uint8_t const * start, uint8_t const * end, std::function<ScanAction (uint8_t const *)> callback) const;
 	void ScanPrefix2(uint8_t const * start, uint8_t const * end, std::function<ScanAction (uint8_t const *)> callback) const;
 	void ScanPrefix4(uint8_t const * start, uint8_t const * end, std::function<ScanAction (uint8_t const *)> callback) const;
 };
 
+// Finds all matches of multiple patterns in a single pass over a memory region.
+// Candidate patterns are selected using the first two bytes at each position, so the cost of a scan
+// depends on the size of the region and the number of candidates, not the number of patterns.
+// Large regions are split into chunks that are scanned in parallel; matches may extend past the end of a chunk.
+class MultiPatternScanner
+{
+public:
+	using PatternId = uint32_t;
+
+	PatternId Add(Pattern const& pattern);
+	void Scan(uint8_t const* start, std::size_t length, uint32_t numThreads = 0);
+
+	// Matches of the pattern in ascending address order
+	inline std::vector<uint8_t const*> const& GetMatches(PatternId id) const
+	{
+		return matches_[id];
+	}
+
+	// Number of positions where the full pattern had to be compared; indicates the scan cost of the pattern
+	inline uint64_t GetCandidateCount(PatternId id) const
+	{
+		return candidates_[id];
+	}
+
+private:
+	static constexpr uint32_t NumPrefixes = 0x10000;
+	static constexpr std::size_t MinChunkSize = 0x100000;
+
+	using MatchList = std::vector<std::pair<PatternId, uint8_t const*>>;
+
+	std::vector<Pattern const*> patterns_;
+	std::vector<std::vector<uint8_t const*>> matches_;
+	std::vector<uint64_t> candidates_;
+	// Patterns grouped by the 16-bit little-endian prefix they can start with;
+	// patterns of prefix P are prefixPatterns_[prefixOffsets_[P] .. prefixOffsets_[P + 1]]
+	std::vector<uint32_t> prefixOffsets_;
+	std::vector<PatternId> prefixPatterns_;
+
+	void BuildPrefixTable();
+	void ScanChunk(uint8_t const* chunkStart, uint8_t const* chunkEnd, uint8_t const* regionEnd, 
+		MatchList& matches, std::vector<uint64_t>& candidates) const;
+};
+
 uint8_t const * AsmResolveInstructionRef(uint8_t const * code);
 
 struct StaticSymbolRef
@@ -207,6 +258,8 @@ struct SymbolMappings
 	std::vector<Mapping*> OrderedMappings;
 	std::unordered_map<std::string, DllImport> DllImports;
 	std::unordered_map<std::string, StaticSymbol> StaticSymbols;
+	// Hash of the mapping table; 0 if unknown
+	uint64_t Digest{ 0 };
 };
 
 class SymbolMappingLoader
@@ -234,6 +287,35 @@ private:
 	bool LoadCondition(tinyxml2::XMLElement* ele, Pattern const& pattern, SymbolMappings::Condition& condition);
 };
 
+// Match locations of symbol mappings saved from a previous launch.
+// Entries are only used if the fingerprint (game executable + mapping table) is unchanged,
+// and each cached location is still validated against the pattern of the mapping before use.
+class SymbolMappingCache
+{
+public:
+	// Match offsets relative to the start of the module of the mapping
+	using MatchOffsets = std::vector<uint32_t>;
+
+	static constexpr uint32_t Magic = 0x43534D53; // "SMSC"
+	static constexpr uint32_t Version = 1;
+
+	inline uint64_t GetFingerprint() const
+	{
+		return fingerprint_;
+	}
+
+	void Reset(uint64_t fingerprint);
+	MatchOffsets const* Get(std::string const& mapping) const;
+	void Set(std::string const& mapping, MatchOffsets&& offsets);
+
+	bool Load(std::wstring const& path);
+	bool Save(std::wstring const& path) const;
+
+private:
+	uint64_t fingerprint_{ 0 };
+	std::unordered_map<std::string, MatchOffsets> matches_;
+};
+
 class SymbolMapper
 {
 public:
@@ -244,12 +326,27 @@ public:
 		TryNext
 	};
 
+	struct MappingStats
+	{
+		SymbolMappings::Mapping const* Mapping{ nullptr };
+		// Number of full pattern comparisons during the multi-pattern scan
+		uint64_t Candidates{ 0 };
+		// Number of matches that passed the conditions of the mapping
+		uint32_t Matches{ 0 };
+		// Time spent evaluating conditions on a worker thread, in microseconds
+		uint64_t ResolveTime{ 0 };
+		// Time spent executing mapping actions (including chained NextSymbol mappings), in microseconds
+		uint64_t ApplyTime{ 0 };
+	};
+
 	struct ModuleInfo
 	{
 		uint8_t const* ModuleStart{ nullptr };
 		size_t ModuleSize{ 0 };
 		uint8_t const* ModuleTextStart{ nullptr };
 		size_t ModuleTextSize{ 0 };
+		// Hash of the module file size, timestamp and PE headers
+		uint64_t Fingerprint{ 0 };
 	};
 
 	inline SymbolMapper(SymbolMappings& mappings)
@@ -261,7 +358,12 @@ public:
 	void MapAllSymbols(bool deferred);
 	bool MapSymbol(std::string const& mappingName, uint8_t const* customStart, std::size_t customSize);
 	bool MapSymbol(SymbolMappings::Mapping& mapping, uint8_t const* customStart, std::size_t customSize);
+	// Finds the matches of all specified mappings in a single pass per module region;
+	// subsequent MapSymbol() calls for these mappings use the precomputed matches
+	void PrescanMappings(std::vector<SymbolMappings::Mapping*> const& mappings);
 	bool MapDllImport(SymbolMappings::DllImport const& imp);
+	// Enables caching the match locations of mappings in the specified file
+	void SetCachePath(std::wstring const& path);
 
 	inline bool HasFailedCriticalMappings() const
 	{
@@ -278,14 +380,45 @@ public:
 		return modules_;
 	}
 
+	// Statistics of the mappings processed by MapAllSymbols()
+	inline std::vector<MappingStats> const& GetMappingStats() const
+	{
+		return mappingStats_;
+	}
+
 private:
+	struct PrescannedMatches
+	{
+		std::vector<uint8_t const*> Matches;
+		// Matches loaded from the cache only contain the matches that were accepted on the last launch,
+		// not every match of the pattern
+		bool FromCache{ false };
+		// Conditions were already evaluated and non-matching entries removed
+		bool ConditionsChecked{ false };
+	};
+
 	SymbolMappings& mappings_;
 	std::unordered_map<std::string, ModuleInfo> modules_;
 	std::unordered_map<std::string, std::function<MappingResult(uint8_t const*)>> engineCallbacks_;
+	std::unordered_map<SymbolMappings::Mapping const*, PrescannedMatches> prescannedMatches_;
+	// Matches that passed the conditions of the mapping, in the order they were processed
+	std::unordered_map<SymbolMappings::Mapping const*, std::vector<uint8_t const*>> acceptedMatches_;
+	std::wstring cachePath_;
+	SymbolMappingCache cache_;
+	bool cacheLoaded_{ false };
+	std::vector<MappingStats> mappingStats_;
+	std::unordered_map<SymbolMappings::Mapping const*, std::size_t> mappingStatsIndex_;
 	uint32_t gameRevision_;
 	bool hasFailedMappings_{ false };
 	bool hasFailedCriticalMappings_{ false };
 
+	bool GetScanRange(SymbolMappings::Mapping const& mapping, uint8_t const*& start, std::size_t& size) const;
+	uint64_t ComputeFingerprint() const;
+	bool LoadCachedMatches(std::vector<SymbolMappings::Mapping*> const& mappings);
+	void UpdateCache(std::vector<SymbolMappings::Mapping*> const& mappings);
+	MappingStats* GetStats(SymbolMappings::Mapping const& mapping);
+	void ResolveConditions(std::vector<SymbolMappings::Mapping*> const& mappings);
+	bool MatchesConditions(SymbolMappings::Mapping const& mapping, uint8_t const* match);
 	bool IsValidModulePtr(uint8_t const* ref) const;
 	bool IsConstStringRef(uint8_t const* ref, char const* str) const;
 	bool IsConstWStringRef(uint8_t const* ref, wchar_t const* str) const;